@@ -0,0 +1,11 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Heap allocations made through the global operator new by every thread so far.
+// Kept in its own translation unit so the replaced operators are never inlined into callers.
+// The profiling build replaces operator new itself; use Profiler::threadAllocations() there.
+uint64_t processAllocations();
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,532 @@
+// Microbenchmarks for the render and load paths.
+//
+// Results are machine-readable with Google Benchmark's own flags, e.g.
+//   tansen_bench --benchmark_format=json > results.json
+//   tansen_bench --benchmark_out=results.json --benchmark_out_format=json
+
+#include "AllocationCounter.h"
+#include "AudioRenderer.h"
+#include "BatchRenderer.h"
+#include "BinaryCatalog.h"
+#include "CommandExecutor.h"
+#include "CommandParser.h"
+#include "CompositionGenerator.h"
+#include "CycleCache.h"
+#include "EventTimeline.h"
+#include "MIDIHandler.h"
+#include "MidiEncoding.h"
+#include "MidiFileWriter.h"
+#include "Profiler.h"
+#include "RenderContext.h"
+#include "TaalManager.h"
+#include "Tempo.h"
+#include "TempoMap.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unistd.h>
+
+#ifndef TANSEN_DATA_DIR
+#define TANSEN_DATA_DIR "data"
+#endif
+
+
+namespace {
+    // Heap allocations so far: process-wide, or by this thread in the profiling build
+    uint64_t allocations() {
+#ifdef TANSEN_ENABLE_PROFILING
+        return Profiler::threadAllocations();
+#else
+        return processAllocations();
+#endif
+    }
+
+    TaalManager* catalog = nullptr; // The shipped catalog, loaded by main()
+
+    // Discards output but stays seekable, so MidiFileWriter can backpatch track lengths
+    class NullBuffer : public std::streambuf {
+    protected:
+        int_type overflow(int_type c) override {
+            ++position;
+            return traits_type::not_eof(c);
+        }
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            position += count;
+            return count;
+        }
+        pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode) override {
+            if (dir == std::ios_base::beg) {
+                return pos_type(offset);
+            }
+            return pos_type(dir == std::ios_base::cur && offset == 0 ? position : position + offset);
+        }
+        pos_type seekpos(pos_type pos, std::ios_base::openmode) override {
+            return pos;
+        }
+
+    private:
+        off_type position = 0;
+    };
+
+    std::filesystem::path scratchDirectory() {
+        static const std::filesystem::path directory = [] {
+            auto path = std::filesystem::temp_directory_path() / ("tansen_bench." + std::to_string(getpid()));
+            std::filesystem::create_directories(path);
+            return path;
+        }();
+        return directory;
+    }
+
+    const std::string& talsPath() {
+        static const std::string path = std::string(TANSEN_DATA_DIR) + "/tals.json";
+        return path;
+    }
+
+    // A catalog of `count` taals, cycling through common theka shapes
+    std::string syntheticCatalog(int64_t count) {
+        auto path = scratchDirectory() / ("synthetic_" + std::to_string(count) + ".json");
+        if (std::filesystem::exists(path)) {
+            return path.string();
+        }
+
+        static const char* const bols[] = {"Dha", "Dhin", "Na", "Ti", "Ge", "Ka", "Ta", "Tin"};
+        std::ofstream out(path);
+        out << "{\n  \"synthetic\": {\n";
+        for (int64_t i = 0; i < count; ++i) {
+            int beats = 6 + static_cast<int>(i % 11);
+            out << "    \"Taal" << i << "\": {\"beats\": " << beats << ", \"bols\": [";
+            for (int b = 0; b < beats; ++b) {
+                out << (b ? ", " : "") << '"' << bols[(i + b) % 8] << '"';
+            }
+            out << "]}" << (i + 1 < count ? ",\n" : "\n");
+        }
+        out << "  }\n}\n";
+        return path.string();
+    }
+
+    std::string compiledCatalog(int64_t count) {
+        auto path = scratchDirectory() /
+                    ("synthetic_" + std::to_string(count) + "_v" + std::to_string(BinaryCatalog::kVersion) + ".bin");
+        if (!std::filesystem::exists(path)) {
+            BinaryCatalog::compile(syntheticCatalog(count), path.string());
+        }
+        return path.string();
+    }
+
+    // Values at the edges of each VLQ length (1-4 bytes)
+    void BM_WriteVarLen(benchmark::State& state) {
+        NullBuffer sink;
+        std::ostream out(&sink);
+        MidiFileWriter writer(out, 0, 1);
+        writer.beginTrack();
+        uint32_t value = static_cast<uint32_t>(state.range(0));
+        for (auto _ : state) {
+            writer.writeVarLen(value);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_WriteVarLen)->Arg(0x40)->Arg(0x2000)->Arg(0x100000)->Arg(0x0FFFFFFF);
+
+    void BM_WriteNoteEvent(benchmark::State& state) {
+        NullBuffer sink;
+        std::ostream out(&sink);
+        MidiFileWriter writer(out, 0, 1);
+        writer.beginTrack();
+        bool on = true;
+        for (auto _ : state) {
+            writer.writeNoteEvent(on ? 0 : 480, 9, 38, 80, on);
+            on = !on;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_WriteNoteEvent);
+
+    // A dense laykari cycle's worth of note pairs with mixed delta lengths
+    std::vector<ChannelEvent> denseEvents(std::size_t count) {
+        std::vector<ChannelEvent> events(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            uint32_t delta = i % 2 == 0 ? 0 : (i % 7 == 1 ? 16800 : 105);
+            events[i] = {delta, static_cast<uint8_t>(i % 2 == 0 ? 0x99 : 0x89), 38, 80};
+        }
+        return events;
+    }
+
+    void BM_EncodeEvents(benchmark::State& state) {
+        std::vector<ChannelEvent> events = denseEvents(static_cast<std::size_t>(state.range(0)));
+        std::vector<uint8_t> out(encodedSizeBound(events.size()));
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(encodeEvents(events.data(), events.size(), out.data()));
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_EncodeEvents)->Arg(64)->Arg(4096);
+
+    void BM_WriteEvents(benchmark::State& state) {
+        std::vector<ChannelEvent> events = denseEvents(static_cast<std::size_t>(state.range(0)));
+        NullBuffer sink;
+        std::ostream out(&sink);
+        MidiFileWriter writer(out, 0, 1);
+        writer.beginTrack();
+        for (auto _ : state) {
+            writer.writeEvents(events.data(), events.size());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_WriteEvents)->Arg(4096);
+
+    // Three interleaved instruments appended one after another, sorted by tick and encoded with running status
+    void BM_TimelineSortEncode(benchmark::State& state) {
+        const std::size_t count = static_cast<std::size_t>(state.range(0));
+        EventTimeline timeline;
+        std::vector<uint8_t> out(encodedSizeBound(count));
+        for (auto _ : state) {
+            timeline.clear();
+            for (uint8_t channel = 0; channel < 3; ++channel) {
+                for (std::size_t i = channel; i < count; i += 3) {
+                    timeline.append(i / 6 * 240, static_cast<uint8_t>((i % 2 ? 0x80 : 0x90) | channel), 38, 80);
+                }
+            }
+            timeline.sort();
+            uint64_t lastTick = 0;
+            uint8_t status = 0;
+            benchmark::DoNotOptimize(timeline.encode(0, timeline.size(), lastTick, true, status, out.data()));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_TimelineSortEncode)->Arg(4096);
+
+    // Note On/Off pairs on channels 0 and 1, off the 120-tick grid by up to 59 ticks, plus a
+    // controller on channel 0 that every pass must leave alone
+    void fillPassTimeline(EventTimeline& timeline, std::size_t count) {
+        timeline.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            uint64_t tick = i / 2 * 120 + (i * 37) % 60;
+            uint8_t channel = static_cast<uint8_t>(i / 2 % 2);
+            if (i % 16 == 15) {
+                timeline.append(tick, 0xB0, 7, 100);
+            } else {
+                timeline.append(tick, static_cast<uint8_t>((i % 2 ? 0x80 : 0x90) | channel), static_cast<uint8_t>(i % 128), 100);
+            }
+        }
+    }
+
+    // quantize, transpose and accent, checked event by event against their documented effect
+    bool timelinePassesCorrect(std::size_t count) {
+        EventTimeline original;
+        fillPassTimeline(original, count);
+        EventTimeline timeline;
+        fillPassTimeline(timeline, count);
+        timeline.quantize(120);
+        timeline.transpose(1, 12);
+        timeline.accent(480, 40);
+        for (std::size_t i = 0; i < count; ++i) {
+            MidiEvent before = original.at(i);
+            MidiEvent after = timeline.at(i);
+            uint64_t tick = (before.tick + 60) / 120 * 120;
+            bool noteOnChannel1 = (before.status & 0xEF) == 0x81;
+            uint8_t note = noteOnChannel1 ? static_cast<uint8_t>(std::min(before.data1 + 12, 127)) : before.data1;
+            bool accented = (before.status & 0xF0) == 0x90 && tick % 480 == 0;
+            uint8_t velocity = accented ? static_cast<uint8_t>(std::min(before.data2 + 40, 127)) : before.data2;
+            if (after.tick != tick || after.status != before.status || after.data1 != note || after.data2 != velocity) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // The whole-timeline passes, run back to back over one window of events
+    void BM_TimelinePasses(benchmark::State& state) {
+        const std::size_t count = static_cast<std::size_t>(state.range(0));
+        if (!timelinePassesCorrect(count)) {
+            state.SkipWithError("Timeline passes changed the wrong events");
+            return;
+        }
+        EventTimeline timeline;
+        fillPassTimeline(timeline, count);
+        for (auto _ : state) {
+            timeline.quantize(120);
+            timeline.transpose(1, 1);
+            timeline.accent(480, 1);
+            benchmark::ClobberMemory();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_TimelinePasses)->Arg(4096);
+
+    // Full render of one taal to a file; generateTaalMIDI is this plus a console line.
+    // range(0) is the cycle count, range(1) nonzero to start every render with a cold cycle cache.
+    void BM_GenerateTaalMIDI(benchmark::State& state, const Taal& taal) {
+        MIDIHandler midiHandler;
+        Tempo tempo = Tempo::fromName("Madhya");
+        RenderOptions options;
+        options.cycles = static_cast<uint64_t>(state.range(0));
+        bool cold = state.range(1) != 0;
+        std::string path = (scratchDirectory() / (taal.name + ".mid")).string();
+
+        for (auto _ : state) {
+            if (cold) {
+                CycleCache::shared().clear();
+            }
+            midiHandler.writeTaalMIDI(taal, tempo, "Yaman", path, options);
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(std::filesystem::file_size(path)));
+    }
+
+    void BM_LoadTaalsJson(benchmark::State& state) {
+        std::string path = syntheticCatalog(state.range(0));
+        for (auto _ : state) {
+            TaalManager taalManager;
+            taalManager.loadTaals(path);
+            benchmark::DoNotOptimize(taalManager.getTaal("Taal0"));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_LoadTaalsJson)->RangeMultiplier(10)->Range(100, 1000000)->Unit(benchmark::kMillisecond);
+
+    void BM_LoadTaalsCatalog(benchmark::State& state) {
+        std::string path = compiledCatalog(state.range(0));
+        for (auto _ : state) {
+            TaalManager taalManager;
+            taalManager.loadTaals(path);
+            benchmark::DoNotOptimize(taalManager.getTaal("Taal0"));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_LoadTaalsCatalog)->RangeMultiplier(10)->Range(100, 1000000)->Unit(benchmark::kMicrosecond);
+
+    // One lookup through the catalog's perfect-hash name index: qualified (0) or bare, differently cased (1)
+    void BM_LookupTaalCatalog(benchmark::State& state) {
+        TaalManager taalManager;
+        taalManager.loadTaals(compiledCatalog(state.range(0)));
+        std::string index = std::to_string(state.range(0) / 2);
+        std::string name = state.range(1) ? "TAAL" + index : "synthetic/Taal" + index;
+        taalManager.getTaal(name); // Decode once
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(taalManager.getTaal(name));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+    BENCHMARK(BM_LookupTaalCatalog)->ArgsProduct({{100, 10000, 1000000}, {0, 1}});
+
+    // Steady-state renders must not touch the heap once the context and output are warm.
+    // Fails the benchmark (and so any pipeline gating on it) if one does.
+    void BM_RenderSteadyState(benchmark::State& state) {
+        MIDIHandler midiHandler;
+        RenderContext context;
+        std::vector<uint8_t> midiData;
+        const Taal& taal = catalog->getTaal("Teentaal");
+        Tempo tempo = Tempo::fromName("Drut");
+        RenderOptions options;
+        options.cycles = static_cast<uint64_t>(state.range(0));
+        bool toFile = state.range(1) != 0;
+        std::string path = (scratchDirectory() / "steady.mid").string();
+
+        auto render = [&] {
+            if (toFile) {
+                midiHandler.writeTaalMIDI(taal, tempo, "Yaman", path, options, context);
+            } else {
+                midiHandler.renderTaalMIDI(taal, tempo, "Yaman", options, context, midiData);
+            }
+        };
+        render(); // Warm-up: cycle cache, arena, output capacity
+        render();
+
+        uint64_t allocated = 0;
+        for (auto _ : state) {
+            uint64_t before = allocations();
+            render();
+            allocated += allocations() - before;
+        }
+        state.counters["allocations_per_render"] = static_cast<double>(allocated) / state.iterations();
+        if (allocated != 0) {
+            state.SkipWithError("Steady-state render allocated");
+        }
+    }
+    BENCHMARK(BM_RenderSteadyState)->ArgsProduct({{16, 4096}, {0, 1}});
+
+    // A server session: parse a request line and render it inline
+    void BM_SessionSteadyState(benchmark::State& state) {
+        MIDIHandler midiHandler;
+        CommandExecutor executor(*catalog, midiHandler, true);
+        std::string line = "Raag Yaman Taal Jhaptaal Tempo Madhya";
+        Command command;
+        CommandResult result;
+        for (int i = 0; i < 2; ++i) {
+            parseCommand(line, command);
+            executor.execute(command, result);
+        }
+
+        uint64_t allocated = 0;
+        for (auto _ : state) {
+            uint64_t before = allocations();
+            parseCommand(line, command);
+            executor.execute(command, result);
+            allocated += allocations() - before;
+        }
+        state.counters["allocations_per_request"] = static_cast<double>(allocated) / state.iterations();
+        if (allocated != 0) {
+            state.SkipWithError("Steady-state request allocated");
+        }
+    }
+    BENCHMARK(BM_SessionSteadyState);
+
+    // Script-mode parsing on several threads at once; each thread reuses its syntax, so none allocates
+    void BM_ParseCommandSyntax(benchmark::State& state) {
+        const std::string_view lines[] = {
+            "Raag Yaman Taal Jhaptaal Tempo Madhya Output out/yaman.mid",
+            "set tempo Madhya>Drut:exp",
+            "add taal Chautaal 12 Dha Dha Din Ta Kit Dha Din Ta Tita Kata Gadi Gana",
+            "list taals",
+        };
+        CommandSyntax syntax;
+        parseCommandSyntax(lines[2], syntax);
+
+        uint64_t allocated = 0;
+        std::size_t next = 0;
+        for (auto _ : state) {
+            uint64_t before = allocations();
+            parseCommandSyntax(lines[next], syntax);
+            allocated += allocations() - before;
+            benchmark::DoNotOptimize(syntax.bols.data());
+            next = (next + 1) % std::size(lines);
+        }
+        state.SetItemsProcessed(state.iterations());
+        if (allocated != 0) {
+            state.SkipWithError("Parsing allocated");
+        }
+    }
+    BENCHMARK(BM_ParseCommandSyntax)->ThreadRange(1, 4);
+
+    // One minute of tabla, tanpura and lehra at 48 kHz; the argument is the segment renderer count
+    void BM_RenderAudio(benchmark::State& state) {
+        MIDIHandler midiHandler;
+        AudioOptions audioOptions;
+        audioOptions.threads = static_cast<unsigned>(state.range(0));
+        AudioRenderer renderer(midiHandler, audioOptions);
+        RenderOptions options;
+        options.durationSeconds = 60.0;
+        options.tanpura = true;
+        options.lehra = true;
+        const Taal& taal = catalog->getTaal("Teentaal");
+        Tempo tempo = Tempo::fromName("Madhya");
+
+        NullBuffer buffer;
+        std::ostream out(&buffer);
+        double audioSeconds = 0.0;
+        for (auto _ : state) {
+            audioSeconds += renderer.renderTaalWAV(taal, tempo, "Yaman", options, out).audioSeconds;
+        }
+        state.counters["audio_seconds_per_second"] = benchmark::Counter(audioSeconds, benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(BM_RenderAudio)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+    // Tempo events for an hour accelerating from 60 to 240 BPM at 480 PPQN, and tick -> seconds over it
+    void BM_TempoMap(benchmark::State& state) {
+        const uint64_t span = 9000 * 480;
+        TempoMap tempoMap({{0, 60.0}, {span / 2, 120.0}, {span, 240.0}}, TempoRamp::Exponential, 480);
+        std::size_t events = 0;
+        double seconds = 0.0;
+        for (auto _ : state) {
+            events = tempoMap.tempoChanges(span, 0.001).size();
+            for (uint64_t tick = 0; tick < span; tick += 120) {
+                seconds += tempoMap.secondsAt(tick);
+            }
+        }
+        benchmark::DoNotOptimize(seconds);
+        state.counters["tempo_events"] = static_cast<double>(events);
+    }
+    BENCHMARK(BM_TempoMap)->Unit(benchmark::kMillisecond);
+
+    // Tables and ranked search for the 500 best Teentaal compositions; the argument is the laykari density
+    void BM_ComposeTihais(benchmark::State& state) {
+        CompositionOptions options;
+        options.laykari.density = static_cast<unsigned>(state.range(0));
+        options.limit = 500;
+        const Taal& taal = catalog->getTaal("Teentaal");
+        std::size_t composed = 0;
+        for (auto _ : state) {
+            composed += CompositionGenerator(taal, options).generate().size();
+        }
+        state.counters["compositions_per_second"] = benchmark::Counter(static_cast<double>(composed),
+                                                                       benchmark::Counter::kIsRate);
+    }
+    BENCHMARK(BM_ComposeTihais)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
+
+#ifndef TANSEN_ENABLE_PROFILING
+    // Whole batches, thread start-up and bookkeeping included; reported, not asserted
+    void BM_BatchAllocations(benchmark::State& state) {
+        MIDIHandler midiHandler;
+        BatchRenderer renderer(*catalog, midiHandler, 4);
+        std::vector<BatchJob> jobs(static_cast<std::size_t>(state.range(0)));
+        for (std::size_t i = 0; i < jobs.size(); ++i) {
+            jobs[i] = {"Yaman", i % 2 ? "Teentaal" : "Ektaal", "Madhya",
+                       (scratchDirectory() / "batch" / (std::to_string(i % 64) + ".mid")).string(), i + 1};
+        }
+        renderer.run(jobs);
+
+        uint64_t allocated = 0;
+        for (auto _ : state) {
+            uint64_t before = allocations();
+            benchmark::DoNotOptimize(renderer.run(jobs));
+            allocated += allocations() - before;
+        }
+        state.counters["allocations_per_job"] = static_cast<double>(allocated) / (state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_BatchAllocations)->Arg(256)->Arg(4096)->Unit(benchmark::kMillisecond);
+#endif
+
+#ifdef TANSEN_CLI_PATH
+    // Whole process: start-up, catalog load and a batch of renders
+    void BM_CliBatch(benchmark::State& state) {
+        auto manifest = scratchDirectory() / "manifest.txt";
+        {
+            std::ofstream out(manifest);
+            for (int64_t i = 0; i < state.range(0); ++i) {
+                out << "Yaman Teentaal Madhya " << (scratchDirectory() / "cli" / (std::to_string(i) + ".mid")).string() << '\n';
+            }
+        }
+        std::string command = std::string("\"") + TANSEN_CLI_PATH + "\" batch \"" + manifest.string() +
+                              "\" --catalog \"" + talsPath() + "\" > /dev/null 2>&1";
+        for (auto _ : state) {
+            if (std::system(command.c_str()) != 0) {
+                state.SkipWithError("Tansen batch failed");
+                break;
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_CliBatch)->Arg(1)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+}
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    // One render benchmark per taal in the shipped catalog
+    static TaalManager taalManager;
+    taalManager.loadTaals(talsPath());
+    catalog = &taalManager;
+    for (const std::string& name : taalManager.listTaalNames()) {
+        const Taal& taal = taalManager.getTaal(name);
+        benchmark::RegisterBenchmark(("BM_GenerateTaalMIDI/" + name).c_str(), BM_GenerateTaalMIDI, taal)
+            ->ArgsProduct({{4, 1024}, {0, 1}});
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    std::filesystem::remove_all(scratchDirectory());
+    return 0;
+}
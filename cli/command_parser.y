@@ -1,63 +1,189 @@
-#include "TaalManager.h"
-#include "MIDIHandler.h"
-#include "Tempo.h"
-#include <iostream>
-#include <stdexcept>
+/*
+ * Grammar of the command language (see parseCommandSyntax in CommandParser.h).
+ *
+ * The parser is pure and the scanner below is a cursor over the line, so all state is on
+ * the caller's stack: any number of threads may parse at once. Tokens are views into the
+ * line; nothing is copied or allocated unless the command is rejected.
+ */
 
-// External declarations from parser
-extern std::string parsedRaag;
-extern std::string parsedTaal;
-extern std::string parsedTempo;
-extern int yyparse();
+%require "3.6"
+%define api.pure full
+%define api.prefix {cmd}
+%define api.value.type {std::string_view}
+%define parse.error custom
+%param {CommandScanner* scanner}
+%parse-param {CommandSyntax* syntax}
 
-int main() {
-    TaalManager taalManager;
-    MIDIHandler midiHandler;
+%code requires {
+#include <string_view>
 
-    // Load Taals
-    try {
-        taalManager.loadTaals("data/taals.json");
-    } catch (const std::exception& e) {
-        std::cerr << "Error loading taals: " << e.what() << std::endl;
-        return 1;
-    }
+struct CommandScanner;
+struct CommandSyntax;
+}
 
-    // Display available Taals
-    std::cout << "Available Taals:" << std::endl;
-    taalManager.listAllTaals();
+%code {
+#include "CommandParser.h"
+#include <cctype>
+#include <stdexcept>
+#include <string>
 
-    // Prompt for user input
-    std::cout << "Enter your command (e.g., 'Raag Bhairavi Taal Keherwa Bilambit'): ";
+// Cursor over one command line
+struct CommandScanner {
+    std::string_view line;
+    std::size_t position = 0;
+    std::string_view previous; // Token before the current one, for error messages
+    std::string_view current;
+    bool first = true;
+    bool generate = false;     // The command started with 'Raag'
+    std::string error;
+};
 
-    // Parse the user input
-    if (yyparse() != 0) {
-        std::cerr << "Error: Failed to parse the command. Please check the syntax." << std::endl;
-        return 1;
+namespace {
+    bool isSpace(char c) {
+        return std::isspace(static_cast<unsigned char>(c)) != 0;
     }
 
-    // Validate parsed values
-    if (!taalManager.isTaalAvailable(parsedTaal)) {
-        std::cerr << "Error: Taal '" << parsedTaal << "' is not available. Please choose from the listed Taals." << std::endl;
-        return 1;
+    // Keywords are matched exactly; anything else is a word
+    int classify(std::string_view word) {
+        static constexpr struct { std::string_view text; int token; } keywords[] = {
+            {"Raag", RAAG}, {"Taal", TAAL}, {"Tempo", TEMPO}, {"Output", OUTPUT}, {"list", LIST},
+            {"taals", TAALS}, {"add", ADD}, {"taal", TAAL_LOWER}, {"set", SET}, {"tempo", TEMPO_LOWER},
+        };
+        for (const auto& keyword : keywords) {
+            if (keyword.text == word) {
+                return keyword.token;
+            }
+        }
+        return WORD;
     }
 
-    if (parsedTempo != "Bilambit" && parsedTempo != "Madhya" && parsedTempo != "Drut") {
-        std::cerr << "Error: Tempo '" << parsedTempo << "' is invalid. Valid options are 'Bilambit', 'Madhya', or 'Drut'." << std::endl;
-        return 1;
+    bool parseBeats(std::string_view text, int& beats) {
+        beats = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9' || beats > 100000) {
+                return false;
+            }
+            beats = beats * 10 + (c - '0');
+        }
+        return beats > 0;
     }
+}
+
+static int cmdlex(CMDSTYPE* value, CommandScanner* scanner);
+static void cmderror(CommandScanner* scanner, CommandSyntax* syntax, const char* message);
+}
+
+%token END 0 "end of command"
+%token RAAG "'Raag'" TAAL "'Taal'" TEMPO "'Tempo'" OUTPUT "'Output'"
+%token LIST "'list'" TAALS "'taals'" ADD "'add'" TAAL_LOWER "'taal'" SET "'set'" TEMPO_LOWER "'tempo'"
+%token WORD "word"
+
+%%
+
+command
+    : RAAG any TAAL any tempo output { syntax->type = Command::Type::Generate; syntax->raag = $2; syntax->taal = $4; }
+    | LIST TAALS                     { syntax->type = Command::Type::ListTaals; }
+    | SET TEMPO_LOWER any            { syntax->type = Command::Type::SetTempo; syntax->tempo = $3; }
+    | ADD TAAL_LOWER any any bols
+        {
+            syntax->type = Command::Type::AddTaal;
+            syntax->taal = $3;
+            if (!parseBeats($4, syntax->beats)) {
+                scanner->error = "Beats must be a positive integer: " + std::string($4);
+                YYABORT;
+            }
+        }
+    ;
+
+tempo
+    : %empty
+    | TEMPO any { syntax->tempo = $2; }
+    | bare      { syntax->tempo = $1; }
+    ;
+
+output
+    : %empty
+    | OUTPUT any { syntax->outputPath = $2; }
+    ;
+
+bols
+    : any      { syntax->bols.push_back($1); }
+    | bols any { syntax->bols.push_back($2); }
+    ;
 
-    // Generate MIDI
-    int tempoValue = (parsedTempo == "Bilambit" ? 60 : parsedTempo == "Madhya" ? 90 : 120);
-    Tempo tempo(parsedTempo, tempoValue);
+/* Names may be spelled like keywords, except a bare tempo, which cannot be 'Tempo' or 'Output' */
+any
+    : bare
+    | TEMPO
+    | OUTPUT
+    ;
 
-    try {
-        Taal taal = taalManager.getTaal(parsedTaal);
-        midiHandler.generateTaalMIDI(taal, tempo, parsedRaag);
-    } catch (const std::exception& e) {
-        std::cerr << "Error generating MIDI: " << e.what() << std::endl;
-        return 1;
+bare
+    : WORD | RAAG | TAAL | LIST | TAALS | ADD | TAAL_LOWER | SET | TEMPO_LOWER
+    ;
+
+%%
+
+static int cmdlex(CMDSTYPE* value, CommandScanner* scanner) {
+    std::string_view line = scanner->line;
+    std::size_t i = scanner->position;
+    while (i < line.size() && isSpace(line[i])) {
+        ++i;
+    }
+    std::size_t start = i;
+    while (i < line.size() && !isSpace(line[i])) {
+        ++i;
+    }
+    scanner->position = i;
+    scanner->previous = scanner->current;
+    scanner->current = line.substr(start, i - start);
+    *value = scanner->current;
+    if (scanner->current.empty()) {
+        return END;
     }
+    int token = classify(scanner->current);
+    if (scanner->first) {
+        scanner->first = false;
+        scanner->generate = token == RAAG;
+    }
+    return token;
+}
 
-    std::cout << "MIDI file generated successfully!" << std::endl;
+// Messages name the token at fault, as the hand-written parser this replaced did
+static int yyreport_syntax_error(const yypcontext_t* context, CommandScanner* scanner, CommandSyntax*) {
+    if (scanner->line.find_first_not_of(" \t\r\n\v\f") == std::string_view::npos) {
+        scanner->error = "Empty command";
+    } else if (!scanner->generate) {
+        scanner->error = "Unknown command: " + std::string(scanner->line);
+    } else {
+        yysymbol_kind_t expected[2];
+        int count = yypcontext_expected_tokens(context, expected, 2);
+        if (count == 1 && expected[0] != YYSYMBOL_WORD && expected[0] != YYSYMBOL_YYEOF) {
+            scanner->error = std::string("Expected ") + yysymbol_name(expected[0]);
+        } else if (yypcontext_token(context) == YYSYMBOL_YYEOF) {
+            scanner->error = "Missing value after '" + std::string(scanner->previous) + "'";
+        } else {
+            scanner->error = "Unexpected '" + std::string(scanner->current) + "'";
+        }
+    }
     return 0;
 }
+
+static void cmderror(CommandScanner* scanner, CommandSyntax*, const char* message) {
+    scanner->error = message;
+}
+
+void parseCommandSyntax(std::string_view line, CommandSyntax& syntax) {
+    syntax.raag = {};
+    syntax.taal = {};
+    syntax.tempo = {};
+    syntax.outputPath = {};
+    syntax.beats = 0;
+    syntax.bols.clear(); // Keeps its capacity, so a reused syntax parses without allocating
+
+    CommandScanner scanner;
+    scanner.line = line;
+    if (cmdparse(&scanner, &syntax) != 0) {
+        throw std::invalid_argument(scanner.error);
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef ARRANGEMENT_H
+#define ARRANGEMENT_H
+
+#include "EventStream.h"
+#include "Laykari.h"
+#include "MIDIHandler.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Semitones above Sa of the raag's svaras, lowest first.
+ *
+ * Covers the common Hindustani thaats and a few pentatonic raags; any other raag uses
+ * Bilawal (the major scale).
+ */
+std::vector<int> raagScale(const std::string& raag);
+
+/**
+ * @brief The tabla theka: one cycle per laykari step, repeating, with sam accented.
+ */
+std::unique_ptr<EventStream> makeThekaStream(const Taal& taal, const RenderOptions& options,
+                                             const LaykariPlan& plan, uint64_t totalTicks);
+
+/**
+ * @brief A tanpura drone plucking Pa (or Ma / Ni when the raag omits Pa), Sa, Sa and low Sa, one string per matra.
+ */
+std::unique_ptr<EventStream> makeTanpuraStream(const Taal& taal, const std::string& raag, uint8_t tonic,
+                                               uint8_t channel, const LaykariPlan& plan, uint64_t totalTicks);
+
+/**
+ * @brief A lehra (nagma) looping over each cycle: up the raag's scale from Sa and back, one svara per matra.
+ */
+std::unique_ptr<EventStream> makeLehraStream(const Taal& taal, const std::string& raag, uint8_t tonic,
+                                             uint8_t channel, const LaykariPlan& plan, uint64_t totalTicks);
+
+#endif // ARRANGEMENT_H
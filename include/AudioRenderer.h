@@ -0,0 +1,61 @@
+#ifndef AUDIORENDERER_H
+#define AUDIORENDERER_H
+
+#include "MIDIHandler.h"
+#include "TaalManager.h"
+#include "Tempo.h"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+struct AudioOptions {
+    uint32_t sampleRate = 48000;
+    unsigned threads = 0;        // Segment renderers; 0 uses every hardware thread
+    double tailSeconds = 2.0;    // Silence after the last cycle for the final strokes to ring out
+};
+
+// Summary of an audio render
+struct AudioReport {
+    double audioSeconds = 0.0;
+    double wallSeconds = 0.0;
+    double realtimeFactor = 0.0; // Seconds of audio per second of rendering
+    uint64_t voices = 0;         // Notes synthesized
+};
+
+/**
+ * @brief Renders a Taal to a 16-bit stereo WAV file, synthesizing every instrument procedurally.
+ *
+ * The notes are MIDIHandler::renderEvents, so the audio matches the MIDI file note for
+ * note. Tabla strokes are damped modal partials of the dayan (tuned to the tonic) and
+ * bayan plus a noise burst, chosen by note; the tanpura channel (General MIDI Sitar) is a
+ * plucked harmonic string; any other channel is a sustained reed voice.
+ *
+ * The track is cut into fixed segments rendered in parallel and written in order, a
+ * batch at a time, so memory does not grow with its length. Each voice is evaluated in
+ * blocks aligned to its own onset, and every segment replays the voice from its onset,
+ * so the samples, and the file, are identical whatever the thread count.
+ */
+class AudioRenderer {
+public:
+    explicit AudioRenderer(const MIDIHandler& midiHandler, const AudioOptions& audioOptions = {});
+
+    /**
+     * @brief Streams the WAV file to out.
+     *
+     * @throws std::invalid_argument if the render is longer than a WAV file can hold.
+     */
+    AudioReport renderTaalWAV(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                              const RenderOptions& options, std::ostream& out) const;
+
+    /**
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    AudioReport writeTaalWAV(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                             const std::string& outputPath, const RenderOptions& options = {}) const;
+
+private:
+    const MIDIHandler& midiHandler;
+    AudioOptions audioOptions;
+};
+
+#endif // AUDIORENDERER_H
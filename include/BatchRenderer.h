@@ -0,0 +1,73 @@
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include "MIDIHandler.h"
+#include "TaalManager.h"
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+// One line of a batch manifest
+struct BatchJob {
+    std::string raag;
+    std::string taal;
+    std::string tempo;
+    std::string outputPath;
+    std::size_t line = 0; // Manifest line number, for error messages
+};
+
+// Summary of a batch run
+struct BatchReport {
+    std::size_t jobs = 0;
+    std::size_t failed = 0;
+    double wallSeconds = 0.0;
+    double jobsPerSecond = 0.0;
+    double p50Milliseconds = 0.0;
+    double p99Milliseconds = 0.0;
+    std::vector<std::string> errors;
+};
+
+/**
+ * @brief Renders many Raag/Taal/Tempo jobs in one process on a work-stealing thread pool.
+ *
+ * All jobs share the same (read-only) TaalManager and MIDIHandler.
+ */
+class BatchRenderer {
+public:
+    /**
+     * @param taalManager A loaded catalog. It must not be modified while run() executes.
+     * @param midiHandler The renderer used for every job.
+     * @param threads Worker count; 0 uses every hardware thread.
+     * @param options Track length applied to every job.
+     * @param sink Where finished files go; nullptr streams each job straight to its file.
+     *             run() calls its finish() after the last job.
+     */
+    BatchRenderer(const TaalManager& taalManager, const MIDIHandler& midiHandler, unsigned threads = 0,
+                  const RenderOptions& options = {}, OutputSink* sink = nullptr);
+
+    /**
+     * @brief Parses a manifest with one "<raag> <taal> <tempo> <output>" job per line.
+     *
+     * Blank lines and lines starting with '#' are skipped.
+     *
+     * @throws std::runtime_error on a malformed line.
+     */
+    static std::vector<BatchJob> parseManifest(std::istream& in);
+
+    /**
+     * @brief Renders every job and returns throughput and latency figures.
+     *
+     * A failing job is counted and reported in BatchReport::errors; it does not stop the batch.
+     */
+    BatchReport run(const std::vector<BatchJob>& jobs) const;
+
+private:
+    const TaalManager& taalManager;
+    const MIDIHandler& midiHandler;
+    unsigned threads;
+    RenderOptions options;
+    OutputSink* sink;
+};
+
+#endif // BATCHRENDERER_H
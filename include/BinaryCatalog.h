@@ -0,0 +1,88 @@
+#ifndef BINARYCATALOG_H
+#define BINARYCATALOG_H
+
+#include "MappedFile.h"
+#include "NameIndex.h"
+#include "TaalManager.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Precompiled, memory-mapped Taal catalog.
+ *
+ * On-disk layout (all integers little-endian):
+ *   Header      magic "TANSENCT", version, counts and section offsets (64 bytes)
+ *   Strings     bytes of every taal name, system name and distinct bol
+ *   Bol table   bolCount x {uint32 offset, uint32 length} into Strings
+ *   Entries     taalCount x {name, system, beats, bolCount, bolsOffset} (32 bytes each), one per system and taal
+ *   Bol arrays  packed uint16 indices into the bol table, one run per entry
+ *   Name index  NameIndex over qualified names, bare names and aliases, to the end of the file
+ *
+ * Opening validates only the header, so it costs the same for any catalog size;
+ * entries are decoded when they are looked up.
+ */
+class BinaryCatalog {
+public:
+    static constexpr uint32_t kVersion = 2;
+
+    /**
+     * @brief Compiles a JSON catalog (the format of data/tals.json) into the binary format.
+     *
+     * The output is written to a temporary file and renamed into place, so processes
+     * mapping the previous version keep a consistent view.
+     *
+     * @throws std::runtime_error on unreadable or malformed input, or if the output cannot be written.
+     */
+    static void compile(const std::string& jsonPath, const std::string& outputPath);
+
+    /**
+     * @brief Returns true if the file at path starts with the binary catalog magic.
+     */
+    static bool isCatalogFile(const std::string& path);
+
+    /**
+     * @brief Maps a compiled catalog.
+     *
+     * @throws std::runtime_error if the file is not a catalog of a supported version.
+     */
+    explicit BinaryCatalog(const std::string& path);
+
+    std::size_t size() const { return taalCount; }
+
+    /**
+     * @brief Name index resolving qualified names, bare names and aliases to entries.
+     */
+    const NameIndex& names() const { return index; }
+
+    std::string_view name(std::size_t entry) const;
+    std::string_view system(std::size_t entry) const;
+
+    /**
+     * @brief Decodes one entry into a Taal, interning its bols.
+     */
+    Taal decode(std::size_t entry) const;
+
+private:
+    const uint8_t* entryRecord(std::size_t entry) const;
+    std::string_view string(uint32_t offset, uint32_t length) const;
+    BolId bolId(uint16_t index) const;
+
+    MappedFile file;
+    uint32_t taalCount = 0;
+    uint32_t bolCount = 0;
+    uint64_t stringsOffset = 0;
+    uint64_t stringsSize = 0;
+    uint64_t bolTableOffset = 0;
+    uint64_t entriesOffset = 0;
+    uint64_t indexOffset = 0;
+    NameIndex index;
+
+    // Catalog bol index -> interned BolId + 1 (0 = not interned yet)
+    std::unique_ptr<std::atomic<uint32_t>[]> bolIds;
+};
+
+#endif // BINARYCATALOG_H
@@ -0,0 +1,90 @@
+#ifndef BOLTABLE_H
+#define BOLTABLE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Small integer identifier of an interned bol
+using BolId = uint16_t;
+
+/**
+ * @brief Process-wide interner mapping each bol to a BolId, with a flat BolId -> MIDI note table.
+ *
+ * Interning takes a lock; note() is a lock-free array read so the render loop never
+ * hashes a string. Names and notes of an interned bol stay valid for the life of the process.
+ */
+class BolTable {
+public:
+    static constexpr std::size_t kMaxBols = 65536;
+    static constexpr uint8_t kDefaultNote = 60; // Middle C for bols without a mapping
+    static constexpr std::string_view kRest = "-";
+
+    /**
+     * @brief Returns the shared table, seeded with the General MIDI percussion mapping.
+     */
+    static BolTable& instance();
+
+    /**
+     * @brief Returns the id of the bol, adding it to the table if needed.
+     *
+     * @throws std::length_error if the table already holds kMaxBols bols.
+     */
+    BolId intern(std::string_view bol);
+
+    /**
+     * @brief Looks up a bol without adding it.
+     *
+     * @return true and sets id if the bol is known.
+     */
+    bool find(std::string_view bol, BolId& id) const;
+
+    /**
+     * @brief Returns the text of an interned bol.
+     */
+    const std::string& name(BolId id) const;
+
+    /**
+     * @brief Returns the MIDI note played for a bol.
+     */
+    uint8_t note(BolId id) const { return notes[id].load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Changes the MIDI note played for a bol.
+     */
+    void setNote(BolId id, uint8_t note) { notes[id].store(note, std::memory_order_relaxed); }
+
+    /**
+     * @brief Reverse of note(): finds the bol played on a MIDI note.
+     *
+     * When several bols share the note, the one interned first wins, so the seeded
+     * mapping takes precedence over bols that merely fell back to kDefaultNote.
+     *
+     * @return true and sets id if some bol plays the note.
+     */
+    bool bolForNote(uint8_t note, BolId& id) const;
+
+    /**
+     * @brief Id of kRest, the bol of a silent stroke (rendered as a Note On with velocity 0).
+     */
+    BolId rest() const { return restId; }
+
+    std::size_t size() const;
+
+private:
+    BolTable();
+
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> names;                     // Indexed by BolId; deque keeps references stable
+    std::unordered_map<std::string_view, BolId> ids;   // Keys view into names
+    std::array<std::atomic<uint8_t>, kMaxBols> notes;
+    BolId restId = 0;
+};
+
+#endif // BOLTABLE_H
@@ -0,0 +1,38 @@
+#ifndef BYTEORDER_H
+#define BYTEORDER_H
+
+#include <cstdint>
+#include <vector>
+
+// Little-endian loads and appends for the on-disk formats; safe at any alignment
+
+inline uint16_t load16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+inline uint32_t load32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t load64(const uint8_t* p) {
+    return static_cast<uint64_t>(load32(p)) | (static_cast<uint64_t>(load32(p + 4)) << 32);
+}
+
+inline void store16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+inline void store32(std::vector<uint8_t>& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back((value >> shift) & 0xFF);
+    }
+}
+
+inline void store64(std::vector<uint8_t>& out, uint64_t value) {
+    store32(out, static_cast<uint32_t>(value));
+    store32(out, static_cast<uint32_t>(value >> 32));
+}
+
+#endif // BYTEORDER_H
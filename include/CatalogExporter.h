@@ -0,0 +1,72 @@
+#ifndef CATALOGEXPORTER_H
+#define CATALOGEXPORTER_H
+
+#include "MIDIHandler.h"
+#include "TaalManager.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What to export: every Taal of the catalog at every tempo
+struct ExportOptions {
+    std::vector<std::string> tempos = {"Bilambit", "Madhya", "Drut"};
+    std::string raag;     // Raag of every track's title and lehra; empty for none
+    unsigned threads = 0; // Render workers; 0 uses every hardware thread
+    bool verify = false;  // Re-hash every output, re-rendering any modified since the last export;
+                          // otherwise outputs are only checked to exist
+};
+
+// Summary of an export run
+struct ExportReport {
+    std::size_t entries = 0;   // Tracks the catalog and tempos call for
+    std::size_t rendered = 0;  // New, changed or missing, so written this run
+    std::size_t unchanged = 0; // Skipped: inputs and output match the manifest
+    std::size_t removed = 0;   // Outputs whose Taal or tempo is gone, deleted
+    std::size_t failed = 0;
+    double wallSeconds = 0.0;
+    std::vector<std::string> errors;
+};
+
+/**
+ * @brief Keeps a directory of rendered tracks, one per Taal and tempo, in step with the catalog.
+ *
+ * A manifest in the directory records, for every track, a content hash of its inputs (the
+ * Taal's definition, the resolved tempo, the raag and the render options) and of the file
+ * written. A run hashes the current inputs, which takes microseconds per track. It renders
+ * only the tracks whose hash changed or whose file is missing, in parallel. Then it deletes
+ * the files the manifest lists that no longer have an input. After a one-line catalog edit,
+ * only that Taal's tracks are rendered again.
+ *
+ * Files are named <dir>/<system>/<Taal>_<tempo>.mid. Only files listed in the manifest are
+ * ever deleted.
+ */
+class CatalogExporter {
+public:
+    static constexpr const char* kManifestName = ".tansen-export";
+
+    /**
+     * @param taalManager A loaded catalog. It must not be modified while run() executes.
+     */
+    CatalogExporter(const TaalManager& taalManager, const MIDIHandler& midiHandler,
+                    const RenderOptions& renderOptions = {}, const ExportOptions& exportOptions = {});
+
+    /**
+     * @brief Brings outputDir up to date and rewrites its manifest.
+     *
+     * A track that fails to render is reported in ExportReport::errors and left out of the
+     * manifest, so the next run tries it again.
+     *
+     * @throws std::invalid_argument on an unknown tempo.
+     * @throws std::runtime_error if the directory or manifest cannot be written.
+     */
+    ExportReport run(const std::string& outputDir) const;
+
+private:
+    const TaalManager& taalManager;
+    const MIDIHandler& midiHandler;
+    RenderOptions renderOptions;
+    ExportOptions exportOptions;
+};
+
+#endif // CATALOGEXPORTER_H
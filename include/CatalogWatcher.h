@@ -0,0 +1,45 @@
+#ifndef CATALOGWATCHER_H
+#define CATALOGWATCHER_H
+
+#include "TaalManager.h"
+#include <iosfwd>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Reloads a TaalManager whenever its catalog file changes on disk (Linux inotify).
+ *
+ * The file's directory is watched rather than the file, so replacing it by rename (editors,
+ * compile-catalog) is seen as well as writing it in place. Events are coalesced until the
+ * file has been quiet for kSettleMilliseconds, then TaalManager::reload() runs on the
+ * watcher thread; readers keep the previous snapshot until the new one is published.
+ * Each reload, with its latency, or failure is written to log.
+ */
+class CatalogWatcher {
+public:
+    static constexpr int kSettleMilliseconds = 50;
+    static constexpr int kReclaimMilliseconds = 1000; // Frees retired snapshots while idle
+
+    /**
+     * @throws std::runtime_error if inotify is unavailable or the directory cannot be watched.
+     */
+    CatalogWatcher(TaalManager& taalManager, const std::string& path, std::ostream& log);
+    ~CatalogWatcher();
+
+    CatalogWatcher(const CatalogWatcher&) = delete;
+    CatalogWatcher& operator=(const CatalogWatcher&) = delete;
+
+private:
+    void run();
+    bool changed(); // Drains pending events; true if any concerned the catalog file
+
+    TaalManager& taalManager;
+    std::string path;
+    std::string fileName;
+    std::ostream& log;
+    int notifyFd = -1;
+    int stopFd = -1; // eventfd signalled by the destructor
+    std::thread thread;
+};
+
+#endif // CATALOGWATCHER_H
@@ -0,0 +1,60 @@
+#ifndef COMMANDEXECUTOR_H
+#define COMMANDEXECUTOR_H
+
+#include "CommandParser.h"
+#include "MIDIHandler.h"
+#include "TaalManager.h"
+#include "Tempo.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Outcome of one executed command
+struct CommandResult {
+    enum class Kind {
+        Text, // text holds a listing or confirmation
+        Midi, // midi holds the rendered file
+        File  // text holds the path the MIDI file was written to
+    };
+
+    Kind kind = Kind::Text;
+    std::string text;
+    std::vector<uint8_t> midi;
+};
+
+/**
+ * @brief Runs parsed commands against a shared catalog, keeping per-session state (the current tempo).
+ *
+ * One executor per session; many executors may share the same TaalManager and MIDIHandler.
+ */
+class CommandExecutor {
+public:
+    /**
+     * @param inlineOutput If true, Generate without an Output clause returns the MIDI bytes;
+     *                     otherwise it writes the default output file.
+     */
+    CommandExecutor(TaalManager& taalManager, const MIDIHandler& midiHandler, bool inlineOutput,
+                    const RenderOptions& options = {});
+
+    /**
+     * @throws std::exception if the command fails (unknown taal, bad tempo, I/O error...).
+     */
+    CommandResult execute(const Command& command);
+
+    /**
+     * @brief Executes into an existing result, reusing its buffers; renders use the executor's RenderContext.
+     */
+    void execute(const Command& command, CommandResult& result);
+
+    const Tempo& currentTempo() const { return tempo; }
+
+private:
+    TaalManager& taalManager;
+    const MIDIHandler& midiHandler;
+    bool inlineOutput;
+    RenderOptions options;
+    Tempo tempo;
+    RenderContext context;
+};
+
+#endif // COMMANDEXECUTOR_H
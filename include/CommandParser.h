@@ -0,0 +1,65 @@
+#ifndef COMMANDPARSER_H
+#define COMMANDPARSER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A parsed CLI command
+struct Command {
+    enum class Type {
+        Generate,  // Raag <raag> Taal <taal> [Tempo] <tempo> [Output <path>]
+        ListTaals, // list taals
+        AddTaal,   // add taal <name> <beats> <bol1> ... <bolN>
+        SetTempo   // set tempo <tempo>
+    };
+
+    Type type = Type::Generate;
+    std::string raag;
+    std::string taal;
+    std::string tempo;      // Empty if Generate should use the session tempo
+    std::string outputPath; // Empty if no Output clause was given
+    int beats = 0;
+    std::vector<std::string> bols;
+};
+
+// A parsed command as views into the line it was parsed from, valid while the line is
+struct CommandSyntax {
+    Command::Type type = Command::Type::Generate;
+    std::string_view raag;
+    std::string_view taal;
+    std::string_view tempo;
+    std::string_view outputPath;
+    int beats = 0;
+    std::vector<std::string_view> bols;
+};
+
+/**
+ * @brief Parses one command line without copying it.
+ *
+ * The parser (generated by Bison from cli/command_parser.y) and its scanner keep all of
+ * their state on the stack, so any number of threads may parse at once. A reused syntax
+ * parses without allocating.
+ *
+ * @throws std::invalid_argument with a description of the problem if the line is not a valid command.
+ */
+void parseCommandSyntax(std::string_view line, CommandSyntax& syntax);
+
+/**
+ * @brief Copies a parsed command out of its line into command, reusing the strings' capacity.
+ */
+void assignCommand(const CommandSyntax& syntax, Command& command);
+
+/**
+ * @brief Parses one command line.
+ *
+ * @throws std::invalid_argument with a description of the problem if the line is not a valid command.
+ */
+Command parseCommand(const std::string& line);
+
+/**
+ * @brief Parses into an existing Command, reusing its string capacity (for servers parsing line after line).
+ */
+void parseCommand(const std::string& line, Command& command);
+
+#endif // COMMANDPARSER_H
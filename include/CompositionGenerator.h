@@ -0,0 +1,112 @@
+#ifndef COMPOSITIONGENERATOR_H
+#define COMPOSITIONGENERATOR_H
+
+#include "BolTable.h"
+#include "Laykari.h"
+#include "TaalManager.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class CompositionKind : uint8_t {
+    Tihai,    // A phrase played three times, the last stroke on sam
+    Chakradar // A phrase ending in its own tihai, played three times, the last stroke on sam
+};
+
+struct CompositionOptions {
+    static constexpr unsigned kMaxCycles = 16;
+    static constexpr std::size_t kMaxLimit = std::size_t(1) << 20;
+
+    CompositionKind kind = CompositionKind::Tihai;
+    Laykari laykari;          // Strokes per matra of the composition
+    unsigned cycles = 1;      // Avartans the composition may span before landing on sam, up to kMaxCycles
+    std::size_t limit = 100;  // Compositions generated, best first; more than kMaxLimit are not
+    uint64_t seed = 0;        // Varies the ranking; the same seed always gives the same compositions
+};
+
+// One composition on the pulse grid of its laykari
+struct Composition {
+    CompositionKind kind = CompositionKind::Tihai;
+    double score = 0.0;
+    uint32_t start = 0;          // Pulse, from the first sam, at which the composition begins
+    uint32_t phrase = 0;         // Pulses of the repeated phrase (the palla of a chakradar)
+    uint32_t gap = 0;            // Rest pulses between repetitions
+    std::vector<BolId> bols;     // Every pulse, rests included; the last lands on sam
+    std::string text;            // Words of the composition, "-" for each rest
+};
+
+/**
+ * @brief Generates tihais and chakradars that land exactly on sam of a Taal.
+ *
+ * Phrases are built from a vocabulary of tabla words. For every phrase length the best
+ * phrases are found once by a memoized k-best dynamic program over the pulses left to
+ * fill, so the search is shared between every structure that uses that length. Only the
+ * structures (phrase, gap and, for a chakradar, inner tihai lengths) whose total makes the
+ * last stroke fall on sam, starting on a matra, are considered; each of them then yields
+ * its compositions lazily in score order, and a heap merges them into one ranked stream.
+ * A generator is immutable once built and may be shared between threads.
+ */
+class CompositionGenerator {
+public:
+    /**
+     * @throws std::invalid_argument if the Taal is empty, cycles is not 1 to kMaxCycles or the laykari
+     *         is invalid.
+     */
+    CompositionGenerator(const Taal& taal, const CompositionOptions& options = {});
+
+    /**
+     * @brief Streams up to options.limit compositions, best first, until visit returns false.
+     */
+    void generate(const std::function<bool(const Composition&)>& visit) const;
+
+    std::vector<Composition> generate() const;
+
+    /**
+     * @brief Lays the composition over the theka as a Taal MIDIHandler can render.
+     *
+     * One avartan of theka (at the composition's laykari) leads in, the composition lands on
+     * the sam options.cycles avartans later, and one more avartan of theka follows from there.
+     * Rendered with one cycle at barabar, it plays exactly those avartans.
+     */
+    Taal arrange(const Composition& composition) const;
+
+    /**
+     * @brief Strokes per avartan at the composition's laykari.
+     */
+    uint32_t pulsesPerCycle() const { return cyclePulses; }
+
+private:
+    // A tabla word: its strokes and how strongly the ranking favours it
+    struct Word {
+        std::string text;
+        std::vector<BolId> bols;
+        double weight;
+        bool landsOnDha;
+    };
+
+    // One phrase in a k-best list: its score, its first (or, ending on Dha, last) word,
+    // and the rank of the rest of the phrase in the list for the remaining length
+    struct Entry {
+        double score;
+        uint16_t word;
+        uint32_t rest;
+    };
+
+    void buildTables();
+    void appendPhrase(const std::vector<std::vector<Entry>>& table, uint32_t length, uint32_t rank,
+                      Composition& composition) const;
+    void appendRests(uint32_t count, Composition& composition) const;
+
+    Taal taal;
+    CompositionOptions options;
+    uint32_t pulsesPerMatra;
+    uint32_t cyclePulses;
+    uint32_t landing; // Pulse of the sam the composition lands on
+    std::vector<Word> words;
+    std::vector<std::vector<Entry>> anyPhrases;    // k best phrases of each length
+    std::vector<std::vector<Entry>> landingPhrases; // k best phrases of each length ending on Dha
+};
+
+#endif // COMPOSITIONGENERATOR_H
@@ -0,0 +1,96 @@
+#ifndef CYCLECACHE_H
+#define CYCLECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Everything that determines the bytes of one encoded avartan; taals with the same theka share entries
+struct CycleKey {
+    uint64_t pattern = 0;     // Hash of the beats, bols and their notes, so an edit or remap never hits a stale entry
+    int bpm = 0;
+    uint8_t channel = 0;
+    uint8_t velocity = 0;
+    uint8_t samVelocity = 0;
+    uint32_t notesPerCycle = 0; // Laykari subdivision of the cycle
+    uint32_t ticksPerNote = 0;  // Note length on the render's tick grid
+    bool runningStatus = false; // Encoded with running status, continuing the Note On status
+
+    bool operator==(const CycleKey& other) const {
+        return pattern == other.pattern && bpm == other.bpm && channel == other.channel &&
+               velocity == other.velocity && samVelocity == other.samVelocity &&
+               notesPerCycle == other.notesPerCycle && ticksPerNote == other.ticksPerNote &&
+               runningStatus == other.runningStatus;
+    }
+};
+
+struct CycleKeyHash {
+    std::size_t operator()(const CycleKey& key) const;
+};
+
+/**
+ * @brief In-process LRU cache of encoded cycles (track bytes of one avartan).
+ *
+ * Entries are immutable and shared, so a cycle stays usable after it is evicted.
+ */
+class CycleCache {
+public:
+    using Cycle = std::shared_ptr<const std::vector<uint8_t>>;
+
+    static constexpr std::size_t kDefaultCapacityBytes = 32 * 1024 * 1024;
+
+    /**
+     * @brief Returns the cache shared by every MIDIHandler in the process.
+     */
+    static CycleCache& shared();
+
+    explicit CycleCache(std::size_t capacityBytes = kDefaultCapacityBytes);
+
+    /**
+     * @brief Returns the cached cycle for key, calling encode() to build it on a miss.
+     *
+     * encode runs without the cache lock held, so a miss does not block other lookups.
+     * A hit does not allocate.
+     */
+    template <typename Encoder>
+    Cycle getOrEncode(const CycleKey& key, Encoder&& encode) {
+        if (Cycle cycle = find(key)) {
+            return cycle;
+        }
+        return insert(key, std::make_shared<const std::vector<uint8_t>>(encode()));
+    }
+
+    /**
+     * @brief Returns the cached cycle for key (counting a hit), or null (counting a miss).
+     */
+    Cycle find(const CycleKey& key);
+
+    /**
+     * @brief Caches cycle under key; if another thread got there first, returns its cycle instead.
+     */
+    Cycle insert(const CycleKey& key, Cycle cycle);
+
+    void clear();
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    using Entry = std::pair<CycleKey, Cycle>;
+
+    void evict();
+
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<CycleKey, std::list<Entry>::iterator, CycleKeyHash> index;
+    std::size_t capacityBytes;
+    std::size_t sizeBytes = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
+
+#endif // CYCLECACHE_H
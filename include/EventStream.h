@@ -0,0 +1,102 @@
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+// A channel voice event at an absolute tick
+struct MidiEvent {
+    uint64_t tick = 0;
+    uint8_t status = 0; // Status byte including the channel
+    uint8_t data1 = 0;
+    uint8_t data2 = 0;  // Unused by program change and channel pressure
+};
+
+/**
+ * @brief Source of MIDI events in non-decreasing tick order, generated on demand.
+ */
+class EventStream {
+public:
+    virtual ~EventStream() = default;
+
+    /**
+     * @brief Produces the next event.
+     *
+     * @return false once the stream is exhausted.
+     */
+    virtual bool next(MidiEvent& event) = 0;
+
+    /**
+     * @brief Name written as the track name in Format 1 files.
+     */
+    virtual const std::string& name() const = 0;
+
+    /**
+     * @brief At least as many events as the stream produces in all, so a writer can refuse an
+     *        oversized track before streaming any of it.
+     */
+    virtual uint64_t eventBound() const = 0;
+};
+
+/**
+ * @brief Replays a one-period pattern until a total length is reached, without materializing the repeats.
+ *
+ * The prelude (e.g. program changes) is emitted once at the start. Pattern events are relative
+ * to the start of their period. Events past totalTicks are dropped, so patterns should not hold notes
+ * across the points where a render may end (cycle boundaries).
+ */
+class LoopStream : public EventStream {
+public:
+    LoopStream(std::string name, std::vector<MidiEvent> prelude, std::vector<MidiEvent> pattern,
+               uint64_t periodTicks, uint64_t totalTicks);
+
+    bool next(MidiEvent& event) override;
+    const std::string& name() const override { return trackName; }
+    uint64_t eventBound() const override;
+
+private:
+    std::string trackName;
+    std::vector<MidiEvent> prelude;
+    std::vector<MidiEvent> pattern;
+    uint64_t periodTicks;
+    uint64_t totalTicks;
+    std::size_t preludeIndex = 0;
+    std::size_t patternIndex = 0;
+    uint64_t periodStart = 0;
+};
+
+/**
+ * @brief k-way merge of several streams into one tick-ordered stream.
+ *
+ * Holds one pending event per source in a min-heap, so merging E events from k sources
+ * costs O(E log k) and never buffers more than k events. Ties are broken by source order,
+ * keeping the output deterministic.
+ */
+class MergedStream : public EventStream {
+public:
+    MergedStream(std::string name, std::vector<std::unique_ptr<EventStream>> sources);
+
+    bool next(MidiEvent& event) override;
+    const std::string& name() const override { return trackName; }
+    uint64_t eventBound() const override;
+
+private:
+    struct Head {
+        MidiEvent event;
+        std::size_t source;
+    };
+    struct Later {
+        bool operator()(const Head& a, const Head& b) const {
+            return a.event.tick != b.event.tick ? a.event.tick > b.event.tick : a.source > b.source;
+        }
+    };
+
+    std::string trackName;
+    std::vector<std::unique_ptr<EventStream>> sources;
+    std::priority_queue<Head, std::vector<Head>, Later> heads;
+};
+
+#endif // EVENTSTREAM_H
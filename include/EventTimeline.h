@@ -0,0 +1,85 @@
+#ifndef EVENTTIMELINE_H
+#define EVENTTIMELINE_H
+
+#include "EventStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Channel events held as parallel arrays (ticks, status, data1, data2) between
+ *        generation and serialization.
+ *
+ * Keeping each field in its own array lets whole-timeline passes (quantize, transpose,
+ * accent) run as branch-free loops over contiguous bytes that the compiler vectorizes.
+ * sort() is a stable LSD radix sort on ticks, so events from several sources can be
+ * appended in any order and come out in time order, ties in the order appended.
+ */
+class EventTimeline {
+public:
+    void reserve(std::size_t count);
+    void clear();
+
+    std::size_t size() const { return ticks.size(); }
+    bool empty() const { return ticks.empty(); }
+
+    void append(uint64_t tick, uint8_t status, uint8_t data1, uint8_t data2) {
+        ticks.push_back(tick);
+        statuses.push_back(status);
+        data1s.push_back(data1);
+        data2s.push_back(data2);
+    }
+
+    void append(const MidiEvent& event) { append(event.tick, event.status, event.data1, event.data2); }
+
+    uint64_t tick(std::size_t index) const { return ticks[index]; }
+    MidiEvent at(std::size_t index) const { return {ticks[index], statuses[index], data1s[index], data2s[index]}; }
+
+    /**
+     * @brief Stable sort by tick, in O(n) per byte of the tick range; already sorted timelines return at once.
+     */
+    void sort();
+
+    /**
+     * @brief Rounds every tick to the nearest multiple of grid (halves round up).
+     *
+     * Rounding never reorders events, so a sorted timeline stays sorted.
+     */
+    void quantize(uint64_t grid);
+
+    /**
+     * @brief Moves the notes (and their Note Offs and key pressure) on channel by semitones, clamped to 0-127.
+     */
+    void transpose(uint8_t channel, int semitones);
+
+    /**
+     * @brief Adds boost to the velocity of every Note On at a multiple of period, up to 127.
+     */
+    void accent(uint64_t period, uint8_t boost);
+
+    /**
+     * @brief Encodes events [begin, end) as delta-timed MIDI bytes.
+     *
+     * Deltas are taken from lastTick, which is advanced. With runningStatus on, repeated
+     * status bytes are left out and Note Offs are written as Note Ons with velocity 0 (see
+     * encodeRunningEvent); status carries the running status across calls. out must have
+     * room for encodedSizeBound(end - begin) bytes.
+     *
+     * @return The number of encoded bytes.
+     */
+    std::size_t encode(std::size_t begin, std::size_t end, uint64_t& lastTick, bool runningStatus,
+                       uint8_t& status, uint8_t* out) const;
+
+private:
+    std::vector<uint64_t> ticks;
+    std::vector<uint8_t> statuses;
+    std::vector<uint8_t> data1s;
+    std::vector<uint8_t> data2s;
+
+    // Sort scratch, kept to avoid reallocating on every window
+    std::vector<uint64_t> keys, sortedKeys;
+    std::vector<uint32_t> order, sortedOrder;
+    std::vector<uint8_t> gathered;
+};
+
+#endif // EVENTTIMELINE_H
@@ -0,0 +1,49 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Thread-safe collector of per-request latencies.
+ *
+ * Samples go into a fixed log-linear histogram of nanoseconds: 16 buckets per power of
+ * two, so a percentile is within 1/16 of the true value. Recording is a few relaxed
+ * atomic adds with no lock, and memory stays the same however many samples arrive.
+ * Readers see every sample recorded before they started, and possibly some recorded
+ * meanwhile.
+ */
+class LatencyStats {
+public:
+    /**
+     * @brief Records one sample, in milliseconds. Negative and NaN samples count as 0.
+     */
+    void record(double milliseconds);
+
+    /**
+     * @brief Returns the p-th percentile (0-100) of the recorded samples, or 0 if empty.
+     *
+     * This is the upper bound of the sample's bucket, capped at the largest sample, so
+     * percentile(100) is the exact maximum.
+     */
+    double percentile(double p) const;
+
+    std::size_t count() const;
+    double mean() const;
+
+private:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::size_t kBuckets = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+    static std::size_t bucketOf(uint64_t nanoseconds);
+    static uint64_t bucketLimit(std::size_t bucket);
+
+    std::array<std::atomic<uint64_t>, kBuckets> buckets{};
+    std::atomic<uint64_t> recorded{0};
+    std::atomic<uint64_t> totalNanoseconds{0};
+    std::atomic<uint64_t> maxNanoseconds{0};
+};
+
+#endif // LATENCYSTATS_H
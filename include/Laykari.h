@@ -0,0 +1,82 @@
+#ifndef LAYKARI_H
+#define LAYKARI_H
+
+#include "TaalManager.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Subdivision of every stroke: Chatusra leaves it whole; Tisra, Khanda and Misra split it into 3, 5 and 7
+enum class Gati : uint8_t {
+    Chatusra = 1,
+    Tisra = 3,
+    Khanda = 5,
+    Misra = 7
+};
+
+// Density of bols against the matra
+struct Laykari {
+    static constexpr unsigned kMaxDensity = 8;
+
+    unsigned density = 1;        // Strokes per matra: 1 barabar, 2 dugun, 3 tigun, 4 chaugun ... 8 athgun
+    Gati gati = Gati::Chatusra;
+
+    unsigned notesPerMatra() const { return density * static_cast<unsigned>(gati); }
+};
+
+/**
+ * @brief Parses "<density>[:<gati>]", e.g. "2", "dugun", "4:tisra", "chaugun:khanda".
+ *
+ * @throws std::invalid_argument on an unknown name or a density outside 1-8.
+ */
+Laykari parseLaykari(const std::string& text);
+
+/**
+ * @brief Parses a comma-separated sequence of laykaris, one per cycle (repeating).
+ */
+std::vector<Laykari> parseLaykariSequence(const std::string& text);
+
+// Tick layout of one laykari on a plan's grid
+struct LaykariStep {
+    Laykari laykari;
+    uint32_t notesPerCycle = 0;
+    uint32_t ticksPerNote = 0; // Exact: notesPerCycle * ticksPerNote == LaykariPlan::ticksPerCycle
+};
+
+// Tick grid shared by every laykari of a render
+struct LaykariPlan {
+    LaykariPlan() = default;
+    explicit LaykariPlan(std::pmr::memory_resource* resource) : steps(resource) {}
+
+    uint16_t division = 480;     // PPQN; one matra is one quarter note
+    uint64_t ticksPerCycle = 0;  // beats * division
+    std::pmr::vector<LaykariStep> steps;
+};
+
+/**
+ * @brief Chooses a PPQN that is a multiple of the LCM of every requested subdivision and lays out each laykari on it.
+ *
+ * The common divisions 480 and 840 (= LCM(1..8)) use tick tables built at compile time;
+ * anything else falls back to the LCM scaled to at least 480 PPQN. Every note of a cycle
+ * then has the same integral length, so dense passages never drift.
+ *
+ * Working storage and the plan's steps come from resource (e.g. a RenderContext arena).
+ *
+ * @throws std::invalid_argument if the Taal is empty, a density is out of range, or no
+ *         division fits the 15-bit SMF field.
+ */
+LaykariPlan planLaykari(const Taal& taal, const std::vector<Laykari>& sequence,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+/**
+ * @brief Moves plans onto one grid, the LCM of their divisions, so Taals rendered together
+ *        (e.g. layered against each other) share a tick.
+ *
+ * @throws std::invalid_argument if the common division does not fit the 15-bit SMF field.
+ */
+void alignLaykariPlans(std::vector<LaykariPlan>& plans);
+
+#endif // LAYKARI_H
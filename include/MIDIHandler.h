@@ -1,12 +1,137 @@
 #ifndef MIDIHANDLER_H
 #define MIDIHANDLER_H
 
+#include "EventStream.h"
+#include "Laykari.h"
+#include "OutputSink.h"
+#include "RenderContext.h"
 #include "TaalManager.h"
 #include "Tempo.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
+
+// Length and voicing of a render
+struct RenderOptions {
+    // Bounds of the length fields, enforced by every render
+    static constexpr uint64_t kMaxCycles = 1000000;
+    static constexpr double kMaxDurationSeconds = 24 * 3600.0;
+    static constexpr double kMaxTempoErrorMs = 1000.0;
+
+    uint64_t cycles = 4;          // Avartans to render when durationSeconds is not set
+    double durationSeconds = 0.0; // If positive, render whole cycles until at least this long
+    uint8_t channel = 9;          // Channel 10 (0-based), General MIDI percussion
+    uint8_t velocity = 80;        // Velocity of every bol but sam
+    uint8_t samVelocity = 80;     // Velocity of the first bol of each cycle
+    std::vector<Laykari> laykari; // One per cycle, repeating; empty plays barabar (one bol per matra)
+    uint16_t format = 0;          // 0: everything merged into one track; 1: a tempo track plus one track per instrument
+    bool tanpura = false;         // Add a tanpura drone
+    bool lehra = false;           // Add a lehra melody looping over each cycle in the raag's scale
+    uint8_t tonic = 60;           // MIDI note of Sa for the lehra; the tanpura sounds an octave lower
+    double tempoErrorMs = 1.0;    // Largest timing error of the tempo events approximating a ramp
+    bool runningStatus = true;    // Leave out repeated status bytes, ending notes with Note On velocity 0
+};
+
+// Every instrument of a render merged into one tick-ordered stream, with the grid it is timed on
+struct RenderEvents {
+    LaykariPlan plan;
+    uint64_t totalTicks = 0;
+    std::unique_ptr<EventStream> stream;
+};
+
+// How layered Taals line up: every layer is back on sam together once per super-cycle
+struct LayerAlignment {
+    uint64_t superCycleBeats = 0;              // LCM of the layers' beats
+    std::vector<uint64_t> cyclesPerSuperCycle; // Avartans of each layer in one super-cycle
+    std::vector<uint8_t> channels;             // Channel of each layer
+    uint64_t superCycles = 0;                  // Super-cycles rendered
+};
 
 class MIDIHandler {
 public:
+    /**
+     * @brief Renders the complete Standard MIDI File for the given Taal into memory.
+     *
+     * One matra is one quarter note at the tempo's BPM, on the grid chosen by planLaykari.
+     * One avartan is encoded once per laykari (or taken from CycleCache::shared()) and
+     * replicated for every cycle. A tanpura and lehra are generated lazily as event streams
+     * and either written as their own Format 1 tracks or merged with the tabla into the
+     * single Format 0 track a cycle at a time, so no track is ever buffered whole.
+     * MIDIHandler is safe to use from many threads.
+     *
+     * @param taal The Taal structure containing rhythmic pattern and metadata.
+     * @param tempo The Tempo object specifying BPM (beats per minute).
+     * @param raag The name of the Raag (used for naming or metadata purposes).
+     * @param options Track length.
+     * @return The bytes of the MIDI file.
+     */
+    std::vector<uint8_t> renderTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const RenderOptions& options = {}) const;
+
+    /**
+     * @brief Renders into midiData, replacing its contents and reusing its capacity.
+     *
+     * context is reset first and supplies all scratch memory. A Format 0 tabla render reserves
+     * the exact file size up front; once context and midiData are warm, it does not allocate.
+     */
+    void renderTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const RenderOptions& options,
+                        RenderContext& context, std::vector<uint8_t>& midiData) const;
+
+    /**
+     * @brief Streams the Taal to outputPath without any console output.
+     *
+     * Peak memory is constant regardless of the track length.
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void writeTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath, const RenderOptions& options = {}) const;
+
+    /**
+     * @brief Streams the Taal to outputPath using context's arena and file buffer.
+     *
+     * The overloads without a context use a thread-local one, so repeated renders on the
+     * same thread (batch workers, server sessions) stop allocating after the first.
+     */
+    void writeTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath,
+                       const RenderOptions& options, RenderContext& context) const;
+
+    /**
+     * @brief Renders into context's output buffer and hands the finished file to sink as outputPath.
+     *
+     * @throws std::runtime_error if the sink cannot store the file.
+     */
+    void exportTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath,
+                        const RenderOptions& options, OutputSink& sink, RenderContext& context) const;
+
+    /**
+     * @brief Streams several Taals played against each other to outputPath, e.g. Jhaptaal over Teentaal.
+     *
+     * Every layer keeps one matra per quarter note, so the layers return to a common sam
+     * every LCM(beats) matras; options.cycles (or durationSeconds) counts these super-cycles,
+     * and each common sam gets a "Sam" marker. The first layer plays on options.channel and
+     * each further one on the next channel, selected as a GM2 drum kit. Layers are plans on
+     * one shared grid (alignLaykariPlans), each replaying its own single cycle lazily, so
+     * rendering is linear in the output however long the super-cycle. With Format 1 each
+     * layer is its own track. Tanpura and lehra are not added.
+     *
+     * @throws std::invalid_argument if there are fewer than 2 or more than 16 layers, or on
+     *         the options renderTaalMIDI rejects.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    LayerAlignment writeLayeredMIDI(const std::vector<Taal>& layers, const Tempo& tempo, const std::string& outputPath,
+                                    const RenderOptions& options = {}) const;
+
+    /**
+     * @brief The events a Format 0 render of the Taal would write, generated lazily.
+     *
+     * Consumers other than the SMF writer (e.g. AudioRenderer) see exactly the notes,
+     * velocities, channels and program changes of the MIDI file.
+     *
+     * @throws std::invalid_argument on the same options renderTaalMIDI rejects.
+     */
+    RenderEvents renderEvents(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                              const RenderOptions& options = {}) const;
+
     /**
      * @brief Generates a MIDI file representing the given Taal, Tempo, and Raag.
      *
@@ -14,8 +139,9 @@ public:
      * @param tempo The Tempo object specifying BPM (beats per minute).
      * @param raag The name of the Raag (used for naming or metadata purposes).
      * @param outputPath The file path to save the generated MIDI file. Default is "output/taal_track.mid".
+     * @param options Track length. Default is 4 cycles.
      */
-    void generateTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath = "output/taal_track.mid") const;
+    void generateTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath = "output/taal_track.mid", const RenderOptions& options = {}) const;
 };
 
 #endif // MIDIHANDLER_H
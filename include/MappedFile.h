@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * Pages are shared with every other process mapping the same file.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Maps the file at path.
+     *
+     * @throws std::runtime_error if the file cannot be opened or mapped.
+     */
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    const uint8_t* data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes = nullptr;
+    std::size_t length = 0;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,175 @@
+#ifndef MIDIENCODING_H
+#define MIDIENCODING_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+// Longest variable-length quantity for a 32-bit value
+constexpr std::size_t kMaxVarLenBytes = 5;
+
+// Longest channel voice event: delta time + status + two data bytes
+constexpr std::size_t kMaxChannelEventBytes = kMaxVarLenBytes + 3;
+
+// Bulk encoding stores whole words and may write up to this many bytes past the encoded end
+constexpr std::size_t kEncodeSlack = 8;
+
+// A delta-timed channel voice event, as input to encodeEvents
+struct ChannelEvent {
+    uint32_t deltaTime;
+    uint8_t status;
+    uint8_t data1;
+    uint8_t data2; // Ignored by program change and channel pressure
+};
+
+namespace midi_detail {
+    // VLQ length indexed by the count of leading zero bits of (value | 1)
+    constexpr std::array<uint8_t, 32> makeVarLenLengths() {
+        std::array<uint8_t, 32> lengths{};
+        for (int zeros = 0; zeros < 32; ++zeros) {
+            lengths[zeros] = static_cast<uint8_t>((32 - zeros + 6) / 7);
+        }
+        return lengths;
+    }
+    constexpr std::array<uint8_t, 32> kVarLenLengths = makeVarLenLengths();
+
+    // Continuation bits for every group but the lowest, indexed by VLQ length
+    constexpr uint64_t kContinuationBits[kMaxVarLenBytes + 1] = {
+        0, 0, 0x8000, 0x808000, 0x80808000, 0x8080808000,
+    };
+
+    // Data bytes per status nibble: program change (Cx) and channel pressure (Dx) take one
+    constexpr uint8_t kDataBytes[16] = {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 2, 2};
+
+    /**
+     * @brief Packs value as a VLQ into the low-addressed bytes of a word, without branches.
+     *
+     * Storing the word with memcpy writes the encoded bytes in order; `length` of them are meaningful.
+     */
+    inline uint64_t packVarLen(uint32_t value, std::size_t& length) {
+        length = kVarLenLengths[__builtin_clz(value | 1)];
+#ifdef __BMI2__
+        uint64_t groups = _pdep_u64(value, 0x7F7F7F7F7FULL); // 7-bit groups, least significant first
+#else
+        uint64_t wide = value;
+        uint64_t groups = (wide & 0x7F) | ((wide << 1) & 0x7F00) | ((wide << 2) & 0x7F0000) |
+                          ((wide << 3) & 0x7F000000) | ((wide << 4) & 0x7F00000000ULL);
+#endif
+        groups |= kContinuationBits[length];
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        return __builtin_bswap64(groups) >> (64 - 8 * length);
+#else
+        return groups << (64 - 8 * length);
+#endif
+    }
+}
+
+/**
+ * @brief Length in bytes of value as a variable-length quantity.
+ */
+inline std::size_t varLenSize(uint32_t value) {
+    return midi_detail::kVarLenLengths[__builtin_clz(value | 1)];
+}
+
+/**
+ * @brief Encodes value as a MIDI variable-length quantity.
+ *
+ * @return The number of bytes written to out (at most kMaxVarLenBytes).
+ */
+inline std::size_t encodeVarLen(uint32_t value, uint8_t* out) {
+    std::size_t length;
+    uint64_t packed = midi_detail::packVarLen(value, length);
+    std::memcpy(out, &packed, length);
+    return length;
+}
+
+/**
+ * @brief Encodes a delta-timed Note On/Off event.
+ *
+ * @return The number of bytes written to out (at most kMaxChannelEventBytes).
+ */
+inline std::size_t encodeNoteEvent(uint32_t deltaTime, uint8_t channel, uint8_t note, uint8_t velocity, bool isNoteOn, uint8_t* out) {
+    std::size_t length = encodeVarLen(deltaTime, out);
+    out[length++] = (isNoteOn ? 0x90 : 0x80) | channel; // Note On/Off + Channel
+    out[length++] = note;
+    out[length++] = velocity;
+    return length;
+}
+
+/**
+ * @brief Output bytes to reserve for encodeEvents on `count` events, slack included.
+ */
+constexpr std::size_t encodedSizeBound(std::size_t count) {
+    return count * kMaxChannelEventBytes + kEncodeSlack;
+}
+
+/**
+ * @brief Encodes events back to back in one pass, with no capacity checks.
+ *
+ * out must have room for encodedSizeBound(count) bytes; bytes past the returned length are scratch.
+ *
+ * @return The number of encoded bytes.
+ */
+inline std::size_t encodeEvents(const ChannelEvent* events, std::size_t count, uint8_t* out) {
+    uint8_t* start = out;
+    for (std::size_t i = 0; i < count; ++i) {
+        const ChannelEvent& event = events[i];
+        std::size_t length;
+        uint64_t packed = midi_detail::packVarLen(event.deltaTime, length);
+        std::memcpy(out, &packed, sizeof(packed));
+        out += length;
+        out[0] = event.status;
+        out[1] = event.data1;
+        out[2] = event.data2;
+        out += 1 + midi_detail::kDataBytes[event.status >> 4];
+    }
+    return out - start;
+}
+
+/**
+ * @brief Encodes one delta-timed channel event with running status.
+ *
+ * The status byte is left out when it equals runningStatus, which is then updated. A Note
+ * Off is written as a Note On with velocity 0, so it shares the Note On's status. out must
+ * have room for kMaxChannelEventBytes + kEncodeSlack bytes.
+ *
+ * @return The number of bytes written to out.
+ */
+inline std::size_t encodeRunningEvent(uint32_t deltaTime, uint8_t status, uint8_t data1, uint8_t data2,
+                                      uint8_t& runningStatus, uint8_t* out) {
+    if ((status & 0xF0) == 0x80) {
+        status |= 0x10;
+        data2 = 0;
+    }
+    std::size_t length;
+    uint64_t packed = midi_detail::packVarLen(deltaTime, length);
+    std::memcpy(out, &packed, sizeof(packed));
+    out += length;
+
+    // Without a status byte the data bytes simply overwrite it
+    std::size_t fresh = status != runningStatus;
+    out[0] = status;
+    out[fresh] = data1;
+    out[fresh + 1] = data2;
+    runningStatus = status;
+    return length + fresh + midi_detail::kDataBytes[status >> 4];
+}
+
+/**
+ * @brief encodeEvents with running status (see encodeRunningEvent).
+ */
+inline std::size_t encodeEventsRunning(const ChannelEvent* events, std::size_t count, uint8_t& runningStatus,
+                                       uint8_t* out) {
+    uint8_t* start = out;
+    for (std::size_t i = 0; i < count; ++i) {
+        out += encodeRunningEvent(events[i].deltaTime, events[i].status, events[i].data1, events[i].data2,
+                                  runningStatus, out);
+    }
+    return out - start;
+}
+
+#endif // MIDIENCODING_H
@@ -0,0 +1,121 @@
+#ifndef MIDIFILEWRITER_H
+#define MIDIFILEWRITER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct ChannelEvent;
+class EventTimeline;
+
+/**
+ * @brief Streams a Standard MIDI File through a fixed-size buffer.
+ *
+ * The header chunk is written on construction. Each track is opened with beginTrack(),
+ * filled with events and closed with endTrack(), which flushes the buffer and
+ * backpatches the MTrk length. Memory use is constant regardless of track length.
+ * All multi-byte header fields are big-endian, as the SMF specification requires.
+ *
+ * With running status on, channel events leave out a status byte equal to the previous
+ * event's and write Note Offs as Note Ons with velocity 0; meta events and new tracks
+ * cancel the running status, as the specification requires.
+ */
+class MidiFileWriter {
+public:
+    static constexpr std::size_t kBufferSize = 64 * 1024;
+    static constexpr uint16_t kDefaultDivision = 480; // Pulses per quarter note (PPQN)
+
+    /**
+     * @brief Writes to a seekable stream (e.g. an std::ofstream opened in binary mode).
+     */
+    MidiFileWriter(std::ostream& out, uint16_t format, uint16_t trackCount, uint16_t division = kDefaultDivision);
+
+    /**
+     * @brief Appends to an in-memory buffer.
+     */
+    MidiFileWriter(std::vector<uint8_t>& out, uint16_t format, uint16_t trackCount, uint16_t division = kDefaultDivision);
+
+    MidiFileWriter(const MidiFileWriter&) = delete;
+    MidiFileWriter& operator=(const MidiFileWriter&) = delete;
+
+    void setRunningStatus(bool enabled) { runningStatusEnabled = enabled; }
+    bool usesRunningStatus() const { return runningStatusEnabled; }
+
+    /**
+     * @brief Declares the running status in effect after channel events written with writeBytes.
+     */
+    void resumeRunningStatus(uint8_t status) { runningStatus = status; }
+
+    void beginTrack();
+
+    /**
+     * @brief Flushes the track and patches its length.
+     *
+     * @throws std::runtime_error if the output fails or the track exceeds 4 GiB.
+     */
+    void endTrack();
+
+    void writeByte(uint8_t value) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        buffer[used++] = value;
+    }
+
+    void writeBytes(const uint8_t* data, std::size_t size);
+    void writeVarLen(uint32_t value);
+
+    void writeNoteEvent(uint32_t deltaTime, uint8_t channel, uint8_t note, uint8_t velocity, bool isNoteOn);
+    void writeProgramChange(uint32_t deltaTime, uint8_t channel, uint8_t program);
+
+    /**
+     * @brief Writes any channel voice event; program change and channel pressure take one data byte.
+     */
+    void writeChannelEvent(uint32_t deltaTime, uint8_t status, uint8_t data1, uint8_t data2);
+
+    /**
+     * @brief Bulk-encodes channel events directly into the output buffer (see encodeEvents).
+     */
+    void writeEvents(const ChannelEvent* events, std::size_t count);
+
+    /**
+     * @brief Encodes events [begin, end) of a timeline, deltas taken from (and advancing) lastTick.
+     */
+    void writeTimeline(const EventTimeline& timeline, std::size_t begin, std::size_t end, uint64_t& lastTick);
+    void writeTempo(uint32_t deltaTime, uint32_t microsecondsPerQuarter);
+    void writeMetaText(uint32_t deltaTime, uint8_t type, std::string_view text);
+    void writeEndOfTrack(uint32_t deltaTime = 0);
+
+    /**
+     * @brief Bytes written to the current (or last) track so far.
+     */
+    uint64_t trackLength() const { return trackBytes + used; }
+
+    /**
+     * @brief Bytes of the whole file so far, header included.
+     */
+    uint64_t size() const { return written + used; }
+
+private:
+    void writeHeaderChunk(uint16_t format, uint16_t trackCount, uint16_t division);
+    void writeRaw(const uint8_t* data, std::size_t size);
+    void flush();
+
+    std::ostream* stream = nullptr;
+    std::vector<uint8_t>* memory = nullptr;
+
+    std::array<uint8_t, kBufferSize> buffer;
+    std::size_t used = 0;
+    uint64_t trackBytes = 0;   // Bytes of the current track already flushed
+    uint64_t lengthField = 0;  // Output offset of the current track's length field
+    uint64_t written = 0;      // Bytes flushed to the output in total
+    bool inTrack = false;
+    bool runningStatusEnabled = false;
+    uint8_t runningStatus = 0; // Status of the last channel event; 0 when none is in effect
+};
+
+#endif // MIDIFILEWRITER_H
@@ -0,0 +1,83 @@
+#ifndef MIDISINK_H
+#define MIDISINK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Destination of live MIDI messages sent by the PlaybackScheduler.
+ */
+class MidiSink {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~MidiSink() = default;
+
+    /**
+     * @brief Sends one complete MIDI message (status byte plus data bytes).
+     *
+     * @param deadline The monotonic time the message was scheduled for.
+     */
+    virtual void send(const uint8_t* message, std::size_t size, Clock::time_point deadline) = 0;
+};
+
+/**
+ * @brief Writes one line per message: scheduled and actual time (us since the first message) and the bytes in hex.
+ *
+ * Meant for tests and timing analysis.
+ */
+class LogSink : public MidiSink {
+public:
+    explicit LogSink(std::ostream& out);
+    void send(const uint8_t* message, std::size_t size, Clock::time_point deadline) override;
+
+private:
+    std::ostream& out;
+    Clock::time_point origin;
+    bool started = false;
+};
+
+/**
+ * @brief Writes raw MIDI bytes to a named pipe, creating it if needed.
+ *
+ * Opening blocks until a reader connects.
+ */
+class FifoSink : public MidiSink {
+public:
+    explicit FifoSink(const std::string& path);
+    ~FifoSink() override;
+    void send(const uint8_t* message, std::size_t size, Clock::time_point deadline) override;
+
+private:
+    int fd = -1;
+};
+
+#ifdef TANSEN_WITH_RTMIDI
+class RtMidiOut;
+
+/**
+ * @brief Sends messages to an RtMidi virtual output port (ALSA sequencer on Linux).
+ */
+class RtMidiSink : public MidiSink {
+public:
+    explicit RtMidiSink(const std::string& portName);
+    ~RtMidiSink() override;
+    void send(const uint8_t* message, std::size_t size, Clock::time_point deadline) override;
+
+private:
+    std::unique_ptr<RtMidiOut> output;
+};
+#endif
+
+/**
+ * @brief Creates a sink from a command-line spec: "log" (stdout), "log:<file>", "fifo:<path>" or "rtmidi[:<port>]".
+ *
+ * @throws std::invalid_argument for an unknown spec, std::runtime_error if the sink cannot be opened.
+ */
+std::unique_ptr<MidiSink> makeMidiSink(const std::string& spec);
+
+#endif // MIDISINK_H
@@ -0,0 +1,104 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include "ByteOrder.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Read-only index from taal names to catalog entries.
+ *
+ * Every taal is reachable by its system-qualified name ("hindustani/Jhampa"), its bare name
+ * and its aliases. Names are matched ignoring ASCII case. A bare name shared by several
+ * systems maps to all of their entries, so callers can report the ambiguity instead of
+ * picking one. Keys are placed with a minimal perfect hash (hash and displace), so a lookup
+ * is one hash, one seed read and one key comparison, with no probing at any size.
+ *
+ * Serialized layout (little-endian uint32 throughout, no alignment requirement):
+ *   Header    keyCount, bucketCount, targetCount, trigramCount, stringsSize
+ *   Seeds     bucketCount displacement seeds; kDirectSlot marks a bucket placed directly
+ *   Slots     keyCount x {keyOffset, keyLength, firstTarget, targetCount}
+ *   Targets   entry indices, grouped by slot
+ *   Trigrams  (trigramCount + 1) x {trigram, firstPosting}, sorted by trigram
+ *   Postings  slot indices of the unqualified keys containing each trigram
+ *   Strings   key bytes
+ */
+class NameIndex {
+public:
+    static constexpr uint32_t kDirectSlot = 0x80000000;
+
+    // Collects names at catalog build time
+    class Builder {
+    public:
+        /**
+         * @brief Indexes entry under system/name, name, and each alias with and without the system.
+         */
+        void addTaal(std::string_view system, std::string_view name, const std::vector<std::string>& aliases,
+                     uint32_t entry);
+
+        /**
+         * @brief Serializes the index.
+         *
+         * @throws std::runtime_error if the names exceed the format's 32-bit limits.
+         */
+        std::vector<uint8_t> build() const;
+
+    private:
+        void add(std::string_view key, uint32_t entry);
+
+        std::vector<std::pair<std::string, uint32_t>> keys; // Normalized key, entry
+    };
+
+    // Entries a name resolves to: none, one, or several for an ambiguous bare name
+    struct Match {
+        const uint8_t* targets = nullptr;
+        uint32_t count = 0;
+
+        uint32_t entry(uint32_t i) const { return load32(targets + i * sizeof(uint32_t)); }
+    };
+
+    NameIndex() = default;
+
+    /**
+     * @brief Reads an index produced by Builder::build; data must outlive the NameIndex.
+     *
+     * @throws std::runtime_error if the sections do not fit in size bytes.
+     */
+    NameIndex(const uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Resolves a name without allocating.
+     *
+     * @throws std::runtime_error if the index is corrupt.
+     */
+    Match find(std::string_view name) const;
+
+    /**
+     * @brief Entries whose names share the most trigrams with name, best first.
+     */
+    std::vector<uint32_t> suggest(std::string_view name, std::size_t limit = 3) const;
+
+    std::size_t size() const { return keyCount; }
+
+private:
+    uint32_t slotOf(uint64_t hash) const;
+    std::string_view key(uint32_t slot) const;
+
+    uint32_t keyCount = 0;
+    uint32_t bucketCount = 0;
+    uint32_t targetCount = 0;
+    uint32_t trigramCount = 0;
+    const uint8_t* seeds = nullptr;
+    const uint8_t* slots = nullptr;
+    const uint8_t* targets = nullptr;
+    const uint8_t* trigrams = nullptr;
+    const uint8_t* postings = nullptr;
+    const uint8_t* strings = nullptr;
+    uint32_t stringsSize = 0;
+};
+
+#endif // NAMEINDEX_H
@@ -0,0 +1,135 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Destination of finished MIDI files for mass export.
+ *
+ * write() may be called from many threads at once. Call finish() once all writes are done;
+ * until then some sinks may still hold data in flight.
+ */
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    /**
+     * @brief Stores one complete file under path. data need only stay valid for the call.
+     *
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    virtual void write(const std::string& path, const uint8_t* data, std::size_t size) = 0;
+
+    /**
+     * @brief Completes pending writes and finalizes the output.
+     */
+    virtual void finish() {}
+
+    /**
+     * @brief Whether paths name files on disk (so their directories must exist) rather than archive members.
+     */
+    virtual bool createsFiles() const { return true; }
+};
+
+/**
+ * @brief Writes each file with open, a single pwrite loop and close; no stream objects involved.
+ */
+class PwriteSink : public OutputSink {
+public:
+    void write(const std::string& path, const uint8_t* data, std::size_t size) override;
+};
+
+/**
+ * @brief Packs every file into one uncompressed (ustar) tar archive.
+ *
+ * Each write reserves its region of the archive under a lock and then fills it with pwrite,
+ * so concurrent writers only serialize on the offset bump. finish() appends an index member
+ * (".tansen-index": one "<data offset> <size> <path>" line per file) for random access
+ * without scanning, then the end-of-archive blocks.
+ */
+class TarSink : public OutputSink {
+public:
+    static constexpr std::size_t kBlockSize = 512;
+    static constexpr const char* kIndexName = ".tansen-index";
+
+    explicit TarSink(const std::string& archivePath);
+    ~TarSink() override;
+
+    TarSink(const TarSink&) = delete;
+    TarSink& operator=(const TarSink&) = delete;
+
+    void write(const std::string& path, const uint8_t* data, std::size_t size) override;
+    void finish() override;
+    bool createsFiles() const override { return false; }
+
+private:
+    struct IndexEntry {
+        uint64_t offset;
+        uint64_t size;
+        std::string path;
+    };
+
+    uint64_t append(const std::string& path, const uint8_t* data, std::size_t size);
+
+    std::string archivePath;
+    int fd = -1;
+    std::time_t modified;
+    std::mutex mutex;
+    uint64_t end = 0; // Offset of the next header
+    std::vector<IndexEntry> index;
+    bool finished = false;
+};
+
+#ifdef TANSEN_WITH_URING
+struct io_uring;
+
+/**
+ * @brief Queues files and writes each batch with one io_uring submission.
+ *
+ * Files are opened as they are queued; the writes and closes of a whole batch then go to the
+ * kernel in a single io_uring_submit. Data is copied into the queue, so memory use is bounded
+ * by batchSize files.
+ */
+class UringSink : public OutputSink {
+public:
+    static constexpr unsigned kDefaultBatchSize = 256;
+
+    explicit UringSink(unsigned batchSize = kDefaultBatchSize);
+    ~UringSink() override;
+
+    UringSink(const UringSink&) = delete;
+    UringSink& operator=(const UringSink&) = delete;
+
+    void write(const std::string& path, const uint8_t* data, std::size_t size) override;
+    void finish() override;
+
+private:
+    struct Pending {
+        int fd;
+        std::string path;
+        std::vector<uint8_t> data;
+    };
+
+    void submitLocked();
+
+    unsigned batchSize;
+    std::unique_ptr<io_uring> ring;
+    std::mutex mutex;
+    std::vector<Pending> pending;
+};
+#endif
+
+/**
+ * @brief Creates a sink from a command-line spec: "pwrite", "tar:<archive>" or "uring".
+ *
+ * @throws std::invalid_argument for an unknown spec, std::runtime_error if the sink cannot be opened.
+ */
+std::unique_ptr<OutputSink> makeOutputSink(const std::string& spec);
+
+#endif // OUTPUTSINK_H
@@ -0,0 +1,82 @@
+#ifndef PLAYBACKSCHEDULER_H
+#define PLAYBACKSCHEDULER_H
+
+#include "MIDIHandler.h"
+#include "MidiSink.h"
+#include "TaalManager.h"
+#include "Tempo.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Histogram of send lateness (actual minus scheduled time) in 1 us buckets up to kBuckets us.
+ */
+class JitterHistogram {
+public:
+    static constexpr std::size_t kBuckets = 2000;
+
+    void record(std::chrono::nanoseconds lateness);
+
+    uint64_t count() const { return samples; }
+    double meanMicroseconds() const { return samples ? totalNanoseconds / 1000.0 / samples : 0.0; }
+    double maxMicroseconds() const { return maxNanoseconds / 1000.0; }
+
+    /**
+     * @brief Upper bound, in microseconds, below which p percent of the samples fall.
+     */
+    double percentileMicroseconds(double p) const;
+
+    /**
+     * @brief Prints the summary and the non-empty buckets.
+     */
+    void print(std::ostream& out) const;
+
+private:
+    std::array<uint64_t, kBuckets + 1> buckets{}; // Last bucket collects everything later than kBuckets us
+    uint64_t samples = 0;
+    double totalNanoseconds = 0.0;
+    int64_t maxNanoseconds = 0;
+};
+
+struct PlaybackOptions {
+    uint64_t cycles = 0; // 0 plays until stop() is called
+    std::chrono::microseconds spinMargin{200}; // Sleep until this close to a deadline, then spin
+    bool realtimePriority = false;             // Try SCHED_FIFO; ignored if not permitted
+    RenderOptions voicing;                     // Channel and velocities; the length fields are unused
+};
+
+/**
+ * @brief Plays a Taal live at a given Tempo through a MidiSink.
+ *
+ * Every event has an absolute deadline computed from the start time on the monotonic
+ * clock, so late wake-ups never accumulate into drift.
+ */
+class PlaybackScheduler {
+public:
+    explicit PlaybackScheduler(MidiSink& sink, const PlaybackOptions& options = {});
+
+    /**
+     * @brief Plays until the requested cycles are done or stop() is called. Blocks the caller.
+     */
+    void play(const Taal& taal, const Tempo& tempo);
+
+    /**
+     * @brief Asks play() to return after the current event. Safe from other threads and signal handlers.
+     */
+    void stop() { stopping.store(true, std::memory_order_relaxed); }
+
+    const JitterHistogram& jitter() const { return histogram; }
+
+private:
+    void waitUntil(MidiSink::Clock::time_point deadline) const;
+
+    MidiSink& sink;
+    PlaybackOptions options;
+    JitterHistogram histogram;
+    std::atomic<bool> stopping{false};
+};
+
+#endif // PLAYBACKSCHEDULER_H
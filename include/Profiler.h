@@ -0,0 +1,129 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Hot-path instrumentation, enabled with -DTANSEN_ENABLE_PROFILING=ON.
+//
+//   TANSEN_SCOPE("encode");          // Times the enclosing scope as a trace span
+//   TANSEN_COUNT(Events, n);         // Adds n to a Profiler::Counter
+//   TANSEN_COUNT_ALLOCATIONS();      // Adds this scope's heap allocations to the Allocations counter
+//
+// Without the option every macro expands to nothing and its arguments are not evaluated.
+
+#ifdef TANSEN_ENABLE_PROFILING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief Process-wide collector of timed spans and counters.
+ *
+ * Each thread records into its own buffer, so recording never contends across threads.
+ * Buffers outlive their threads; report once the work being measured has finished.
+ */
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Counter : std::size_t {
+        Renders,     // Complete MIDI files produced
+        Events,      // Channel events written
+        Bytes,       // MIDI bytes produced
+        Allocations, // Heap allocations made inside counted scopes
+        Lookups,     // Taal lookups by name
+        CounterCount
+    };
+
+    static constexpr std::size_t kMaxSpansPerThread = 1 << 20;
+
+    static Profiler& instance();
+
+    void addSpan(const char* name, Clock::time_point start, Clock::time_point end);
+    void add(Counter counter, uint64_t amount);
+
+    uint64_t counter(Counter counter) const;
+
+    /**
+     * @brief Heap allocations made by the calling thread so far.
+     */
+    static uint64_t threadAllocations();
+
+    /**
+     * @brief Writes every span as a Chrome trace ("X" complete events), viewable in chrome://tracing or Perfetto.
+     */
+    void writeChromeTrace(std::ostream& out) const;
+
+    /**
+     * @brief Prints per-phase timings and the counters, with per-render averages.
+     */
+    void printStats(std::ostream& out) const;
+
+private:
+    struct Span {
+        const char* name;
+        int64_t startNanoseconds;
+        int64_t durationNanoseconds;
+    };
+
+    struct ThreadState {
+        uint32_t id;
+        mutable std::mutex mutex;
+        std::vector<Span> spans;
+        uint64_t dropped = 0;
+        std::array<std::atomic<uint64_t>, CounterCount> counters{};
+    };
+
+    Profiler();
+    ThreadState& threadState();
+
+    Clock::time_point origin;
+    mutable std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadState>> threads;
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), start(Profiler::Clock::now()) {}
+    ~ProfileScope() { Profiler::instance().addSpan(name, start, Profiler::Clock::now()); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    Profiler::Clock::time_point start;
+};
+
+class AllocationScope {
+public:
+    AllocationScope() : start(Profiler::threadAllocations()) {}
+    ~AllocationScope() { Profiler::instance().add(Profiler::Allocations, Profiler::threadAllocations() - start); }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    uint64_t start;
+};
+
+#define TANSEN_PROFILE_CONCAT_(a, b) a##b
+#define TANSEN_PROFILE_CONCAT(a, b) TANSEN_PROFILE_CONCAT_(a, b)
+#define TANSEN_SCOPE(name) ProfileScope TANSEN_PROFILE_CONCAT(tansenScope, __LINE__)(name)
+#define TANSEN_COUNT(counter, amount) Profiler::instance().add(Profiler::counter, (amount))
+#define TANSEN_COUNT_ALLOCATIONS() AllocationScope TANSEN_PROFILE_CONCAT(tansenAllocations, __LINE__)
+
+#else
+
+#define TANSEN_SCOPE(name) ((void)0)
+#define TANSEN_COUNT(counter, amount) ((void)0)
+#define TANSEN_COUNT_ALLOCATIONS() ((void)0)
+
+#endif // TANSEN_ENABLE_PROFILING
+
+#endif // PROFILER_H
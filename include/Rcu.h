@@ -0,0 +1,76 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Epoch-based read-copy-update for data published through an atomic pointer.
+ *
+ * Readers announce the current epoch in their own slot on entry and clear it on exit; they
+ * never take a lock or wait. A writer swaps the published pointer, then retires the old
+ * version, which is freed once every reader has either left or entered after the swap.
+ * A reader that stays inside a section only delays reclamation, never the writer.
+ */
+class Rcu {
+public:
+    static Rcu& instance();
+
+    ~Rcu();
+
+    /**
+     * @brief Read-side critical section; sections may nest. Not movable between threads.
+     */
+    class ReadGuard {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    /**
+     * @brief Frees object once no reader can still hold it. Call after unpublishing it.
+     */
+    template <typename T>
+    void retire(const T* object) {
+        retire([object] { delete object; });
+    }
+
+    void retire(std::function<void()> deleter);
+
+    /**
+     * @brief Frees every retired object no reader can reach any more.
+     *
+     * @return The number still waiting for readers.
+     */
+    std::size_t reclaim();
+
+private:
+    struct Reader {
+        std::atomic<uint64_t> epoch{0}; // 0 while outside any section
+        std::atomic<bool> inUse{false};
+        Reader* next = nullptr;
+    };
+
+    struct Retired {
+        uint64_t epoch;
+        std::function<void()> deleter;
+    };
+
+    Reader* acquireReader();
+    static void releaseReader(Reader* reader);
+    uint64_t oldestActiveEpoch() const;
+
+    std::atomic<uint64_t> epoch{1};
+    std::atomic<Reader*> readers{nullptr}; // Never shrinks; slots are reused as threads come and go
+    std::mutex retiredMutex;
+    std::vector<Retired> retired;
+};
+
+#endif // RCU_H
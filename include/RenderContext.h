@@ -0,0 +1,77 @@
+#ifndef RENDERCONTEXT_H
+#define RENDERCONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reusable scratch state for renders: a monotonic arena, a buffered output file and an output buffer.
+ *
+ * Per-render working memory (the laykari plan, cycle handles, the track name) comes from
+ * resource() and is released all at once by reset(). If a render outgrows the arena, the
+ * overflow goes to the heap and the next reset() enlarges the arena, so once warmed up a
+ * context renders without touching the heap. Not thread-safe: use one per thread.
+ */
+class RenderContext {
+public:
+    static constexpr std::size_t kDefaultArenaBytes = 16 * 1024;
+    static constexpr std::size_t kFileBufferBytes = 4096;
+
+    explicit RenderContext(std::size_t arenaBytes = kDefaultArenaBytes);
+
+    RenderContext(const RenderContext&) = delete;
+    RenderContext& operator=(const RenderContext&) = delete;
+
+    /**
+     * @brief Starts the next job: frees everything allocated from resource() and closes the file.
+     */
+    void reset();
+
+    std::pmr::memory_resource* resource() { return &*arena; }
+
+    /**
+     * @brief Opens path for binary writing through the context's own stream buffer.
+     *
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    std::ofstream& openFile(const std::string& path);
+
+    /**
+     * @brief Buffer for whole rendered files handed to an OutputSink; keeps its capacity across jobs.
+     */
+    std::vector<uint8_t>& output() { return outputBuffer; }
+
+    std::size_t arenaBytes() const { return capacity; }
+
+    // Thread-local context used by the MIDIHandler overloads that do not take one
+    static RenderContext& forThisThread();
+
+private:
+    // Heap fallback for the arena that records how far a render overflowed
+    class OverflowResource : public std::pmr::memory_resource {
+    public:
+        std::size_t overflowBytes = 0;
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::size_t capacity;
+    std::unique_ptr<std::byte[]> buffer;
+    OverflowResource overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;
+
+    std::unique_ptr<char[]> fileBuffer;
+    std::ofstream file;
+    std::vector<uint8_t> outputBuffer;
+};
+
+#endif // RENDERCONTEXT_H
@@ -0,0 +1,68 @@
+#ifndef RENDERSERVER_H
+#define RENDERSERVER_H
+
+#include "LatencyStats.h"
+#include "MIDIHandler.h"
+#include "TaalManager.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Long-running server that keeps the catalog loaded and executes CLI commands over a Unix domain socket.
+ *
+ * Clients send one command per line, in the grammar of parseCommand, plus "stats".
+ * Every response is a header line "<KIND> <length>\n" followed by length payload bytes:
+ *   MIDI  the rendered Standard MIDI File (Generate without an Output clause)
+ *   FILE  the path the MIDI file was written to
+ *   TEXT  a listing, confirmation or the stats report
+ *   ERR   an error message
+ * Each client connection is served by its own thread and has its own session tempo.
+ */
+class RenderServer {
+public:
+    RenderServer(TaalManager& taalManager, const MIDIHandler& midiHandler, const std::string& socketPath);
+    ~RenderServer();
+
+    RenderServer(const RenderServer&) = delete;
+    RenderServer& operator=(const RenderServer&) = delete;
+
+    /**
+     * @brief Binds the socket (replacing a stale one) and serves clients until stop() is called.
+     *
+     * @throws std::runtime_error if the socket cannot be created.
+     */
+    void run();
+
+    /**
+     * @brief Stops accepting clients, closes open connections and makes run() return.
+     *
+     * Not async-signal-safe; call it from a normal thread (e.g. one waiting in sigwait).
+     */
+    void stop();
+
+    const LatencyStats& latency() const { return requestLatency; }
+
+private:
+    void serveClient(int client);
+    std::string statsReport() const;
+
+    TaalManager& taalManager;
+    const MIDIHandler& midiHandler;
+    std::string socketPath;
+
+    std::atomic<int> listener{-1}; // Read by stop() on another thread
+    std::atomic<bool> stopping{false};
+    std::mutex clientsMutex;
+    std::condition_variable clientsDone;
+    std::vector<int> clients; // Open connections, each served by a detached thread
+
+    LatencyStats requestLatency;
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+#endif // RENDERSERVER_H
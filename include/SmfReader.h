@@ -0,0 +1,92 @@
+#ifndef SMFREADER_H
+#define SMFREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief One event of a track, viewed in place.
+ *
+ * payload points into the file's bytes and stays valid as long as they do.
+ */
+struct SmfEvent {
+    uint64_t tick = 0;                // Absolute time, in ticks from the start of the track
+    uint8_t status = 0;               // With running status applied; 0xFF meta, 0xF0/0xF7 sysex
+    uint8_t metaType = 0;             // Meta events only
+    uint8_t data1 = 0;                // Channel events only
+    uint8_t data2 = 0;                // Channel events with two data bytes only
+    const uint8_t* payload = nullptr; // Meta and sysex events only
+    uint32_t length = 0;              // Bytes at payload
+
+    uint8_t channel() const { return status & 0x0F; }
+    bool isNoteOn() const { return (status & 0xF0) == 0x90 && data2 != 0; } // Velocity 0 is a Note Off
+    bool isMeta(uint8_t type) const { return status == 0xFF && metaType == type; }
+};
+
+/**
+ * @brief Standard MIDI File parser over bytes already in memory, typically a MappedFile.
+ *
+ * Construction only walks the chunk headers; events are decoded one at a time as a
+ * TrackReader advances, so nothing is copied or allocated per event. Formats 0, 1 and 2
+ * are read alike, track by track.
+ */
+class SmfReader {
+public:
+    /**
+     * @brief Sequential reader of one MTrk chunk.
+     */
+    class TrackReader {
+    public:
+        /**
+         * @brief Decodes the next event into event.
+         *
+         * @return false after End of Track, or at the end of a chunk that lacks one.
+         * @throws std::runtime_error on a truncated or malformed event.
+         */
+        bool next(SmfEvent& event);
+
+    private:
+        friend class SmfReader;
+        TrackReader(const uint8_t* file, const uint8_t* begin, const uint8_t* end)
+            : file(file), position(begin), end(end) {}
+
+        uint32_t readVarLen();
+        [[noreturn]] void fail(const char* what) const;
+
+        const uint8_t* file; // Start of the file, for error offsets
+        const uint8_t* position;
+        const uint8_t* end;
+        uint64_t tick = 0;
+        uint8_t runningStatus = 0;
+    };
+
+    /**
+     * @throws std::runtime_error if the bytes do not start with an MThd chunk or a chunk
+     *         runs past the end.
+     */
+    SmfReader(const uint8_t* data, std::size_t size);
+
+    uint16_t format() const { return fileFormat; }
+
+    /**
+     * @brief Ticks per quarter note, or 0 for SMPTE timing.
+     */
+    uint16_t ticksPerQuarter() const { return (division & 0x8000) ? 0 : division; }
+
+    /**
+     * @brief Number of MTrk chunks actually present; unknown chunk types are skipped.
+     */
+    std::size_t trackCount() const { return tracks.size(); }
+
+    TrackReader track(std::size_t index) const;
+
+private:
+    const uint8_t* data;
+    uint16_t fileFormat = 0;
+    uint16_t division = 0;
+    std::vector<std::pair<const uint8_t*, const uint8_t*>> tracks; // Event bytes of each MTrk
+};
+
+#endif // SMFREADER_H
@@ -0,0 +1,87 @@
+#ifndef TAALIMPORTER_H
+#define TAALIMPORTER_H
+
+#include "SmfReader.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+struct ImportOptions {
+    int channel = 9;              // Channel whose notes are bols (0-based); -1 reads every channel
+    std::size_t maxBeats = 128;   // Longest cycle considered, in strokes
+    double tolerance = 0.1;       // Fraction of strokes allowed to differ from the detected cycle
+};
+
+// The cycle recovered from one recording
+struct ImportedTaal {
+    std::string name;
+    std::string path;
+    int beats = 0;                  // Cycle length in quarter notes
+    std::vector<std::string> bols;  // One cycle, starting on sam
+    std::size_t cycles = 0;         // Complete cycles in the recording
+    double match = 0.0;             // Fraction of strokes agreeing with the cycle
+};
+
+// Summary of an import run
+struct ImportReport {
+    std::size_t files = 0;
+    std::size_t failed = 0;
+    double wallSeconds = 0.0;
+    double filesPerSecond = 0.0;
+    std::vector<ImportedTaal> taals; // In input order, failed files left out
+    std::vector<std::string> errors;
+};
+
+/**
+ * @brief Recovers Taal definitions from tabla MIDI recordings.
+ *
+ * Note Ons on the chosen channel are mapped back to bols through the BolTable (notes
+ * played together count once, the first track's), then the shortest period the stroke
+ * sequence repeats with, within tolerance, is taken as the cycle. Each position of the
+ * cycle gets the bol most often played there. A longer multiple of that period wins
+ * when the recording accents its first stroke more strongly (Ektaal's two identical
+ * halves), and the most accented position is taken as sam.
+ */
+class TaalImporter {
+public:
+    /**
+     * @brief Snapshots the BolTable's note mapping; later setNote calls are not seen.
+     */
+    explicit TaalImporter(const ImportOptions& options = {});
+
+    /**
+     * @brief Maps and imports one file; the Taal is named after the file.
+     *
+     * @throws std::runtime_error if the file is unreadable, malformed or has too few strokes.
+     */
+    ImportedTaal importFile(const std::string& path) const;
+
+    /**
+     * @throws std::runtime_error if the recording has too few strokes or SMPTE timing.
+     */
+    ImportedTaal import(const SmfReader& smf, const std::string& name) const;
+
+    /**
+     * @brief Imports every file on a work-stealing pool; 0 threads uses every hardware thread.
+     *
+     * A failing file is counted and reported in ImportReport::errors; it does not stop the run.
+     */
+    ImportReport importFiles(const std::vector<std::string>& paths, unsigned threads = 0) const;
+
+    /**
+     * @brief Builds a catalog in the taals.json format with every Taal under system.
+     *
+     * Taals with identical cycles become one entry, the later names its aliases;
+     * distinct Taals with the same name get numbered suffixes.
+     */
+    static Json::Value toCatalog(const std::vector<ImportedTaal>& taals, const std::string& system);
+
+private:
+    ImportOptions options;
+    std::array<std::string, 128> bolNames; // Bol for each note; "Note<n>" where none is mapped
+};
+
+#endif // TAALIMPORTER_H
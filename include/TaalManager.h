@@ -1,27 +1,91 @@
 #ifndef TAALMANAGER_H
 #define TAALMANAGER_H
 
+#include "BolTable.h"
+#include "LatencyStats.h"
+#include "NameIndex.h"
+#include "Rcu.h"
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <json/json.h>
 
+class BinaryCatalog;
+
 // Taal structure
 struct Taal {
     std::string name;
+    std::string system; // "hindustani", "carnatic"...; empty for Taals added with addTaal
     int beats;
-    std::vector<std::string> bols;
+    std::vector<BolId> bols; // Interned through BolTable
 };
 
+// The optional "aliases" array of a Taal's JSON object; throws std::runtime_error if malformed
+std::vector<std::string> parseAliases(const Json::Value& taalData);
+
 class TaalManager {
 private:
-    std::unordered_map<std::string, Taal> taals;
+    struct Source;      // One loaded JSON or binary catalog
+    struct CustomTaals; // Append-only store of the Taals added with addTaal
+    struct Snapshot;    // Published state: a Source plus the custom Taals
+
+    static std::shared_ptr<const Source> loadSource(const std::string& filePath);
+    static std::shared_ptr<const Source> catalogSource(const std::string& filePath);
+
+    // Swaps in next and retires the previous snapshot; writerMutex must be held
+    void publish(std::unique_ptr<const Snapshot> next);
+
+    std::atomic<const Snapshot*> current;
+    std::mutex writerMutex; // Serializes loads, reloads and addTaal; readers never take it
+    std::string sourcePath;
+
+    LatencyStats reloadLatency;
+    std::atomic<uint64_t> reloads{0};
+    std::atomic<uint64_t> reloadFailures{0};
 
 public:
     TaalManager();
+    ~TaalManager();
+
+    TaalManager(const TaalManager&) = delete;
+    TaalManager& operator=(const TaalManager&) = delete;
+
+    // Loads a JSON catalog, or opens a compiled binary catalog (see openCatalog),
+    // replacing every Taal loaded or added so far
     void loadTaals(const std::string& filePath);
-    Taal getTaal(const std::string& name) const;
-    void listAllTaals() const;
+
+    // Maps a catalog produced by BinaryCatalog::compile, replacing everything loaded so far.
+    // Entries are decoded lazily, so this costs the same for any catalog size.
+    void openCatalog(const std::string& filePath);
+
+    // Loads the last loadTaals/openCatalog path again and publishes it atomically. Custom Taals
+    // are kept unless the new catalog defines their names. On failure the current catalog stays.
+    // Returns the time taken, in milliseconds.
+    double reload();
+
+    // Adds a custom Taal; existing names cannot be replaced, so outstanding references stay valid.
+    // Adds append in place rather than publishing a new snapshot, so each costs O(1) amortized.
+    void addTaal(const std::string& name, int beats, const std::vector<std::string>& bols);
+
+    // Resolves a qualified name ("hindustani/Jhampa"), a bare name or an alias, ignoring case.
+    // A bare name defined by several systems is rejected as ambiguous, listing the candidates;
+    // an unknown name is rejected with the closest matches.
+    // Never blocks: the catalog is read through an RCU snapshot. The returned reference stays
+    // valid while the caller holds an Rcu::ReadGuard, and otherwise until the next load or reload.
+    const Taal& getTaal(const std::string& name) const;
+    void listAllTaals(std::ostream& out = std::cout) const;
+
+    // Qualified names of every Taal, catalog entries first, then custom names
+    std::vector<std::string> listTaalNames() const;
+
+    // Build-and-publish time of every successful reload()
+    const LatencyStats& reloadStats() const { return reloadLatency; }
+    uint64_t reloadCount() const { return reloads.load(); }
+    uint64_t reloadFailureCount() const { return reloadFailures.load(); }
 };
 
 #endif // TAALMANAGER_H
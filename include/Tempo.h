@@ -1,12 +1,17 @@
 #ifndef TEMPO_H
 #define TEMPO_H
 
+#include "TempoMap.h"
+#include <cstdint>
 #include <string>
+#include <vector>
 
 class Tempo {
 private:
     std::string name; // Name of the tempo (e.g., Bilambit, Madhya, Drut)
     int bpm;          // Beats per minute (tempo value)
+    std::vector<int> stops; // For a laya that accelerates (or slows): the BPMs it passes through, bpm first
+    TempoRamp ramp = TempoRamp::Linear;
 
 public:
     /**
@@ -17,6 +22,24 @@ public:
      */
     Tempo(const std::string& name, int bpm);
 
+    /**
+     * @brief A tempo ramping through stops spread evenly over the render.
+     *
+     * @throws std::invalid_argument if there are no stops or one is not positive.
+     */
+    Tempo(const std::string& name, const std::vector<int>& stops, TempoRamp ramp);
+
+    /**
+     * @brief Builds a Tempo from a laya name or a plain BPM value, or a ramp through several.
+     *
+     * @param name "Bilambit" (60), "Madhya" (90), "Drut" (120), or a positive integer BPM;
+     *             or stops joined by '>' with an optional ":linear" or ":exp" ramp,
+     *             e.g. "Bilambit>Drut" or "60>90>180:exp".
+     * @return The matching Tempo.
+     * @throws std::invalid_argument if the name is neither a known laya nor a valid BPM.
+     */
+    static Tempo fromName(const std::string& name);
+
     /**
      * @brief Get the name of the tempo.
      * 
@@ -30,6 +53,23 @@ public:
      * @return The BPM value as an integer.
      */
     int getBPM() const;
+
+    /**
+     * @brief BPM at the end of the render; getBPM() unless the tempo ramps.
+     */
+    int getEndBPM() const { return stops.empty() ? bpm : stops.back(); }
+
+    bool ramps() const { return !stops.empty(); }
+
+    // The BPMs a ramp passes through, and how it moves between them; empty for a steady tempo
+    const std::vector<int>& getStops() const { return stops; }
+    TempoRamp getRamp() const { return ramp; }
+
+    /**
+     * @brief The tempo over a render of spanTicks: the stops spread evenly across it,
+     *        the last held beyond it.
+     */
+    TempoMap map(uint64_t spanTicks, uint16_t division) const;
 };
 
 #endif // TEMPO_H
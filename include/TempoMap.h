@@ -0,0 +1,97 @@
+#ifndef TEMPOMAP_H
+#define TEMPOMAP_H
+
+#include <cstdint>
+#include <vector>
+
+// How the tempo moves from one point of a TempoMap to the next
+enum class TempoRamp : uint8_t {
+    Linear,     // BPM changes by the same amount every beat
+    Exponential // BPM changes by the same ratio every beat
+};
+
+// A tempo the map passes through: BPM at an absolute tick
+struct TempoPoint {
+    uint64_t tick;
+    double bpm;
+};
+
+// One Set Tempo meta event approximating the map
+struct TempoChange {
+    uint64_t tick;
+    uint32_t microsecondsPerQuarter;
+};
+
+/**
+ * @brief Piecewise tempo over a tick grid, ramping between points and holding the last tempo.
+ *
+ * Conversions run in closed form within a segment; the seconds at which each segment
+ * starts are prefix sums, so tick -> seconds and seconds -> tick are a binary search
+ * over the segment starts plus O(1) arithmetic. A map is immutable once built and may be
+ * shared between threads.
+ */
+class TempoMap {
+public:
+    /**
+     * @brief A constant tempo.
+     *
+     * @throws std::invalid_argument if bpm is not positive or division is 0.
+     */
+    TempoMap(double bpm, uint16_t division);
+
+    /**
+     * @brief Ramps from each point to the next.
+     *
+     * @throws std::invalid_argument if there are no points, the first is not at tick 0,
+     *         ticks do not increase, a BPM is not positive or division is 0.
+     */
+    TempoMap(const std::vector<TempoPoint>& points, TempoRamp ramp, uint16_t division);
+
+    double secondsAt(uint64_t tick) const;
+
+    /**
+     * @brief First tick at or after the given time.
+     */
+    uint64_t tickAt(double seconds) const;
+
+    double bpmAt(uint64_t tick) const;
+
+    bool isConstant() const { return segments.size() == 1; }
+
+    uint16_t division() const { return ticksPerQuarter; }
+
+    /**
+     * @brief The fewest Set Tempo events, found greedily, that keep every tick up to endTick
+     *        within maxErrorSeconds of the map.
+     *
+     * Each event holds its tempo for as long as the error allows, and its tempo is chosen
+     * from the exact time at the end of its span, so rounding to whole microseconds does not
+     * accumulate. A constant stretch needs one event however long it is.
+     *
+     * @throws std::invalid_argument if maxErrorSeconds is not positive.
+     */
+    std::vector<TempoChange> tempoChanges(uint64_t endTick, double maxErrorSeconds) const;
+
+private:
+    struct Segment {
+        uint64_t startTick;
+        double startSeconds;
+        double startBPM;
+        double endBPM;   // Equal to startBPM in the final, open-ended segment
+        double quarters; // Length; 0 in the final segment
+    };
+
+    // Seconds and quarter notes from the start of a segment
+    double secondsInto(const Segment& segment, double quarters) const;
+    double quartersInto(const Segment& segment, double seconds) const;
+    double bpmInto(const Segment& segment, double quarters) const;
+    double quartersAtBPM(const Segment& segment, double bpm) const;
+    std::size_t segmentAt(uint64_t tick) const;
+
+    TempoRamp ramp = TempoRamp::Linear;
+    uint16_t ticksPerQuarter;
+    std::vector<uint64_t> starts;   // Start tick of each segment, searched on its own
+    std::vector<Segment> segments;
+};
+
+#endif // TEMPOMAP_H
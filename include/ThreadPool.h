@@ -0,0 +1,70 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size work-stealing thread pool.
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to its own deque and
+ * are popped LIFO; tasks submitted from outside are spread round-robin. An idle
+ * worker steals FIFO from the other deques before going to sleep.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param threads Number of workers. 0 uses std::thread::hardware_concurrency().
+     */
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a task. Tasks must not throw.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until every submitted task has finished.
+     */
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(unsigned index, Task& task);
+    bool steal(unsigned thief, Task& task);
+    void workerLoop(unsigned index);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<std::size_t> queued{0};  // Tasks sitting in a deque
+    std::atomic<std::size_t> pending{0}; // Tasks submitted but not yet finished
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
@@ -1,6 +1,7 @@
 #ifndef TAAL_H
 #define TAAL_H
 
+#include "BolTable.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -12,12 +13,12 @@ public:
 
     std::string getName() const;
     int getBeats() const;
-    std::vector<std::string> getBols() const;
+    const std::vector<BolId>& getBols() const;
 
 private:
     std::string name;
     int beats;
-    std::vector<std::string> bols;
+    std::vector<BolId> bols; // Interned through BolTable
 };
 
 class TaalManager {
@@ -25,7 +26,7 @@ public:
     void addTaal(const std::string& name, const std::vector<std::string>& bols);
     void removeTaal(const std::string& name);
     Taal* getTaal(const std::string& name);
-    std::unordered_map<std::string, Taal> getAllTals() const;
+    const std::unordered_map<std::string, Taal>& getAllTals() const;
 
     // JSON file handling
     void loadTalsFromJson(const std::string& filepath);
@@ -0,0 +1,98 @@
+#ifndef TANSEN_H
+#define TANSEN_H
+
+/*
+ * libtansen: the C interface for embedding Tansen in plugin hosts and language bindings.
+ *
+ * Every function returns a tansen_status; on failure, tansen_last_error() describes the
+ * error on the calling thread. No C++ exception crosses this interface. A catalog may be
+ * shared between threads, and renders may run on any number of threads at once.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define TANSEN_API __attribute__((visibility("default")))
+#else
+#define TANSEN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TANSEN_ABI_VERSION 1
+
+typedef enum tansen_status {
+    TANSEN_OK = 0,
+    TANSEN_ERROR_INVALID_ARGUMENT = 1, /* A null handle, bad option or unknown tempo, laykari or raag */
+    TANSEN_ERROR_NOT_FOUND = 2,        /* No Taal of that name */
+    TANSEN_ERROR_BUFFER_TOO_SMALL = 3, /* *size holds the bytes needed */
+    TANSEN_ERROR_IO = 4,               /* The catalog could not be read */
+    TANSEN_ERROR_INTERNAL = 5
+} tansen_status;
+
+typedef struct tansen_catalog tansen_catalog; /* A loaded catalog */
+typedef struct tansen_taal tansen_taal;       /* A Taal of a catalog, valid until the catalog is closed */
+
+/*
+ * Options of one render. Initialize with tansen_render_options_init, which also sets
+ * struct_size, so fields added by later versions keep their defaults for older callers.
+ */
+typedef struct tansen_render_options {
+    uint32_t struct_size;
+    uint64_t cycles;         /* Avartans to render when duration_seconds is not set (default 4, at most 1000000) */
+    double duration_seconds; /* If positive, render whole cycles until at least this long (at most 86400) */
+    uint8_t channel;         /* 0-based MIDI channel of the tabla (default 9) */
+    uint8_t velocity;        /* Velocity of every bol but sam (default 80) */
+    uint8_t sam_velocity;    /* Velocity of the first bol of each cycle (default 80) */
+    uint8_t tonic;           /* MIDI note of Sa for the tanpura and lehra (default 60) */
+    uint16_t format;         /* Standard MIDI File format, 0 or 1 */
+    uint8_t tanpura;         /* Nonzero adds a tanpura drone */
+    uint8_t lehra;           /* Nonzero adds a lehra in the raag's scale */
+    const char* laykari;     /* Laykari sequence, e.g. "1,2,4:tisra"; NULL plays barabar */
+    const char* raag;        /* Raag of the lehra and track title; NULL for none */
+} tansen_render_options;
+
+TANSEN_API void tansen_render_options_init(tansen_render_options* options);
+
+/*
+ * Message of the last failed call on this thread; empty if none. Valid until the thread's next call.
+ */
+TANSEN_API const char* tansen_last_error(void);
+
+/*
+ * Loads a JSON catalog or maps a compiled binary one (see `Tansen compile-catalog`).
+ */
+TANSEN_API tansen_status tansen_catalog_open(const char* path, tansen_catalog** catalog);
+
+TANSEN_API void tansen_catalog_close(tansen_catalog* catalog);
+
+/*
+ * Resolves a qualified name ("hindustani/Jhaptaal"), a bare name or an alias, ignoring case.
+ */
+TANSEN_API tansen_status tansen_catalog_find_taal(const tansen_catalog* catalog, const char* name,
+                                                  const tansen_taal** taal);
+
+TANSEN_API const char* tansen_taal_name(const tansen_taal* taal);
+TANSEN_API int tansen_taal_beats(const tansen_taal* taal);
+
+/*
+ * Renders a Standard MIDI File into buffer, without touching the filesystem.
+ *
+ * tempo is a laya ("Madhya"), a BPM ("96") or a ramp ("Madhya>Drut:exp"); options may be
+ * NULL for the defaults. *size receives the file's length. If capacity is smaller (e.g.
+ * a NULL buffer with capacity 0, to ask for the size) nothing is written and
+ * TANSEN_ERROR_BUFFER_TOO_SMALL is returned. Working memory is kept per thread and
+ * reused from one render to the next.
+ */
+TANSEN_API tansen_status tansen_render_midi(const tansen_taal* taal, const char* tempo,
+                                            const tansen_render_options* options, uint8_t* buffer,
+                                            size_t capacity, size_t* size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TANSEN_H */
@@ -0,0 +1,110 @@
+#include "Arrangement.h"
+#include "BolTable.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    constexpr uint8_t kTanpuraProgram = 104; // General MIDI Sitar, the nearest plucked drone
+    constexpr uint8_t kLehraProgram = 20;    // General MIDI Reed Organ, standing in for the harmonium
+    constexpr uint8_t kTanpuraVelocity = 60;
+    constexpr uint8_t kLehraVelocity = 70;
+
+    std::string lowercase(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+        return text;
+    }
+
+    void addNote(std::vector<MidiEvent>& pattern, uint8_t channel, int note, uint8_t velocity,
+                 uint64_t start, uint64_t length) {
+        if (note < 0 || note > 127) {
+            throw std::invalid_argument("Note out of MIDI range: " + std::to_string(note));
+        }
+        uint8_t key = static_cast<uint8_t>(note);
+        pattern.push_back({start, static_cast<uint8_t>(0x90 | channel), key, velocity});
+        pattern.push_back({start + length, static_cast<uint8_t>(0x80 | channel), key, velocity});
+    }
+
+    std::vector<MidiEvent> programChange(uint8_t channel, uint8_t program) {
+        return {{0, static_cast<uint8_t>(0xC0 | channel), program, 0}};
+    }
+}
+
+std::vector<int> raagScale(const std::string& raag) {
+    static const std::unordered_map<std::string, std::vector<int>> scales = {
+        {"bilawal", {0, 2, 4, 5, 7, 9, 11}},
+        {"yaman", {0, 2, 4, 6, 7, 9, 11}},
+        {"kalyan", {0, 2, 4, 6, 7, 9, 11}},
+        {"khamaj", {0, 2, 4, 5, 7, 9, 10}},
+        {"kafi", {0, 2, 3, 5, 7, 9, 10}},
+        {"asavari", {0, 2, 3, 5, 7, 8, 10}},
+        {"bhairavi", {0, 1, 3, 5, 7, 8, 10}},
+        {"bhairav", {0, 1, 4, 5, 7, 8, 11}},
+        {"todi", {0, 1, 3, 6, 7, 8, 11}},
+        {"poorvi", {0, 1, 4, 6, 7, 8, 11}},
+        {"purvi", {0, 1, 4, 6, 7, 8, 11}},
+        {"marwa", {0, 1, 4, 6, 9, 11}},
+        {"bhupali", {0, 2, 4, 7, 9}},
+        {"durga", {0, 2, 5, 7, 9}},
+        {"malkauns", {0, 3, 5, 8, 10}},
+    };
+    auto it = scales.find(lowercase(raag));
+    return it == scales.end() ? scales.at("bilawal") : it->second;
+}
+
+std::unique_ptr<EventStream> makeThekaStream(const Taal& taal, const RenderOptions& options,
+                                             const LaykariPlan& plan, uint64_t totalTicks) {
+    const BolTable& bolTable = BolTable::instance();
+
+    std::vector<MidiEvent> pattern;
+    uint64_t cycleStart = 0;
+    for (const LaykariStep& step : plan.steps) {
+        std::size_t bol = 0;
+        for (uint32_t i = 0; i < step.notesPerCycle; ++i) {
+            uint8_t velocity = taal.bols[bol] == bolTable.rest() ? 0 : (i == 0 ? options.samVelocity : options.velocity);
+            addNote(pattern, options.channel, bolTable.note(taal.bols[bol]), velocity,
+                    cycleStart + uint64_t(i) * step.ticksPerNote, step.ticksPerNote);
+            if (++bol == taal.bols.size()) {
+                bol = 0;
+            }
+        }
+        cycleStart += plan.ticksPerCycle;
+    }
+    // Program change: Assign Standard Drum Kit
+    return std::make_unique<LoopStream>("Tabla", programChange(options.channel, 0), std::move(pattern),
+                                        cycleStart, totalTicks);
+}
+
+std::unique_ptr<EventStream> makeTanpuraStream(const Taal& taal, const std::string& raag, uint8_t tonic,
+                                               uint8_t channel, const LaykariPlan& plan, uint64_t totalTicks) {
+    std::vector<int> scale = raagScale(raag);
+    auto has = [&](int svara) { return std::find(scale.begin(), scale.end(), svara) != scale.end(); };
+    int first = has(7) ? 7 - 12 : has(5) ? 5 - 12 : 11 - 12; // Mandra Pa, Ma or Ni
+
+    const int strings[] = {first, 0, 0, -12};
+    std::vector<MidiEvent> pattern;
+    for (int matra = 0; matra < taal.beats; ++matra) {
+        addNote(pattern, channel, tonic - 12 + strings[matra % 4], kTanpuraVelocity,
+                uint64_t(matra) * plan.division, plan.division);
+    }
+    return std::make_unique<LoopStream>("Tanpura", programChange(channel, kTanpuraProgram), std::move(pattern),
+                                        plan.ticksPerCycle, totalTicks);
+}
+
+std::unique_ptr<EventStream> makeLehraStream(const Taal& taal, const std::string& raag, uint8_t tonic,
+                                             uint8_t channel, const LaykariPlan& plan, uint64_t totalTicks) {
+    std::vector<int> scale = raagScale(raag);
+    int size = static_cast<int>(scale.size());
+    int peak = taal.beats / 2;
+
+    std::vector<MidiEvent> pattern;
+    for (int matra = 0; matra < taal.beats; ++matra) {
+        // Aroha to the midpoint of the cycle, avaroha back so the next cycle starts on Sa
+        int degree = matra <= peak ? matra : taal.beats - matra;
+        int note = tonic + 12 * (degree / size) + scale[degree % size];
+        addNote(pattern, channel, note, kLehraVelocity, uint64_t(matra) * plan.division, plan.division);
+    }
+    return std::make_unique<LoopStream>("Lehra", programChange(channel, kLehraProgram), std::move(pattern),
+                                        plan.ticksPerCycle, totalTicks);
+}
@@ -0,0 +1,466 @@
+#include "AudioRenderer.h"
+#include "ByteOrder.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    constexpr std::size_t kBlock = 64;          // Samples per oscillator step; a multiple of every SIMD width
+    constexpr std::size_t kMaxOscillators = 8;
+    constexpr double kSegmentSeconds = 2.0;
+    constexpr double kMaxRingSeconds = 4.0;     // Voices without a Note Off are cut here
+    constexpr float kMasterGain = 0.25f;
+    constexpr double kInaudible = 3e-5 * 3e-5;  // Squared amplitude below a quarter of the 16-bit step
+    constexpr uint8_t kTanpuraProgram = 104;    // As written by makeTanpuraStream
+    constexpr uint64_t kNever = std::numeric_limits<uint64_t>::max();
+    constexpr double kPi = 3.14159265358979323846;
+
+    double noteFrequency(int note) {
+        return 440.0 * std::pow(2.0, (note - 69) / 12.0);
+    }
+
+    // A damped sinusoid stepped a block at a time: sample j of block m is Im(state_m * step[j]),
+    // and state_{m+1} = state_m * blockStep. Within a block the samples are independent, so they vectorize.
+    struct Oscillator {
+        alignas(32) std::array<float, kBlock> stepRe;
+        alignas(32) std::array<float, kBlock> stepIm;
+        std::complex<double> blockStep;
+        double amplitude;
+    };
+
+    struct Patch {
+        std::vector<Oscillator> oscillators;
+        double noiseLevel = 0.0;
+        alignas(32) std::array<float, kBlock> noiseStep{}; // Noise envelope within a block
+        double noiseBlockStep = 0.0;
+        float attackSamples = 1.0f;
+        float releaseSamples = 1.0f;
+        bool gated = false;         // Sustains until Note Off, then releases; otherwise rings for lengthSamples
+        uint64_t lengthSamples = 0;
+        float left = 0.7f;
+        float right = 0.7f;
+    };
+
+    void addPartial(Patch& patch, double frequency, double decaySeconds, double amplitude, uint32_t sampleRate) {
+        if (frequency >= 0.45 * sampleRate || amplitude <= 0.0) {
+            return;
+        }
+        double radius = std::exp(-1.0 / (decaySeconds * sampleRate));
+        double angle = 2.0 * kPi * frequency / sampleRate;
+        Oscillator oscillator;
+        for (std::size_t j = 0; j < kBlock; ++j) {
+            std::complex<double> step = std::polar(std::pow(radius, double(j)), angle * double(j));
+            oscillator.stepRe[j] = static_cast<float>(step.real());
+            oscillator.stepIm[j] = static_cast<float>(step.imag());
+        }
+        oscillator.blockStep = std::polar(std::pow(radius, double(kBlock)), angle * double(kBlock));
+        oscillator.amplitude = amplitude;
+        patch.oscillators.push_back(oscillator);
+    }
+
+    void setNoise(Patch& patch, double level, double decaySeconds, uint32_t sampleRate) {
+        double radius = std::exp(-1.0 / (decaySeconds * sampleRate));
+        for (std::size_t j = 0; j < kBlock; ++j) {
+            patch.noiseStep[j] = static_cast<float>(std::pow(radius, double(j)));
+        }
+        patch.noiseBlockStep = std::pow(radius, double(kBlock));
+        patch.noiseLevel = level;
+    }
+
+    void setRing(Patch& patch, double longestDecaySeconds, uint32_t sampleRate) {
+        // About -60 dB
+        patch.lengthSamples = static_cast<uint64_t>(std::min(kMaxRingSeconds, 6.9 * longestDecaySeconds) * sampleRate);
+    }
+
+    // Tabla strokes by the General MIDI keys BolTable seeds: levels and decays (seconds) of
+    // the dayan, the bayan and the noise of the strike
+    struct Stroke {
+        uint8_t note;
+        double dayan, dayanDecay;
+        double bayan, bayanDecay;
+        double noise, noiseDecay;
+    };
+
+    constexpr Stroke kStrokes[] = {
+        {36, 0.8, 0.45, 0.9, 0.55, 0.15, 0.010}, // Dha
+        {38, 0.8, 0.60, 0.7, 0.50, 0.10, 0.010}, // Dhin
+        {40, 1.0, 0.35, 0.0, 0.00, 0.20, 0.008}, // Na
+        {42, 0.4, 0.05, 0.0, 0.00, 0.50, 0.020}, // Ti
+        {44, 0.0, 0.00, 1.0, 0.60, 0.10, 0.010}, // Ge
+        {46, 0.0, 0.00, 0.4, 0.05, 0.60, 0.020}, // Ka
+        {48, 0.9, 0.30, 0.0, 0.00, 0.25, 0.008}, // Ta
+        {50, 0.0, 0.00, 1.0, 0.40, 0.10, 0.010}, // Tom
+        {52, 0.9, 0.50, 0.0, 0.00, 0.15, 0.010}, // Nam
+        {54, 0.6, 0.20, 0.5, 0.30, 0.20, 0.010}, // Jo
+        {56, 0.7, 0.40, 0.0, 0.00, 0.10, 0.010}, // Nu
+        {58, 0.7, 0.25, 0.4, 0.40, 0.15, 0.010}, // Di
+        {60, 0.6, 0.30, 0.0, 0.00, 0.20, 0.010}, // Mi, and bols without a mapping
+    };
+
+    Patch tablaPatch(uint8_t note, uint8_t tonic, uint32_t sampleRate) {
+        const Stroke* stroke = &kStrokes[std::size(kStrokes) - 1];
+        for (const Stroke& candidate : kStrokes) {
+            if (candidate.note == note) {
+                stroke = &candidate;
+            }
+        }
+
+        // The dayan is tuned to Sa with near-harmonic modes; the bayan sits about an octave and a half below
+        static constexpr double kDayanAmplitudes[] = {1.0, 0.6, 0.45, 0.3, 0.2};
+        static constexpr double kBayanRatios[] = {1.0, 1.52, 2.08};
+        static constexpr double kBayanAmplitudes[] = {1.0, 0.3, 0.12};
+        Patch patch;
+        double dayan = noteFrequency(tonic);
+        double bayan = noteFrequency(tonic - 17);
+        for (std::size_t k = 0; k < std::size(kDayanAmplitudes); ++k) {
+            addPartial(patch, dayan * (k + 1), stroke->dayanDecay / (1.0 + 0.35 * k),
+                       stroke->dayan * kDayanAmplitudes[k], sampleRate);
+        }
+        for (std::size_t k = 0; k < std::size(kBayanRatios); ++k) {
+            addPartial(patch, bayan * kBayanRatios[k], stroke->bayanDecay / (1.0 + 0.5 * k),
+                       stroke->bayan * kBayanAmplitudes[k], sampleRate);
+        }
+        setNoise(patch, stroke->noise, stroke->noiseDecay, sampleRate);
+        patch.attackSamples = 0.0005f * sampleRate;
+        setRing(patch, std::max({stroke->dayanDecay, stroke->bayanDecay, stroke->noiseDecay}), sampleRate);
+        return patch;
+    }
+
+    // A plucked string with a bright (jawari) spectrum
+    Patch tanpuraPatch(uint8_t note, uint32_t sampleRate) {
+        static constexpr double kAmplitudes[] = {1.0, 0.8, 0.6, 0.5, 0.35, 0.25};
+        Patch patch;
+        for (std::size_t k = 0; k < std::size(kAmplitudes); ++k) {
+            addPartial(patch, noteFrequency(note) * (k + 1), 2.5 / (1.0 + 0.2 * k), 0.4 * kAmplitudes[k], sampleRate);
+        }
+        patch.attackSamples = 0.003f * sampleRate;
+        setRing(patch, 2.5, sampleRate);
+        patch.left = 0.8f;
+        patch.right = 0.55f;
+        return patch;
+    }
+
+    // A held reed (harmonium-like) tone for the lehra and any other melodic channel
+    Patch reedPatch(uint8_t note, uint32_t sampleRate) {
+        static constexpr double kAmplitudes[] = {1.0, 0.55, 0.4, 0.25, 0.15};
+        Patch patch;
+        for (std::size_t k = 0; k < std::size(kAmplitudes); ++k) {
+            addPartial(patch, noteFrequency(note) * (k + 1), 20.0, 0.3 * kAmplitudes[k], sampleRate);
+        }
+        patch.gated = true;
+        patch.attackSamples = 0.015f * sampleRate;
+        patch.releaseSamples = 0.06f * sampleRate;
+        patch.left = 0.55f;
+        patch.right = 0.8f;
+        return patch;
+    }
+
+    struct Voice {
+        uint64_t start = 0;
+        uint64_t release = kNever; // Note Off of a gated voice, once seen
+        uint64_t end = kNever;     // First sample after the voice
+        const Patch* patch = nullptr;
+        double gain = 0.0;
+    };
+
+    // Deterministic white noise in [-1, 1), a pure function of the sample index
+    inline float noiseAt(uint64_t sample) {
+        uint32_t h = static_cast<uint32_t>(sample) * 0x9E3779B1u;
+        h ^= h >> 15;
+        h *= 0x85EBCA77u;
+        h ^= h >> 13;
+        return static_cast<float>(static_cast<int32_t>(h)) * (1.0f / 2147483648.0f);
+    }
+
+    // Adds the part of voice inside [segmentStart, segmentStart + length) to left and right
+    void mixVoice(const Voice& voice, uint64_t segmentStart, std::size_t length, float* left, float* right) {
+        const Patch& patch = *voice.patch;
+        uint64_t from = std::max(voice.start, segmentStart);
+        uint64_t to = std::min(voice.end, segmentStart + length);
+        if (from >= to) {
+            return;
+        }
+
+        // Replay the oscillators from the onset, so every segment computes the same samples
+        std::array<std::complex<double>, kMaxOscillators> states;
+        std::size_t count = patch.oscillators.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            states[i] = patch.oscillators[i].amplitude * voice.gain;
+        }
+        double noiseState = patch.noiseLevel * voice.gain;
+        uint64_t block = (from - voice.start) / kBlock;
+        for (uint64_t skipped = 0; skipped < block; ++skipped) {
+            for (std::size_t i = 0; i < count; ++i) {
+                states[i] *= patch.oscillators[i].blockStep;
+            }
+            noiseState *= patch.noiseBlockStep;
+        }
+
+        const float inverseAttack = 1.0f / patch.attackSamples;
+        const float inverseRelease = 1.0f / patch.releaseSamples;
+        const float releaseEnd = voice.release == kNever ? std::numeric_limits<float>::max()
+                                                         : float(voice.release - voice.start) + patch.releaseSamples;
+        alignas(32) std::array<float, kBlock> mono;
+        for (; voice.start + block * kBlock < to; ++block) {
+            uint64_t blockStart = voice.start + block * kBlock;
+            mono.fill(0.0f);
+            for (std::size_t i = 0; i < count; ++i) {
+                const Oscillator& oscillator = patch.oscillators[i];
+                if (std::norm(states[i]) < kInaudible) {
+                    continue; // Decayed partials stay silent; upper modes die long before the voice
+                }
+                float re = static_cast<float>(states[i].real());
+                float im = static_cast<float>(states[i].imag());
+                for (std::size_t j = 0; j < kBlock; ++j) {
+                    mono[j] += re * oscillator.stepIm[j] + im * oscillator.stepRe[j];
+                }
+                states[i] *= oscillator.blockStep;
+            }
+            if (patch.noiseLevel > 0.0) {
+                float level = static_cast<float>(noiseState);
+                for (std::size_t j = 0; j < kBlock; ++j) {
+                    mono[j] += level * patch.noiseStep[j] * noiseAt(blockStart + j);
+                }
+                noiseState *= patch.noiseBlockStep;
+            }
+            float offset = static_cast<float>(block * kBlock);
+            for (std::size_t j = 0; j < kBlock; ++j) {
+                float t = offset + float(j);
+                mono[j] *= std::min(1.0f, t * inverseAttack) * std::clamp((releaseEnd - t) * inverseRelease, 0.0f, 1.0f);
+            }
+
+            uint64_t first = std::max(blockStart, from);
+            uint64_t last = std::min(blockStart + kBlock, to);
+            float* outLeft = left + (first - segmentStart);
+            float* outRight = right + (first - segmentStart);
+            const float* in = mono.data() + (first - blockStart);
+            for (std::size_t j = 0; j < last - first; ++j) {
+                outLeft[j] += patch.left * in[j];
+                outRight[j] += patch.right * in[j];
+            }
+        }
+    }
+
+    struct Segment {
+        uint64_t start = 0;
+        std::size_t length = 0;
+        std::vector<Voice> voices; // Every voice sounding in the segment, in onset order
+        std::vector<float> left;
+        std::vector<float> right;
+        std::vector<uint8_t> pcm;  // Interleaved 16-bit little-endian stereo
+    };
+
+    // Runs on a pool worker; the buffers are sized by the caller, so nothing here allocates or throws
+    void renderSegment(Segment& segment) {
+        TANSEN_SCOPE("audio.segment");
+        std::fill(segment.left.begin(), segment.left.end(), 0.0f);
+        std::fill(segment.right.begin(), segment.right.end(), 0.0f);
+        for (const Voice& voice : segment.voices) {
+            mixVoice(voice, segment.start, segment.length, segment.left.data(), segment.right.data());
+        }
+        uint8_t* out = segment.pcm.data();
+        for (std::size_t i = 0; i < segment.length; ++i) {
+            int16_t l = static_cast<int16_t>(std::lrint(std::clamp(segment.left[i] * kMasterGain, -1.0f, 1.0f) * 32767.0f));
+            int16_t r = static_cast<int16_t>(std::lrint(std::clamp(segment.right[i] * kMasterGain, -1.0f, 1.0f) * 32767.0f));
+            out[4 * i] = static_cast<uint8_t>(l & 0xFF);
+            out[4 * i + 1] = static_cast<uint8_t>((l >> 8) & 0xFF);
+            out[4 * i + 2] = static_cast<uint8_t>(r & 0xFF);
+            out[4 * i + 3] = static_cast<uint8_t>((r >> 8) & 0xFF);
+        }
+    }
+
+    // Turns the event stream into voices as rendering advances, keeping only those still sounding
+    class VoiceScheduler {
+    public:
+        VoiceScheduler(EventStream& stream, const RenderOptions& options, uint32_t sampleRate, const TempoMap& tempoMap)
+            : stream(stream), options(options), sampleRate(sampleRate), tempoMap(tempoMap) {
+            pending = stream.next(event);
+        }
+
+        uint64_t sampleAt(uint64_t tick) const {
+            return static_cast<uint64_t>(tempoMap.secondsAt(tick) * sampleRate);
+        }
+
+        // Appends every voice sounding in [start, end) to voices
+        void collect(uint64_t start, uint64_t end, std::vector<Voice>& voices) {
+            while (pending && sampleAt(event.tick) < end) {
+                handle(event);
+                pending = stream.next(event);
+            }
+            while (!sounding.empty() && sounding.front().end <= start) {
+                sounding.pop_front();
+            }
+            for (const Voice& voice : sounding) {
+                if (voice.start < end && voice.end > start) {
+                    voices.push_back(voice);
+                }
+            }
+        }
+
+        uint64_t voiceCount() const { return started; }
+
+    private:
+        void handle(const MidiEvent& midi) {
+            uint8_t kind = midi.status & 0xF0;
+            uint8_t channel = midi.status & 0x0F;
+            uint64_t sample = sampleAt(midi.tick);
+            if (kind == 0xC0) {
+                programs[channel] = midi.data1;
+                return;
+            }
+            if (kind != 0x90 && kind != 0x80) {
+                return;
+            }
+
+            Voice*& holder = held[channel * 128 + midi.data1];
+            if (holder) {
+                holder->release = sample;
+                holder->end = sample + static_cast<uint64_t>(holder->patch->releaseSamples);
+                holder = nullptr;
+            }
+            if (kind == 0x80 || midi.data2 == 0) {
+                return; // Note Off; struck voices ignore it and ring out
+            }
+
+            Voice voice;
+            voice.start = sample;
+            voice.patch = &patch(channel, midi.data1);
+            voice.gain = midi.data2 / 127.0;
+            if (!voice.patch->gated) {
+                voice.end = sample + voice.patch->lengthSamples;
+            }
+            sounding.push_back(voice);
+            ++started;
+            if (voice.patch->gated) {
+                holder = &sounding.back(); // Deque references survive pushes and pops at the ends
+            }
+        }
+
+        const Patch& patch(uint8_t channel, uint8_t note) {
+            std::size_t kind = channel == options.channel ? 0 : (programs[channel] == kTanpuraProgram ? 1 : 2);
+            std::unique_ptr<Patch>& cached = patches[kind * 128 + note];
+            if (!cached) {
+                cached = std::make_unique<Patch>(kind == 0 ? tablaPatch(note, options.tonic, sampleRate)
+                                                 : kind == 1 ? tanpuraPatch(note, sampleRate)
+                                                             : reedPatch(note, sampleRate));
+            }
+            return *cached;
+        }
+
+        EventStream& stream;
+        const RenderOptions& options;
+        uint32_t sampleRate;
+        const TempoMap& tempoMap;
+        MidiEvent event;
+        bool pending = false;
+        std::deque<Voice> sounding;                     // Onset order
+        std::array<Voice*, 16 * 128> held{};            // Gated voices awaiting their Note Off
+        std::array<uint8_t, 16> programs{};
+        std::array<std::unique_ptr<Patch>, 3 * 128> patches; // Tabla, tanpura and reed, by note
+        uint64_t started = 0;
+    };
+
+    std::vector<uint8_t> wavHeader(uint32_t sampleRate, uint32_t dataBytes) {
+        std::vector<uint8_t> header;
+        auto tag = [&](const char* text) { header.insert(header.end(), text, text + 4); };
+        tag("RIFF");
+        store32(header, 36 + dataBytes);
+        tag("WAVE");
+        tag("fmt ");
+        store32(header, 16);
+        store16(header, 1); // PCM
+        store16(header, 2); // Stereo
+        store32(header, sampleRate);
+        store32(header, sampleRate * 4); // Bytes per second
+        store16(header, 4);              // Bytes per frame
+        store16(header, 16);             // Bits per sample
+        tag("data");
+        store32(header, dataBytes);
+        return header;
+    }
+}
+
+AudioRenderer::AudioRenderer(const MIDIHandler& midiHandler, const AudioOptions& audioOptions)
+    : midiHandler(midiHandler), audioOptions(audioOptions) {
+    if (audioOptions.sampleRate < 8000 || audioOptions.sampleRate > 192000) {
+        throw std::invalid_argument("Sample rate must be 8000-192000 Hz");
+    }
+}
+
+AudioReport AudioRenderer::renderTaalWAV(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                                         const RenderOptions& options, std::ostream& out) const {
+    TANSEN_SCOPE("audio");
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point begin = Clock::now();
+
+    RenderEvents events = midiHandler.renderEvents(taal, tempo, raag, options);
+    const uint32_t sampleRate = audioOptions.sampleRate;
+    TempoMap tempoMap = tempo.map(events.totalTicks, events.plan.division);
+    VoiceScheduler scheduler(*events.stream, options, sampleRate, tempoMap);
+    const uint64_t totalSamples = scheduler.sampleAt(events.totalTicks) +
+                                  static_cast<uint64_t>(std::max(0.0, audioOptions.tailSeconds) * sampleRate);
+    if (totalSamples > (std::numeric_limits<uint32_t>::max() - 36) / 4) {
+        throw std::invalid_argument("Render too long for a WAV file: " + taal.name);
+    }
+
+    std::vector<uint8_t> header = wavHeader(sampleRate, static_cast<uint32_t>(totalSamples * 4));
+    out.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    // Render a batch of segments in parallel, then write them in order; memory is bounded by the batch
+    ThreadPool pool(audioOptions.threads);
+    std::vector<Segment> batch(2 * std::size_t(pool.size()));
+    const std::size_t segmentLength = static_cast<std::size_t>(kSegmentSeconds * sampleRate);
+    for (uint64_t next = 0; next < totalSamples && out;) {
+        std::size_t count = 0;
+        for (; count < batch.size() && next < totalSamples; ++count) {
+            Segment& segment = batch[count];
+            segment.start = next;
+            segment.length = static_cast<std::size_t>(std::min<uint64_t>(segmentLength, totalSamples - next));
+            segment.left.resize(segment.length);
+            segment.right.resize(segment.length);
+            segment.pcm.resize(4 * segment.length);
+            segment.voices.clear();
+            scheduler.collect(next, next + segment.length, segment.voices);
+            next += segment.length;
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            pool.submit([segment = &batch[i]] { renderSegment(*segment); });
+        }
+        pool.wait();
+        for (std::size_t i = 0; i < count; ++i) {
+            out.write(reinterpret_cast<const char*>(batch[i].pcm.data()), batch[i].pcm.size());
+        }
+    }
+
+    AudioReport report;
+    report.audioSeconds = double(totalSamples) / sampleRate;
+    report.wallSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    report.realtimeFactor = report.wallSeconds > 0.0 ? report.audioSeconds / report.wallSeconds : 0.0;
+    report.voices = scheduler.voiceCount();
+    return report;
+}
+
+AudioReport AudioRenderer::writeTaalWAV(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                                        const std::string& outputPath, const RenderOptions& options) const {
+    std::ofstream out(outputPath, std::ios::binary);
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to open WAV file: " + outputPath);
+    }
+    AudioReport report = renderTaalWAV(taal, tempo, raag, options, out);
+    out.close();
+    if (!out) {
+        throw std::runtime_error("Failed to write WAV file: " + outputPath);
+    }
+    return report;
+}
@@ -0,0 +1,114 @@
+#include "BatchRenderer.h"
+#include "LatencyStats.h"
+#include "Profiler.h"
+#include "Tempo.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <filesystem>
+#include <istream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+BatchRenderer::BatchRenderer(const TaalManager& taalManager, const MIDIHandler& midiHandler, unsigned threads,
+                             const RenderOptions& options, OutputSink* sink)
+    : taalManager(taalManager), midiHandler(midiHandler), threads(threads), options(options), sink(sink) {}
+
+std::vector<BatchJob> BatchRenderer::parseManifest(std::istream& in) {
+    std::vector<BatchJob> jobs;
+    std::string line;
+    std::size_t lineNumber = 0;
+
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        std::istringstream fields(line);
+        BatchJob job;
+        if (!(fields >> job.raag) || job.raag[0] == '#') {
+            continue; // Blank line or comment
+        }
+
+        std::string extra;
+        if (!(fields >> job.taal >> job.tempo >> job.outputPath) || (fields >> extra)) {
+            throw std::runtime_error("Malformed manifest line " + std::to_string(lineNumber) +
+                                     ": expected '<raag> <taal> <tempo> <output>'");
+        }
+        job.line = lineNumber;
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+BatchReport BatchRenderer::run(const std::vector<BatchJob>& jobs) const {
+    using Clock = std::chrono::steady_clock;
+
+    BatchReport report;
+    report.jobs = jobs.size();
+
+    LatencyStats latency;
+    std::mutex errorMutex;
+    Clock::time_point start = Clock::now();
+
+    // Create output directories up front, once each, keeping the jobs themselves allocation-free.
+    // A failure here surfaces as the job's own open error.
+    std::unordered_set<std::string_view> directories;
+    for (const auto& job : jobs) {
+        if (sink && !sink->createsFiles()) {
+            break; // Paths name archive members
+        }
+        std::size_t slash = job.outputPath.rfind('/');
+        if (slash == std::string::npos || slash == 0) {
+            continue;
+        }
+        std::string_view parent(job.outputPath.data(), slash);
+        if (directories.insert(parent).second) {
+            std::error_code error;
+            std::filesystem::create_directories(std::string(parent), error);
+        }
+    }
+
+    auto render = [&](const BatchJob& job) {
+        TANSEN_SCOPE("job");
+        Clock::time_point jobStart = Clock::now();
+        try {
+            Rcu::ReadGuard guard; // Keeps the Taal alive if the catalog is reloaded mid-render
+            const Taal& taal = taalManager.getTaal(job.taal);
+            Tempo tempo = Tempo::fromName(job.tempo);
+            if (sink) {
+                midiHandler.exportTaalMIDI(taal, tempo, job.raag, job.outputPath, options, *sink,
+                                           RenderContext::forThisThread());
+            } else {
+                midiHandler.writeTaalMIDI(taal, tempo, job.raag, job.outputPath, options);
+            }
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            report.errors.push_back("line " + std::to_string(job.line) + ": " + e.what());
+        }
+        latency.record(std::chrono::duration<double, std::milli>(Clock::now() - jobStart).count());
+    };
+
+    {
+        ThreadPool pool(threads);
+        for (const auto& job : jobs) {
+            // Two pointers fit std::function's inline storage, so queueing a job does not allocate
+            pool.submit([render = &render, job = &job] { (*render)(*job); });
+        }
+        pool.wait();
+    }
+    if (sink) {
+        try {
+            sink->finish();
+        } catch (const std::exception& e) {
+            report.errors.push_back(std::string("finishing output: ") + e.what());
+        }
+    }
+    report.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    report.failed = report.errors.size();
+    report.jobsPerSecond = report.wallSeconds > 0.0 ? report.jobs / report.wallSeconds : 0.0;
+    report.p50Milliseconds = latency.percentile(50.0);
+    report.p99Milliseconds = latency.percentile(99.0);
+    return report;
+}
@@ -0,0 +1,256 @@
+#include "BinaryCatalog.h"
+#include "BolTable.h"
+#include "ByteOrder.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include <json/json.h>
+
+namespace {
+    const char kMagic[8] = {'T', 'A', 'N', 'S', 'E', 'N', 'C', 'T'};
+    constexpr std::size_t kHeaderSize = 64;
+    constexpr std::size_t kBolRecordSize = 8;
+    constexpr std::size_t kEntrySize = 32;
+
+    struct PendingEntry {
+        uint32_t nameOffset, nameLength;
+        uint32_t systemOffset, systemLength;
+        uint32_t beats;
+        std::vector<uint16_t> bols;
+    };
+
+    // Appends text to the string table, reusing an earlier copy if there is one
+    class StringTable {
+    public:
+        std::pair<uint32_t, uint32_t> add(const std::string& text) {
+            auto it = offsets.find(text);
+            if (it == offsets.end()) {
+                it = offsets.emplace(text, static_cast<uint32_t>(bytes.size())).first;
+                bytes.insert(bytes.end(), text.begin(), text.end());
+            }
+            return {it->second, static_cast<uint32_t>(text.size())};
+        }
+
+        const std::vector<uint8_t>& data() const { return bytes; }
+
+    private:
+        std::vector<uint8_t> bytes;
+        std::unordered_map<std::string, uint32_t> offsets;
+    };
+}
+
+void BinaryCatalog::compile(const std::string& jsonPath, const std::string& outputPath) {
+    std::ifstream file(jsonPath);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open Taal data file: " + jsonPath);
+    }
+
+    Json::Value root;
+    try {
+        file >> root;
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Error parsing JSON: " + std::string(e.what()));
+    }
+
+    StringTable strings;
+    std::vector<std::pair<uint32_t, uint32_t>> bolRecords;
+    std::unordered_map<std::string, uint16_t> bolIndex;
+    std::vector<PendingEntry> entries;
+    NameIndex::Builder names;
+
+    for (const auto& system : root.getMemberNames()) {
+        const Json::Value& systemData = root[system];
+        for (const auto& taalName : systemData.getMemberNames()) {
+            const Json::Value& taalData = systemData[taalName];
+            if (!taalData.isMember("beats") || !taalData.isMember("bols")) {
+                throw std::runtime_error("Malformed Taal data: Missing 'beats' or 'bols' for Taal: " + taalName);
+            }
+
+            PendingEntry entry;
+            std::tie(entry.nameOffset, entry.nameLength) = strings.add(taalName);
+            std::tie(entry.systemOffset, entry.systemLength) = strings.add(system);
+            entry.beats = static_cast<uint32_t>(taalData["beats"].asInt());
+            for (const auto& bolValue : taalData["bols"]) {
+                std::string bol = bolValue.asString();
+                auto it = bolIndex.find(bol);
+                if (it == bolIndex.end()) {
+                    if (bolRecords.size() > 0xFFFF) {
+                        throw std::runtime_error("Too many distinct bols in catalog: " + jsonPath);
+                    }
+                    it = bolIndex.emplace(bol, static_cast<uint16_t>(bolRecords.size())).first;
+                    bolRecords.push_back(strings.add(bol));
+                }
+                entry.bols.push_back(it->second);
+            }
+
+            names.addTaal(system, taalName, parseAliases(taalData), static_cast<uint32_t>(entries.size()));
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    std::vector<uint8_t> nameIndex = names.build();
+
+    // Section layout
+    uint64_t stringsOffset = kHeaderSize;
+    uint64_t bolTableOffset = stringsOffset + strings.data().size();
+    uint64_t entriesOffset = bolTableOffset + bolRecords.size() * kBolRecordSize;
+    uint64_t bolsOffset = entriesOffset + entries.size() * kEntrySize;
+    uint64_t bolsSize = 0;
+    for (const auto& entry : entries) {
+        bolsSize += entry.bols.size() * sizeof(uint16_t);
+    }
+    uint64_t indexOffset = (bolsOffset + bolsSize + 7) & ~uint64_t(7);
+
+    std::vector<uint8_t> out;
+    out.reserve(indexOffset + nameIndex.size());
+    out.insert(out.end(), kMagic, kMagic + sizeof(kMagic));
+    store32(out, kVersion);
+    store32(out, static_cast<uint32_t>(entries.size()));
+    store32(out, static_cast<uint32_t>(bolRecords.size()));
+    store32(out, 0); // Reserved
+    store64(out, stringsOffset);
+    store64(out, strings.data().size());
+    store64(out, bolTableOffset);
+    store64(out, entriesOffset);
+    store64(out, indexOffset);
+
+    out.insert(out.end(), strings.data().begin(), strings.data().end());
+    for (const auto& [offset, length] : bolRecords) {
+        store32(out, offset);
+        store32(out, length);
+    }
+
+    uint64_t nextBols = bolsOffset;
+    for (const auto& entry : entries) {
+        store32(out, entry.nameOffset);
+        store32(out, entry.nameLength);
+        store32(out, entry.systemOffset);
+        store32(out, entry.systemLength);
+        store32(out, entry.beats);
+        store32(out, static_cast<uint32_t>(entry.bols.size()));
+        store64(out, nextBols);
+        nextBols += entry.bols.size() * sizeof(uint16_t);
+    }
+    for (const auto& entry : entries) {
+        for (uint16_t bol : entry.bols) {
+            store16(out, bol);
+        }
+    }
+    out.resize(indexOffset, 0);
+
+    out.insert(out.end(), nameIndex.begin(), nameIndex.end());
+
+    std::string tempPath = outputPath + ".tmp";
+    {
+        std::ofstream binary(tempPath, std::ios::binary | std::ios::trunc);
+        if (!binary.is_open()) {
+            throw std::runtime_error("Unable to write catalog: " + tempPath);
+        }
+        binary.write(reinterpret_cast<const char*>(out.data()), out.size());
+        if (!binary) {
+            throw std::runtime_error("Unable to write catalog: " + tempPath);
+        }
+    }
+    if (std::rename(tempPath.c_str(), outputPath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Unable to replace catalog: " + outputPath);
+    }
+}
+
+bool BinaryCatalog::isCatalogFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(kMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return file && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+BinaryCatalog::BinaryCatalog(const std::string& path) : file(path) {
+    const uint8_t* data = file.data();
+    if (file.size() < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a Tansen catalog: " + path);
+    }
+    uint32_t version = load32(data + 8);
+    if (version != kVersion) {
+        throw std::runtime_error("Unsupported catalog version " + std::to_string(version) + ": " + path);
+    }
+
+    taalCount = load32(data + 12);
+    bolCount = load32(data + 16);
+    stringsOffset = load64(data + 24);
+    stringsSize = load64(data + 32);
+    bolTableOffset = load64(data + 40);
+    entriesOffset = load64(data + 48);
+    indexOffset = load64(data + 56);
+
+    uint64_t size = file.size();
+    bool valid = stringsOffset + stringsSize <= size &&
+                 bolTableOffset + uint64_t(bolCount) * kBolRecordSize <= size &&
+                 entriesOffset + uint64_t(taalCount) * kEntrySize <= size &&
+                 indexOffset <= size;
+    if (!valid) {
+        throw std::runtime_error("Corrupt catalog: " + path);
+    }
+    index = NameIndex(data + indexOffset, size - indexOffset);
+
+    bolIds.reset(new std::atomic<uint32_t>[bolCount]());
+}
+
+const uint8_t* BinaryCatalog::entryRecord(std::size_t entry) const {
+    return file.data() + entriesOffset + entry * kEntrySize;
+}
+
+std::string_view BinaryCatalog::string(uint32_t offset, uint32_t length) const {
+    if (uint64_t(offset) + length > stringsSize) {
+        throw std::runtime_error("Corrupt catalog: string out of range");
+    }
+    return std::string_view(reinterpret_cast<const char*>(file.data() + stringsOffset + offset), length);
+}
+
+std::string_view BinaryCatalog::name(std::size_t entry) const {
+    const uint8_t* record = entryRecord(entry);
+    return string(load32(record), load32(record + 4));
+}
+
+std::string_view BinaryCatalog::system(std::size_t entry) const {
+    const uint8_t* record = entryRecord(entry);
+    return string(load32(record + 8), load32(record + 12));
+}
+
+// Interns a catalog bol on first use; later decodes reuse the cached BolId
+BolId BinaryCatalog::bolId(uint16_t index) const {
+    if (index >= bolCount) {
+        throw std::runtime_error("Corrupt catalog: bol out of range");
+    }
+    uint32_t cached = bolIds[index].load(std::memory_order_relaxed);
+    if (cached != 0) {
+        return static_cast<BolId>(cached - 1);
+    }
+
+    const uint8_t* record = file.data() + bolTableOffset + index * kBolRecordSize;
+    BolId id = BolTable::instance().intern(string(load32(record), load32(record + 4)));
+    bolIds[index].store(uint32_t(id) + 1, std::memory_order_relaxed);
+    return id;
+}
+
+Taal BinaryCatalog::decode(std::size_t entry) const {
+    const uint8_t* record = entryRecord(entry);
+    uint32_t count = load32(record + 20);
+    uint64_t bolsOffset = load64(record + 24);
+    if (bolsOffset + uint64_t(count) * sizeof(uint16_t) > file.size()) {
+        throw std::runtime_error("Corrupt catalog: bols out of range");
+    }
+
+    Taal taal;
+    taal.name = std::string(name(entry));
+    taal.system = std::string(system(entry));
+    taal.beats = static_cast<int>(load32(record + 16));
+    taal.bols.reserve(count);
+    const uint8_t* bols = file.data() + bolsOffset;
+    for (uint32_t i = 0; i < count; ++i) {
+        taal.bols.push_back(bolId(load16(bols + i * sizeof(uint16_t))));
+    }
+    return taal;
+}
@@ -0,0 +1,80 @@
+#include "BolTable.h"
+#include <mutex>
+#include <stdexcept>
+
+BolTable& BolTable::instance() {
+    static BolTable table;
+    return table;
+}
+
+BolTable::BolTable() {
+    for (auto& note : notes) {
+        note.store(kDefaultNote, std::memory_order_relaxed);
+    }
+
+    // Note mapping for bols (General MIDI percussion keys)
+    static const std::pair<const char*, uint8_t> defaults[] = {
+        {"Dha", 36}, {"Dhin", 38}, {"Na", 40}, {"Ti", 42}, {"Ge", 44},
+        {"Ka", 46}, {"Ta", 48}, {"Tom", 50}, {"Nam", 52}, {"Jo", 54},
+        {"Nu", 56}, {"Di", 58}, {"Mi", 60}
+    };
+    for (const auto& [bol, note] : defaults) {
+        setNote(intern(bol), note);
+    }
+    restId = intern(kRest);
+}
+
+BolId BolTable::intern(std::string_view bol) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(bol);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(bol);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    if (names.size() >= kMaxBols) {
+        throw std::length_error("Too many distinct bols (limit " + std::to_string(kMaxBols) + ")");
+    }
+
+    BolId id = static_cast<BolId>(names.size());
+    names.emplace_back(bol);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+bool BolTable::find(std::string_view bol, BolId& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(bol);
+    if (it == ids.end()) {
+        return false;
+    }
+    id = it->second;
+    return true;
+}
+
+bool BolTable::bolForNote(uint8_t note, BolId& id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    for (std::size_t bol = 0; bol < names.size(); ++bol) {
+        if (notes[bol].load(std::memory_order_relaxed) == note) {
+            id = static_cast<BolId>(bol);
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::string& BolTable::name(BolId id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.at(id);
+}
+
+std::size_t BolTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+}
@@ -0,0 +1,392 @@
+#include "CatalogExporter.h"
+#include "BolTable.h"
+#include "Hash.h"
+#include "MappedFile.h"
+#include "OutputSink.h"
+#include "Profiler.h"
+#include "Rcu.h"
+#include "RenderContext.h"
+#include "Tempo.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr std::string_view kManifestHeader = "# tansen export manifest 1";
+
+    // Part of every input hash; bump it when the renderer's output changes, to re-export everything
+    constexpr uint64_t kRenderVersion = 1;
+
+    struct ManifestEntry {
+        uint64_t inputHash = 0;
+        uint64_t outputHash = 0;
+        uint64_t size = 0;
+    };
+
+    // Keyed by path relative to the output directory
+    using Manifest = std::unordered_map<std::string, ManifestEntry>;
+
+    // FNV-1a over a sequence of fields; text is length-prefixed so field boundaries count
+    class InputHash {
+    public:
+        template <typename T>
+        void mix(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Hash fields one at a time");
+            hash = fnv1a64(&value, sizeof(value), hash);
+        }
+
+        void mixText(std::string_view text) {
+            mix(uint64_t(text.size()));
+            hash = fnv1a64(text, hash);
+        }
+
+        uint64_t value() const { return hash; }
+
+    private:
+        uint64_t hash = fnv1a64(&kRenderVersion, sizeof(kRenderVersion));
+    };
+
+    // Bols are hashed by name: their interned ids differ from process to process
+    uint64_t taalHash(const Taal& taal) {
+        const BolTable& bolTable = BolTable::instance();
+        InputHash hash;
+        hash.mixText(taal.name);
+        hash.mixText(taal.system);
+        hash.mix(taal.beats);
+        for (BolId bol : taal.bols) {
+            hash.mixText(bolTable.name(bol));
+            hash.mix(bolTable.note(bol));
+        }
+        return hash.value();
+    }
+
+    // The resolved BPMs, so a change to what a laya name means is caught too
+    uint64_t tempoHash(const Tempo& tempo) {
+        InputHash hash;
+        hash.mixText(tempo.getName());
+        hash.mix(tempo.getBPM());
+        for (int stop : tempo.getStops()) {
+            hash.mix(stop);
+        }
+        hash.mix(tempo.getRamp());
+        return hash.value();
+    }
+
+    uint64_t optionsHash(const RenderOptions& options, const std::string& raag) {
+        InputHash hash;
+        hash.mix(options.cycles);
+        hash.mix(options.durationSeconds);
+        hash.mix(options.channel);
+        hash.mix(options.velocity);
+        hash.mix(options.samVelocity);
+        hash.mix(uint64_t(options.laykari.size()));
+        for (const Laykari& laykari : options.laykari) {
+            hash.mix(laykari.density);
+            hash.mix(laykari.gati);
+        }
+        hash.mix(options.format);
+        hash.mix(options.tanpura);
+        hash.mix(options.lehra);
+        hash.mix(options.tonic);
+        hash.mix(options.tempoErrorMs);
+        hash.mix(options.runningStatus);
+        hash.mixText(raag);
+        return hash.value();
+    }
+
+    // A name usable as a file name on any system
+    std::string fileStem(std::string_view name) {
+        std::string stem(name);
+        for (char& c : stem) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+                c = '_';
+            }
+        }
+        return stem;
+    }
+
+    // A manifest is only trusted to name files inside the output directory
+    bool isInside(std::string_view relative) {
+        if (relative.empty() || relative.front() == '/') {
+            return false;
+        }
+        for (std::size_t start = 0; start <= relative.size();) {
+            std::size_t end = std::min(relative.find('/', start), relative.size());
+            if (relative.substr(start, end - start) == "..") {
+                return false;
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    // Lines of "<input hash> <output hash> <size> <path>", hashes in hex; a missing manifest is empty.
+    // Parsed in place from a mapping: on an up-to-date export, reading it is most of the work.
+    Manifest readManifest(const fs::path& path, bool& damaged) {
+        Manifest manifest;
+        damaged = false;
+        std::error_code error;
+        if (!fs::exists(path, error)) {
+            return manifest;
+        }
+        MappedFile file(path.string());
+        std::string_view text(reinterpret_cast<const char*>(file.data()), file.size());
+        while (!text.empty()) {
+            std::size_t end = std::min(text.find('\n'), text.size());
+            std::string_view line = text.substr(0, end);
+            text.remove_prefix(std::min(end + 1, text.size()));
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            ManifestEntry entry;
+            const char* cursor = line.data();
+            const char* last = line.data() + line.size();
+            bool ok = true;
+            for (auto [field, base] : {std::pair{&entry.inputHash, 16}, {&entry.outputHash, 16}, {&entry.size, 10}}) {
+                auto [next, status] = std::from_chars(cursor, last, *field, base);
+                ok = ok && status == std::errc() && next < last && *next == ' ';
+                cursor = ok ? next + 1 : last;
+            }
+            std::string_view relative(cursor, static_cast<std::size_t>(last - cursor));
+            if (!ok || !isInside(relative)) {
+                damaged = true; // A damaged line only costs its track a re-render
+                continue;
+            }
+            manifest.emplace(relative, entry);
+        }
+        return manifest;
+    }
+
+    // Written beside the old one and renamed over it, so an interrupted run leaves a complete manifest
+    void writeManifest(const fs::path& path, const Manifest& manifest) {
+        std::vector<const Manifest::value_type*> sorted;
+        sorted.reserve(manifest.size());
+        for (const auto& entry : manifest) {
+            sorted.push_back(&entry);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return a->first < b->first; });
+
+        fs::path temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            out << kManifestHeader << "\n";
+            char hashes[64];
+            for (const auto* entry : sorted) {
+                std::snprintf(hashes, sizeof(hashes), "%016llx %016llx ",
+                              static_cast<unsigned long long>(entry->second.inputHash),
+                              static_cast<unsigned long long>(entry->second.outputHash));
+                out << hashes << entry->second.size << " " << entry->first << "\n";
+            }
+            out.close();
+            if (!out) {
+                throw std::runtime_error("Failed to write export manifest: " + temporary.string());
+            }
+        }
+        fs::rename(temporary, path);
+    }
+
+    uint64_t fileHash(const fs::path& path) {
+        MappedFile file(path.string());
+        return fnv1a64(file.data(), file.size());
+    }
+
+    // Names of the files in each output directory, listed once per directory: far cheaper than
+    // a stat per track
+    class OutputListing {
+    public:
+        explicit OutputListing(const fs::path& root) : root(root) {}
+
+        bool exists(std::string_view relative) {
+            std::size_t slash = relative.rfind('/');
+            std::string directory(slash == std::string_view::npos ? std::string_view() : relative.substr(0, slash));
+            auto listed = directories.find(directory);
+            if (listed == directories.end()) {
+                listed = directories.emplace(directory, std::unordered_set<std::string>()).first;
+                std::error_code error;
+                for (fs::directory_iterator entry(root / directory, error), end; !error && entry != end;
+                     entry.increment(error)) {
+                    if (entry->is_regular_file(error)) {
+                        listed->second.insert(entry->path().filename().string());
+                    }
+                }
+            }
+            return listed->second.count(std::string(relative.substr(slash + 1))) != 0;
+        }
+
+    private:
+        fs::path root;
+        std::unordered_map<std::string, std::unordered_set<std::string>> directories;
+    };
+
+    // Whether the file the manifest recorded is still there; verify checks it is as written
+    bool outputIntact(OutputListing& listing, const fs::path& root, const std::string& relative,
+                      const ManifestEntry& entry, bool verify) {
+        if (!listing.exists(relative)) {
+            return false;
+        }
+        if (!verify) {
+            return true;
+        }
+        std::error_code error;
+        if (fs::file_size(root / relative, error) != entry.size || error) {
+            return false;
+        }
+        try {
+            return fileHash(root / relative) == entry.outputHash;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // Deletes an output and then its directories, up to root, as they become empty
+    void removeOutput(const fs::path& root, const fs::path& relative) {
+        std::error_code error;
+        fs::remove(root / relative, error);
+        for (fs::path parent = relative.parent_path(); !parent.empty(); parent = parent.parent_path()) {
+            if (!fs::is_empty(root / parent, error) || error || !fs::remove(root / parent, error)) {
+                break;
+            }
+        }
+    }
+
+    struct ExportJob {
+        const Taal* taal;
+        const Tempo* tempo;
+        std::string path; // Relative to the output directory
+        ManifestEntry entry;
+        bool ok = false;
+    };
+}
+
+CatalogExporter::CatalogExporter(const TaalManager& taalManager, const MIDIHandler& midiHandler,
+                                 const RenderOptions& renderOptions, const ExportOptions& exportOptions)
+    : taalManager(taalManager), midiHandler(midiHandler), renderOptions(renderOptions),
+      exportOptions(exportOptions) {}
+
+ExportReport CatalogExporter::run(const std::string& outputDir) const {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    ExportReport report;
+
+    std::vector<Tempo> tempos;
+    std::vector<uint64_t> tempoHashes;
+    for (const std::string& name : exportOptions.tempos) {
+        if (std::find(exportOptions.tempos.data(), &name, name) != &name) {
+            continue; // Listed twice
+        }
+        tempos.push_back(Tempo::fromName(name));
+        tempoHashes.push_back(tempoHash(tempos.back()));
+    }
+    const uint64_t settingsHash = optionsHash(renderOptions, exportOptions.raag);
+
+    const fs::path root(outputDir);
+    fs::create_directories(root);
+    const fs::path manifestPath = root / kManifestName;
+    bool damaged = false;
+    const Manifest previous = readManifest(manifestPath, damaged);
+
+    // Hash every track's inputs and keep the ones the manifest shows are already on disk
+    Rcu::ReadGuard guard; // Keeps the Taals alive if the catalog is reloaded meanwhile
+    OutputListing listing(root);
+    Manifest current;
+    std::unordered_set<std::string> wanted;
+    std::vector<ExportJob> jobs;
+    for (const std::string& name : taalManager.listTaalNames()) {
+        const Taal& taal = taalManager.getTaal(name);
+        uint64_t definitionHash = taalHash(taal);
+        std::string directory = taal.system.empty() ? "" : fileStem(taal.system) + "/";
+        for (std::size_t i = 0; i < tempos.size(); ++i) {
+            std::string path = directory + fileStem(taal.name) + "_" + fileStem(tempos[i].getName()) + ".mid";
+            ++report.entries;
+            if (!wanted.insert(path).second) {
+                report.errors.push_back(path + ": " + name + " at " + tempos[i].getName() + " has the same file name as another track");
+                continue;
+            }
+            ExportJob job{&taal, &tempos[i], std::move(path), {}};
+            uint64_t parts[] = {definitionHash, tempoHashes[i], settingsHash};
+            job.entry.inputHash = fnv1a64(parts, sizeof(parts));
+
+            auto recorded = previous.find(job.path);
+            if (recorded != previous.end() && recorded->second.inputHash == job.entry.inputHash &&
+                outputIntact(listing, root, job.path, recorded->second, exportOptions.verify)) {
+                current[job.path] = recorded->second;
+                ++report.unchanged;
+            } else {
+                jobs.push_back(std::move(job));
+            }
+        }
+    }
+
+    // Render what changed, in parallel; directories are created up front, once each
+    std::unordered_set<std::string> directories;
+    for (const ExportJob& job : jobs) {
+        fs::path parent = fs::path(job.path).parent_path();
+        if (!parent.empty() && directories.insert(parent.string()).second) {
+            std::error_code error;
+            fs::create_directories(root / parent, error); // A failure surfaces as the job's own
+        }
+    }
+    // Files are written as the batch renderer writes them; every one must be on disk, complete,
+    // before the manifest lists it, so the sink is the synchronous pwrite one
+    PwriteSink sink;
+    std::mutex errorMutex;
+    auto render = [&](ExportJob& job) {
+        TANSEN_SCOPE("job");
+        try {
+            RenderContext& context = RenderContext::forThisThread();
+            midiHandler.exportTaalMIDI(*job.taal, *job.tempo, exportOptions.raag, (root / job.path).string(),
+                                       renderOptions, sink, context);
+            const std::vector<uint8_t>& midiData = context.output();
+            job.entry.outputHash = fnv1a64(midiData.data(), midiData.size());
+            job.entry.size = midiData.size();
+            job.ok = true;
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            report.errors.push_back(job.path + ": " + e.what());
+        }
+    };
+    if (!jobs.empty()) {
+        ThreadPool pool(exportOptions.threads);
+        for (ExportJob& job : jobs) {
+            pool.submit([render = &render, job = &job] { (*render)(*job); });
+        }
+        pool.wait();
+    }
+    for (const ExportJob& job : jobs) {
+        if (job.ok) {
+            current[job.path] = job.entry;
+            ++report.rendered;
+        }
+    }
+
+    // Collect the outputs of Taals and tempos that are gone
+    for (const auto& [path, entry] : previous) {
+        if (wanted.count(path) == 0) {
+            removeOutput(root, path);
+            ++report.removed;
+        }
+    }
+
+    if (damaged || report.rendered != 0 || report.removed != 0 || current.size() != previous.size()) {
+        writeManifest(manifestPath, current);
+    }
+    report.failed = report.errors.size();
+    report.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,90 @@
+#include "CatalogWatcher.h"
+#include "Rcu.h"
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+CatalogWatcher::CatalogWatcher(TaalManager& taalManager, const std::string& path, std::ostream& log)
+    : taalManager(taalManager), path(path), log(log) {
+    std::size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stopFd = ::eventfd(0, EFD_CLOEXEC);
+    if (notifyFd < 0 || stopFd < 0 ||
+        ::inotify_add_watch(notifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        int error = errno;
+        if (notifyFd >= 0) {
+            ::close(notifyFd);
+        }
+        if (stopFd >= 0) {
+            ::close(stopFd);
+        }
+        throw std::runtime_error("Unable to watch " + directory + ": " + std::strerror(error));
+    }
+    thread = std::thread(&CatalogWatcher::run, this);
+}
+
+CatalogWatcher::~CatalogWatcher() {
+    uint64_t one = 1;
+    ssize_t written = ::write(stopFd, &one, sizeof(one));
+    (void)written; // An eventfd counter this small cannot overflow
+    thread.join();
+    ::close(notifyFd);
+    ::close(stopFd);
+}
+
+bool CatalogWatcher::changed() {
+    alignas(inotify_event) char buffer[4096];
+    bool relevant = false;
+    for (;;) {
+        ssize_t length = ::read(notifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return relevant; // EAGAIN: drained
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && fileName == event->name) {
+                relevant = true;
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void CatalogWatcher::run() {
+    pollfd fds[2] = {{notifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    bool pending = false;
+    for (;;) {
+        // While a change is pending, wait for the writer to go quiet before reloading
+        int ready = ::poll(fds, 2, pending ? kSettleMilliseconds : kReclaimMilliseconds);
+        if (ready < 0 && errno != EINTR) {
+            log << "Catalog watcher stopped: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            return;
+        }
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            pending = changed() || pending;
+            continue;
+        }
+
+        if (pending) {
+            pending = false;
+            try {
+                double milliseconds = taalManager.reload();
+                log << "Reloaded catalog " << path << " in " << milliseconds << " ms" << std::endl;
+            } catch (const std::exception& e) {
+                log << "Reload of " << path << " failed, keeping the previous catalog: " << e.what() << std::endl;
+            }
+        }
+        Rcu::instance().reclaim();
+    }
+}
@@ -0,0 +1,62 @@
+#include "CommandExecutor.h"
+#include <filesystem>
+#include <sstream>
+
+CommandExecutor::CommandExecutor(TaalManager& taalManager, const MIDIHandler& midiHandler, bool inlineOutput,
+                                 const RenderOptions& options)
+    : taalManager(taalManager), midiHandler(midiHandler), inlineOutput(inlineOutput), options(options),
+      tempo(Tempo::fromName("Madhya")) {}
+
+CommandResult CommandExecutor::execute(const Command& command) {
+    CommandResult result;
+    execute(command, result);
+    return result;
+}
+
+void CommandExecutor::execute(const Command& command, CommandResult& result) {
+    result.kind = CommandResult::Kind::Text;
+    result.text.clear();
+    result.midi.clear();
+
+    switch (command.type) {
+        case Command::Type::Generate: {
+            Rcu::ReadGuard guard; // Keeps the Taal alive if the catalog is reloaded mid-render
+            const Taal& taal = taalManager.getTaal(command.taal);
+            Tempo renderTempo = command.tempo.empty() ? tempo : Tempo::fromName(command.tempo);
+
+            if (command.outputPath.empty() && inlineOutput) {
+                result.kind = CommandResult::Kind::Midi;
+                midiHandler.renderTaalMIDI(taal, renderTempo, command.raag, options, context, result.midi);
+                break;
+            }
+
+            std::string path = command.outputPath.empty() ? "output/taal_track.mid" : command.outputPath;
+            std::filesystem::path parent = std::filesystem::path(path).parent_path();
+            if (!parent.empty()) {
+                std::filesystem::create_directories(parent);
+            }
+            midiHandler.writeTaalMIDI(taal, renderTempo, command.raag, path, options, context);
+            result.kind = CommandResult::Kind::File;
+            result.text = path;
+            break;
+        }
+        case Command::Type::ListTaals: {
+            std::ostringstream listing;
+            taalManager.listAllTaals(listing);
+            result.text = listing.str();
+            break;
+        }
+        case Command::Type::AddTaal:
+            taalManager.addTaal(command.taal, command.beats, command.bols);
+            result.text = "Added Taal " + command.taal + "\n";
+            break;
+        case Command::Type::SetTempo:
+            tempo = Tempo::fromName(command.tempo);
+            std::string bpm = std::to_string(tempo.getBPM());
+            if (tempo.ramps()) {
+                bpm += "-" + std::to_string(tempo.getEndBPM());
+            }
+            result.text = "Tempo set to " + tempo.getName() + " (" + bpm + " BPM)\n";
+            break;
+    }
+}
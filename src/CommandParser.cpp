@@ -0,0 +1,23 @@
+#include "CommandParser.h"
+
+void assignCommand(const CommandSyntax& syntax, Command& command) {
+    command.type = syntax.type;
+    command.raag.assign(syntax.raag);
+    command.taal.assign(syntax.taal);
+    command.tempo.assign(syntax.tempo);
+    command.outputPath.assign(syntax.outputPath);
+    command.beats = syntax.beats;
+    command.bols.assign(syntax.bols.begin(), syntax.bols.end());
+}
+
+Command parseCommand(const std::string& line) {
+    Command command;
+    parseCommand(line, command);
+    return command;
+}
+
+void parseCommand(const std::string& line, Command& command) {
+    thread_local CommandSyntax syntax; // Its bol list keeps its capacity across lines
+    parseCommandSyntax(line, syntax);
+    assignCommand(syntax, command);
+}
@@ -0,0 +1,306 @@
+#include "CompositionGenerator.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+    // Tabla words phrases are built from, with how strongly the ranking favours each
+    struct WordSpec {
+        const char* text;
+        const char* strokes;
+        double weight;
+    };
+
+    constexpr WordSpec kVocabulary[] = {
+        {"Dha", "Dha", 0.5},
+        {"TiRaKiTa", "Ti Ra Ki Ta", 0.8},
+        {"DhaGe", "Dha Ge", 0.5},
+        {"NaDha", "Na Dha", 0.5},
+        {"KiTaTaKa", "Ki Ta Ta Ka", 0.5},
+        {"TaKiTa", "Ta Ki Ta", 0.5},
+        {"DhiNa", "Dhin Na", 0.4},
+        {"GaDiGaNa", "Ge Di Ge Na", 0.4},
+        {"TaKa", "Ta Ka", 0.3},
+        {"DhaTi", "Dha Ti", 0.3},
+        {"TiTa", "Ti Ta", 0.2},
+    };
+
+    constexpr uint16_t kNoWord = 0xFFFF;
+    constexpr double kWordCost = 0.45;       // Charged per word, so strings of single strokes do not win
+    constexpr double kJitter = 0.3;          // Spread of the seeded per-word variation
+    constexpr double kCoverageWeight = 2.0;  // Favours compositions that fill more of the span
+    constexpr double kDamBonus = 0.5;        // Favours damdar tihais (with rests between repetitions)
+
+    uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // Deterministic variation in [-kJitter / 2, kJitter / 2) for a word placed with `remaining` pulses left
+    double jitter(uint64_t seed, uint16_t word, uint32_t remaining) {
+        uint64_t hash = mix(mix(seed + 0x9e3779b97f4a7c15ULL) ^ (uint64_t(word) << 32 | remaining));
+        return kJitter * (static_cast<double>(hash >> 11) * 0x1.0p-53 - 0.5);
+    }
+
+    // A shape of composition whose last stroke lands on sam: pulse counts of its parts
+    struct Structure {
+        uint32_t body;      // Chakradar: phrase before the inner tihai; 0 for a tihai
+        uint32_t phrase;    // Phrase ending on Dha, played three times (nine in a chakradar)
+        uint32_t innerGap;  // Chakradar: rests inside each inner tihai
+        uint32_t gap;       // Rests between the three repetitions
+        uint32_t start;
+        double bonus;
+    };
+
+    struct Candidate {
+        double score;
+        uint32_t structure;
+        uint32_t body;   // Rank in the k-best body list
+        uint32_t phrase; // Rank in the k-best landing-phrase list
+
+        bool operator<(const Candidate& other) const {
+            // Max-heap on score; ties go to the earlier structure and ranks, keeping the order deterministic
+            if (score != other.score) {
+                return score < other.score;
+            }
+            if (structure != other.structure) {
+                return structure > other.structure;
+            }
+            return body != other.body ? body > other.body : phrase > other.phrase;
+        }
+    };
+}
+
+CompositionGenerator::CompositionGenerator(const Taal& taal, const CompositionOptions& options)
+    : taal(taal), options(options) {
+    if (taal.beats <= 0 || taal.bols.empty()) {
+        throw std::invalid_argument("Taal has no beats: " + taal.name);
+    }
+    if (options.cycles == 0 || options.cycles > CompositionOptions::kMaxCycles) {
+        throw std::invalid_argument("A composition must span 1-" + std::to_string(CompositionOptions::kMaxCycles) +
+                                    " cycles");
+    }
+    if (options.laykari.density < 1 || options.laykari.density > Laykari::kMaxDensity) {
+        throw std::invalid_argument("Laykari density must be 1-8");
+    }
+    this->options.limit = std::min(options.limit, CompositionOptions::kMaxLimit);
+    pulsesPerMatra = options.laykari.notesPerMatra();
+    cyclePulses = static_cast<uint32_t>(taal.bols.size()) * pulsesPerMatra;
+    landing = options.cycles * cyclePulses;
+
+    BolTable& bolTable = BolTable::instance();
+    BolId dha = bolTable.intern("Dha");
+    for (const WordSpec& spec : kVocabulary) {
+        Word word{spec.text, {}, spec.weight, false};
+        std::istringstream strokes(spec.strokes);
+        std::string stroke;
+        while (strokes >> stroke) {
+            word.bols.push_back(bolTable.intern(stroke));
+        }
+        word.landsOnDha = word.bols.back() == dha;
+        words.push_back(std::move(word));
+    }
+    buildTables();
+}
+
+// k-best phrases of every length, shortest first: each list is a k-way merge of one word
+// followed by the (already computed) best phrases of the remaining length
+void CompositionGenerator::buildTables() {
+    TANSEN_SCOPE("compose.tables");
+    const std::size_t k = std::max<std::size_t>(options.limit, 1);
+    const uint32_t longest = landing + 1;
+    anyPhrases.assign(longest + 1, {});
+    landingPhrases.assign(longest + 1, {});
+    anyPhrases[0].push_back({0.0, kNoWord, 0});
+
+    struct Head {
+        double score;
+        uint16_t word;
+        uint32_t rank;
+        bool operator<(const Head& other) const {
+            return score != other.score ? score < other.score
+                                        : (word != other.word ? word > other.word : rank > other.rank);
+        }
+    };
+    std::vector<Head> heads;
+    auto merge = [&](uint32_t length, bool landingOnly, std::vector<Entry>& out) {
+        heads.clear();
+        for (uint16_t w = 0; w < words.size(); ++w) {
+            uint32_t size = static_cast<uint32_t>(words[w].bols.size());
+            if (size > length || (landingOnly && !words[w].landsOnDha) || anyPhrases[length - size].empty()) {
+                continue; // Prunes every word that cannot complete this length
+            }
+            double score = words[w].weight - kWordCost + jitter(options.seed, w, length);
+            heads.push_back({score + anyPhrases[length - size][0].score, w, 0});
+        }
+        std::make_heap(heads.begin(), heads.end());
+        while (!heads.empty() && out.size() < k) {
+            std::pop_heap(heads.begin(), heads.end());
+            Head head = heads.back();
+            heads.pop_back();
+            out.push_back({head.score, head.word, head.rank});
+
+            const std::vector<Entry>& rest = anyPhrases[length - words[head.word].bols.size()];
+            if (head.rank + 1 < rest.size()) {
+                double score = head.score - rest[head.rank].score + rest[head.rank + 1].score;
+                heads.push_back({score, head.word, head.rank + 1});
+                std::push_heap(heads.begin(), heads.end());
+            }
+        }
+    };
+    for (uint32_t length = 1; length <= longest; ++length) {
+        merge(length, false, anyPhrases[length]);
+        merge(length, true, landingPhrases[length]);
+    }
+}
+
+void CompositionGenerator::appendPhrase(const std::vector<std::vector<Entry>>& table, uint32_t length,
+                                        uint32_t rank, Composition& composition) const {
+    const Entry& entry = table[length][rank];
+    if (entry.word == kNoWord) {
+        return;
+    }
+    const Word& word = words[entry.word];
+    uint32_t rest = length - static_cast<uint32_t>(word.bols.size());
+    bool wordLast = &table == &landingPhrases;
+    if (wordLast) {
+        appendPhrase(anyPhrases, rest, entry.rest, composition);
+    }
+    composition.bols.insert(composition.bols.end(), word.bols.begin(), word.bols.end());
+    composition.text += composition.text.empty() ? word.text : " " + word.text;
+    if (!wordLast) {
+        appendPhrase(anyPhrases, rest, entry.rest, composition);
+    }
+}
+
+void CompositionGenerator::appendRests(uint32_t count, Composition& composition) const {
+    composition.bols.insert(composition.bols.end(), count, BolTable::instance().rest());
+    for (uint32_t i = 0; i < count; ++i) {
+        composition.text += " -";
+    }
+}
+
+void CompositionGenerator::generate(const std::function<bool(const Composition&)>& visit) const {
+    TANSEN_SCOPE("compose");
+    const bool chakradar = options.kind == CompositionKind::Chakradar;
+    const uint32_t span = landing + 1; // Pulses up to and including the landing stroke
+
+    // Only shapes whose length puts the last stroke on sam, starting on a stroke of the theka
+    std::vector<Structure> structures;
+    for (uint32_t gap = 0; gap <= 2 * pulsesPerMatra; ++gap) {
+        for (uint32_t innerGap = 0; innerGap <= (chakradar ? pulsesPerMatra : 0); ++innerGap) {
+            for (uint32_t phrase = 1; phrase <= span; ++phrase) {
+                uint32_t inner = chakradar ? 3 * phrase + 2 * innerGap : phrase;
+                if (3 * inner + 2 * gap > span) {
+                    break;
+                }
+                if (phrase < 2 || landingPhrases[phrase].empty()) {
+                    continue;
+                }
+                for (uint32_t body = chakradar ? 1 : 0; 3 * (body + inner) + 2 * gap <= span; ++body) {
+                    uint32_t length = 3 * (body + inner) + 2 * gap;
+                    if ((span - length) % pulsesPerMatra != 0 || anyPhrases[body].empty()) {
+                        continue;
+                    }
+                    double bonus = kCoverageWeight * length / span + (gap > 0 ? kDamBonus : 0.0) +
+                                   (innerGap > 0 ? kDamBonus / 2 : 0.0);
+                    structures.push_back({body, phrase, innerGap, gap, span - length, bonus});
+                    if (!chakradar) {
+                        break; // A tihai has no body
+                    }
+                }
+            }
+        }
+    }
+
+    // Each structure's candidates come in score order from the two sorted lists; a heap
+    // over all of them yields the compositions best first without scoring the rest
+    auto candidate = [&](uint32_t index, uint32_t body, uint32_t phrase) {
+        const Structure& structure = structures[index];
+        double score = anyPhrases[structure.body][body].score + landingPhrases[structure.phrase][phrase].score +
+                       structure.bonus;
+        return Candidate{score, index, body, phrase};
+    };
+    std::vector<Candidate> initial;
+    initial.reserve(structures.size());
+    for (uint32_t index = 0; index < structures.size(); ++index) {
+        initial.push_back(candidate(index, 0, 0));
+    }
+    std::priority_queue<Candidate> frontier(std::less<Candidate>(), std::move(initial));
+    std::unordered_set<uint64_t> queued;
+
+    for (std::size_t emitted = 0; emitted < options.limit && !frontier.empty(); ++emitted) {
+        Candidate best = frontier.top();
+        frontier.pop();
+        const Structure& structure = structures[best.structure];
+
+        Composition composition;
+        composition.kind = options.kind;
+        composition.score = best.score;
+        composition.start = structure.start;
+        composition.phrase = chakradar ? structure.body + 3 * structure.phrase + 2 * structure.innerGap : structure.phrase;
+        composition.gap = structure.gap;
+        for (int repetition = 0; repetition < 3; ++repetition) {
+            if (chakradar) {
+                appendPhrase(anyPhrases, structure.body, best.body, composition);
+                for (int inner = 0; inner < 3; ++inner) {
+                    appendPhrase(landingPhrases, structure.phrase, best.phrase, composition);
+                    if (inner < 2) {
+                        appendRests(structure.innerGap, composition);
+                    }
+                }
+            } else {
+                appendPhrase(landingPhrases, structure.phrase, best.phrase, composition);
+            }
+            if (repetition < 2) {
+                appendRests(structure.gap, composition);
+            }
+        }
+        if (!visit(composition)) {
+            return;
+        }
+
+        auto push = [&](uint32_t body, uint32_t phrase) {
+            if (body >= anyPhrases[structure.body].size() || phrase >= landingPhrases[structure.phrase].size()) {
+                return;
+            }
+            uint64_t key = (uint64_t(best.structure) << 40) | (uint64_t(body) << 20) | phrase;
+            if (queued.insert(key).second) {
+                frontier.push(candidate(best.structure, body, phrase));
+            }
+        };
+        push(best.body + 1, best.phrase);
+        push(best.body, best.phrase + 1);
+    }
+}
+
+std::vector<Composition> CompositionGenerator::generate() const {
+    std::vector<Composition> compositions;
+    generate([&](const Composition& composition) {
+        compositions.push_back(composition);
+        return true;
+    });
+    return compositions;
+}
+
+Taal CompositionGenerator::arrange(const Composition& composition) const {
+    const std::size_t thekaLength = taal.bols.size();
+    Taal arranged;
+    arranged.name = taal.name + (composition.kind == CompositionKind::Chakradar ? " chakradar" : " tihai");
+    arranged.system = taal.system;
+    arranged.beats = static_cast<int>(options.cycles + 2) * taal.beats;
+    arranged.bols.resize(std::size_t(options.cycles + 2) * cyclePulses);
+
+    // Theka at the composition's laykari repeats within the cycle, as MIDIHandler plays it
+    for (std::size_t pulse = 0; pulse < arranged.bols.size(); ++pulse) {
+        arranged.bols[pulse] = taal.bols[pulse % thekaLength];
+    }
+    std::copy(composition.bols.begin(), composition.bols.end(), arranged.bols.begin() + cyclePulses + composition.start);
+    return arranged;
+}
@@ -0,0 +1,70 @@
+#include "CycleCache.h"
+#include "Hash.h"
+
+std::size_t CycleKeyHash::operator()(const CycleKey& key) const {
+    uint64_t hash = fnv1a64(&key.pattern, sizeof(key.pattern));
+    hash = fnv1a64(&key.bpm, sizeof(key.bpm), hash);
+    const uint8_t bytes[] = {key.channel, key.velocity, key.samVelocity, key.runningStatus};
+    hash = fnv1a64(bytes, sizeof(bytes), hash);
+    hash = fnv1a64(&key.notesPerCycle, sizeof(key.notesPerCycle), hash);
+    return static_cast<std::size_t>(fnv1a64(&key.ticksPerNote, sizeof(key.ticksPerNote), hash));
+}
+
+CycleCache& CycleCache::shared() {
+    static CycleCache cache;
+    return cache;
+}
+
+CycleCache::CycleCache(std::size_t capacityBytes) : capacityBytes(capacityBytes) {}
+
+CycleCache::Cycle CycleCache::find(const CycleKey& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) {
+        ++missCount;
+        return nullptr;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    ++hitCount;
+    return it->second->second;
+}
+
+CycleCache::Cycle CycleCache::insert(const CycleKey& key, Cycle cycle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        return it->second->second; // Another thread encoded it meanwhile
+    }
+    entries.emplace_front(key, cycle);
+    index.emplace(key, entries.begin());
+    sizeBytes += cycle->size();
+    evict();
+    return cycle;
+}
+
+// Drop least recently used cycles until the cache fits, always keeping the newest one
+void CycleCache::evict() {
+    while (sizeBytes > capacityBytes && entries.size() > 1) {
+        const Entry& oldest = entries.back();
+        sizeBytes -= oldest.second->size();
+        index.erase(oldest.first);
+        entries.pop_back();
+    }
+}
+
+void CycleCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    index.clear();
+    entries.clear();
+    sizeBytes = 0;
+}
+
+uint64_t CycleCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hitCount;
+}
+
+uint64_t CycleCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return missCount;
+}
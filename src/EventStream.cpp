@@ -0,0 +1,82 @@
+#include "EventStream.h"
+#include <algorithm>
+#include <stdexcept>
+
+LoopStream::LoopStream(std::string name, std::vector<MidiEvent> prelude, std::vector<MidiEvent> pattern,
+                       uint64_t periodTicks, uint64_t totalTicks)
+    : trackName(std::move(name)), prelude(std::move(prelude)), pattern(std::move(pattern)),
+      periodTicks(periodTicks), totalTicks(totalTicks) {
+    if (periodTicks == 0 && !this->pattern.empty()) {
+        throw std::invalid_argument("Loop period must be positive: " + trackName);
+    }
+    std::stable_sort(this->pattern.begin(), this->pattern.end(),
+                     [](const MidiEvent& a, const MidiEvent& b) { return a.tick < b.tick; });
+}
+
+bool LoopStream::next(MidiEvent& event) {
+    if (preludeIndex < prelude.size()) {
+        event = prelude[preludeIndex++];
+        return true;
+    }
+
+    while (!pattern.empty() && periodStart < totalTicks) {
+        if (patternIndex == pattern.size()) {
+            patternIndex = 0;
+            periodStart += periodTicks;
+            continue;
+        }
+        const MidiEvent& source = pattern[patternIndex++];
+        event = source;
+        event.tick += periodStart;
+
+        bool isNoteOn = (source.status & 0xF0) == 0x90 && source.data2 != 0;
+        bool isNoteOff = (source.status & 0xF0) == 0x80 || ((source.status & 0xF0) == 0x90 && source.data2 == 0);
+        if (isNoteOn && event.tick >= totalTicks) {
+            continue;
+        }
+        if (isNoteOff && event.tick > totalTicks) {
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Every period that starts before totalTicks, in full
+uint64_t LoopStream::eventBound() const {
+    uint64_t periods = pattern.empty() ? 0 : (totalTicks + periodTicks - 1) / periodTicks;
+    return prelude.size() + periods * pattern.size();
+}
+
+MergedStream::MergedStream(std::string name, std::vector<std::unique_ptr<EventStream>> sources)
+    : trackName(std::move(name)), sources(std::move(sources)) {
+    for (std::size_t i = 0; i < this->sources.size(); ++i) {
+        Head head{{}, i};
+        if (this->sources[i]->next(head.event)) {
+            heads.push(head);
+        }
+    }
+}
+
+uint64_t MergedStream::eventBound() const {
+    uint64_t bound = heads.size();
+    for (const auto& source : sources) {
+        bound += source->eventBound();
+    }
+    return bound;
+}
+
+bool MergedStream::next(MidiEvent& event) {
+    if (heads.empty()) {
+        return false;
+    }
+    Head head = heads.top();
+    heads.pop();
+    event = head.event;
+
+    // Refill from the source just consumed; each source stays in tick order
+    if (sources[head.source]->next(head.event)) {
+        heads.push(head);
+    }
+    return true;
+}
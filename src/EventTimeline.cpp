@@ -0,0 +1,122 @@
+#include "EventTimeline.h"
+#include "MidiEncoding.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+    constexpr unsigned kDigitBits = 8;
+    constexpr std::size_t kBuckets = std::size_t(1) << kDigitBits;
+}
+
+void EventTimeline::reserve(std::size_t count) {
+    ticks.reserve(count);
+    statuses.reserve(count);
+    data1s.reserve(count);
+    data2s.reserve(count);
+}
+
+void EventTimeline::clear() {
+    ticks.clear();
+    statuses.clear();
+    data1s.clear();
+    data2s.clear();
+}
+
+void EventTimeline::sort() {
+    if (std::is_sorted(ticks.begin(), ticks.end())) {
+        return;
+    }
+    const std::size_t n = ticks.size();
+    const uint64_t base = *std::min_element(ticks.begin(), ticks.end());
+
+    // Sort ticks relative to the earliest, with each event's index riding along; a window of
+    // events spans few ticks, so most high digits are the same everywhere and are skipped
+    keys.resize(n);
+    order.resize(n);
+    sortedKeys.resize(n);
+    sortedOrder.resize(n);
+    uint64_t range = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        keys[i] = ticks[i] - base;
+        order[i] = static_cast<uint32_t>(i);
+        range |= keys[i];
+    }
+    for (unsigned shift = 0; shift < 64 && (range >> shift) != 0; shift += kDigitBits) {
+        std::array<std::size_t, kBuckets> offsets{};
+        for (uint64_t key : keys) {
+            ++offsets[(key >> shift) & (kBuckets - 1)];
+        }
+        std::size_t total = 0;
+        for (std::size_t& offset : offsets) {
+            std::size_t count = offset;
+            offset = total;
+            total += count;
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t slot = offsets[(keys[i] >> shift) & (kBuckets - 1)]++;
+            sortedKeys[slot] = keys[i];
+            sortedOrder[slot] = order[i];
+        }
+        keys.swap(sortedKeys);
+        order.swap(sortedOrder);
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+        ticks[i] = keys[i] + base;
+    }
+    gathered.resize(n);
+    for (std::vector<uint8_t>* field : {&statuses, &data1s, &data2s}) {
+        for (std::size_t i = 0; i < n; ++i) {
+            gathered[i] = (*field)[order[i]];
+        }
+        field->swap(gathered);
+    }
+}
+
+void EventTimeline::quantize(uint64_t grid) {
+    if (grid <= 1) {
+        return;
+    }
+    for (uint64_t& tick : ticks) {
+        tick = (tick + grid / 2) / grid * grid;
+    }
+}
+
+void EventTimeline::transpose(uint8_t channel, int semitones) {
+    const std::size_t n = ticks.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        // Note Off (8n), Note On (9n) and key pressure (An) carry a note number
+        uint8_t kind = statuses[i] & 0xF0;
+        bool note = (kind == 0x80 || kind == 0x90 || kind == 0xA0) && (statuses[i] & 0x0F) == channel;
+        int moved = std::clamp(data1s[i] + semitones, 0, 127);
+        data1s[i] = note ? static_cast<uint8_t>(moved) : data1s[i];
+    }
+}
+
+void EventTimeline::accent(uint64_t period, uint8_t boost) {
+    if (period == 0) {
+        return;
+    }
+    const std::size_t n = ticks.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        bool hit = (statuses[i] & 0xF0) == 0x90 && data2s[i] != 0 && ticks[i] % period == 0;
+        int louder = std::min(data2s[i] + boost, 127);
+        data2s[i] = hit ? static_cast<uint8_t>(louder) : data2s[i];
+    }
+}
+
+std::size_t EventTimeline::encode(std::size_t begin, std::size_t end, uint64_t& lastTick, bool runningStatus,
+                                  uint8_t& status, uint8_t* out) const {
+    uint8_t* start = out;
+    for (std::size_t i = begin; i < end; ++i) {
+        uint32_t delta = static_cast<uint32_t>(ticks[i] - lastTick);
+        lastTick = ticks[i];
+        if (runningStatus) {
+            out += encodeRunningEvent(delta, statuses[i], data1s[i], data2s[i], status, out);
+        } else {
+            ChannelEvent event{delta, statuses[i], data1s[i], data2s[i]};
+            out += encodeEvents(&event, 1, out);
+        }
+    }
+    return out - start;
+}
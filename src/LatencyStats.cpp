@@ -0,0 +1,71 @@
+#include "LatencyStats.h"
+#include <algorithm>
+#include <cmath>
+
+// Values below 16 ns have a bucket each; above that, 16 buckets split every power of two
+std::size_t LatencyStats::bucketOf(uint64_t nanoseconds) {
+    if (nanoseconds < (uint64_t(1) << kSubBucketBits)) {
+        return static_cast<std::size_t>(nanoseconds);
+    }
+    unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(nanoseconds));
+    uint64_t sub = (nanoseconds >> (exponent - kSubBucketBits)) & ((uint64_t(1) << kSubBucketBits) - 1);
+    return (static_cast<std::size_t>(exponent - kSubBucketBits + 1) << kSubBucketBits) + static_cast<std::size_t>(sub);
+}
+
+// Largest value that falls in the bucket
+uint64_t LatencyStats::bucketLimit(std::size_t bucket) {
+    if (bucket < (std::size_t(1) << kSubBucketBits)) {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>(bucket >> kSubBucketBits) - 1;
+    uint64_t low = (uint64_t(1) << kSubBucketBits | (bucket & ((std::size_t(1) << kSubBucketBits) - 1))) << shift;
+    return low + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyStats::record(double milliseconds) {
+    uint64_t nanoseconds = 0;
+    if (milliseconds > 0.0) {
+        double scaled = milliseconds * 1e6;
+        nanoseconds = scaled < 1.8e19 ? static_cast<uint64_t>(scaled) : UINT64_MAX;
+    }
+    buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    recorded.fetch_add(1, std::memory_order_relaxed);
+    totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t largest = maxNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > largest &&
+           !maxNanoseconds.compare_exchange_weak(largest, nanoseconds, std::memory_order_relaxed)) {
+    }
+}
+
+// Nearest rank over the buckets; counts only grow, so a second pass always reaches the rank
+double LatencyStats::percentile(double p) const {
+    uint64_t samples = 0;
+    for (const std::atomic<uint64_t>& bucket : buckets) {
+        samples += bucket.load(std::memory_order_relaxed);
+    }
+    if (samples == 0) {
+        return 0.0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(samples)));
+    rank = std::clamp<uint64_t>(rank, 1, samples);
+    uint64_t largest = maxNanoseconds.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return static_cast<double>(std::min(bucketLimit(i), largest)) / 1e6;
+        }
+    }
+    return static_cast<double>(largest) / 1e6;
+}
+
+std::size_t LatencyStats::count() const {
+    return static_cast<std::size_t>(recorded.load(std::memory_order_relaxed));
+}
+
+double LatencyStats::mean() const {
+    uint64_t samples = recorded.load(std::memory_order_relaxed);
+    return samples == 0 ? 0.0 : static_cast<double>(totalNanoseconds.load(std::memory_order_relaxed)) / 1e6 / samples;
+}
@@ -0,0 +1,177 @@
+#include "Laykari.h"
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    constexpr std::size_t kMaxTableSubdivision = 64;
+    constexpr uint32_t kMinDivision = 480;
+    constexpr uint32_t kMaxDivision = 0x7FFF; // Top bit of the SMF division selects SMPTE timing
+
+    // Ticks per subdivision for a given division, 0 where it does not divide evenly
+    template <uint16_t Division>
+    constexpr std::array<uint16_t, kMaxTableSubdivision + 1> makeTickTable() {
+        std::array<uint16_t, kMaxTableSubdivision + 1> table{};
+        for (std::size_t s = 1; s <= kMaxTableSubdivision; ++s) {
+            table[s] = Division % s == 0 ? static_cast<uint16_t>(Division / s) : 0;
+        }
+        return table;
+    }
+
+    struct TickTable {
+        uint16_t division;
+        std::array<uint16_t, kMaxTableSubdivision + 1> ticks;
+    };
+
+    constexpr TickTable kTickTables[] = {
+        {480, makeTickTable<480>()},
+        {840, makeTickTable<840>()},
+        {960, makeTickTable<960>()},
+        {1680, makeTickTable<1680>()},
+    };
+    static_assert(makeTickTable<840>()[7] == 120 && makeTickTable<480>()[7] == 0, "tick tables");
+
+    const std::pair<const char*, unsigned> kDensityNames[] = {
+        {"barabar", 1}, {"ekgun", 1}, {"dugun", 2}, {"tigun", 3}, {"chaugun", 4},
+        {"paungun", 5}, {"chhagun", 6}, {"satgun", 7}, {"athgun", 8}
+    };
+
+    const std::pair<const char*, Gati> kGatiNames[] = {
+        {"chatusra", Gati::Chatusra}, {"tisra", Gati::Tisra}, {"khanda", Gati::Khanda}, {"misra", Gati::Misra}
+    };
+}
+
+Laykari parseLaykari(const std::string& text) {
+    std::string densityText = text.substr(0, text.find(':'));
+    std::string gatiText = text.find(':') == std::string::npos ? "" : text.substr(text.find(':') + 1);
+
+    Laykari laykari;
+    laykari.density = 0;
+    for (const auto& [name, density] : kDensityNames) {
+        if (densityText == name) {
+            laykari.density = density;
+        }
+    }
+    if (laykari.density == 0) {
+        std::size_t consumed = 0;
+        try {
+            laykari.density = static_cast<unsigned>(std::stoul(densityText, &consumed));
+        } catch (const std::exception&) {
+            consumed = 0;
+        }
+        if (consumed != densityText.size()) {
+            laykari.density = 0;
+        }
+    }
+    if (laykari.density < 1 || laykari.density > Laykari::kMaxDensity) {
+        throw std::invalid_argument("Laykari density must be 1-8 or a name like dugun: " + text);
+    }
+
+    if (!gatiText.empty()) {
+        bool found = false;
+        for (const auto& [name, gati] : kGatiNames) {
+            if (gatiText == name) {
+                laykari.gati = gati;
+                found = true;
+            }
+        }
+        if (!found) {
+            throw std::invalid_argument("Unknown gati (chatusra, tisra, khanda, misra): " + gatiText);
+        }
+    }
+    return laykari;
+}
+
+std::vector<Laykari> parseLaykariSequence(const std::string& text) {
+    std::vector<Laykari> sequence;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        sequence.push_back(parseLaykari(item));
+    }
+    if (sequence.empty()) {
+        throw std::invalid_argument("Empty laykari sequence");
+    }
+    return sequence;
+}
+
+LaykariPlan planLaykari(const Taal& taal, const std::vector<Laykari>& sequence, std::pmr::memory_resource* resource) {
+    if (taal.beats <= 0 || taal.bols.empty()) {
+        throw std::invalid_argument("Taal has no beats: " + taal.name);
+    }
+    static const Laykari barabar;
+    const Laykari* laykaris = sequence.empty() ? &barabar : sequence.data();
+    const std::size_t laykariCount = sequence.empty() ? 1 : sequence.size();
+
+    // A cycle of n notes per matra spans `beats` matras; its notes fit the grid exactly when
+    // PPQN * beats / notes is integral, i.e. when subdivision = notes / gcd(notes, beats) divides PPQN.
+    const uint64_t beats = static_cast<uint64_t>(taal.beats);
+    std::pmr::vector<uint64_t> notes(resource), subdivisions(resource);
+    notes.reserve(laykariCount);
+    subdivisions.reserve(laykariCount);
+    uint64_t lcm = 1;
+    for (std::size_t i = 0; i < laykariCount; ++i) {
+        const Laykari& laykari = laykaris[i];
+        if (laykari.density < 1 || laykari.density > Laykari::kMaxDensity) {
+            throw std::invalid_argument("Laykari density must be 1-8");
+        }
+        // Bols are spread evenly over the beats; each stroke is split notesPerMatra ways
+        uint64_t count = taal.bols.size() * static_cast<uint64_t>(laykari.notesPerMatra());
+        uint64_t subdivision = count / std::gcd(count, beats);
+        notes.push_back(count);
+        subdivisions.push_back(subdivision);
+        lcm = std::lcm(lcm, subdivision);
+        if (lcm > kMaxDivision) {
+            throw std::invalid_argument("Laykari subdivisions too fine for a MIDI division: " + taal.name);
+        }
+    }
+
+    LaykariPlan plan(resource);
+    const TickTable* table = nullptr;
+    for (const TickTable& candidate : kTickTables) {
+        bool fits = true;
+        for (uint64_t subdivision : subdivisions) {
+            fits = fits && subdivision <= kMaxTableSubdivision && candidate.ticks[subdivision] != 0;
+        }
+        if (fits) {
+            table = &candidate;
+            break;
+        }
+    }
+    if (table != nullptr) {
+        plan.division = table->division;
+    } else {
+        uint64_t division = lcm * ((kMinDivision + lcm - 1) / lcm);
+        plan.division = static_cast<uint16_t>(division <= kMaxDivision ? division : lcm);
+    }
+    plan.ticksPerCycle = beats * plan.division;
+
+    plan.steps.reserve(laykariCount);
+    for (std::size_t i = 0; i < laykariCount; ++i) {
+        uint64_t ticksPerSubdivision = table != nullptr ? table->ticks[subdivisions[i]] : plan.division / subdivisions[i];
+        LaykariStep step;
+        step.laykari = laykaris[i];
+        step.notesPerCycle = static_cast<uint32_t>(notes[i]);
+        step.ticksPerNote = static_cast<uint32_t>(ticksPerSubdivision * (beats / std::gcd(notes[i], beats)));
+        plan.steps.push_back(step);
+    }
+    return plan;
+}
+
+void alignLaykariPlans(std::vector<LaykariPlan>& plans) {
+    uint64_t division = 1;
+    for (const LaykariPlan& plan : plans) {
+        division = std::lcm(division, uint64_t(plan.division));
+        if (division > kMaxDivision) {
+            throw std::invalid_argument("Layers need a finer MIDI division than a file can hold");
+        }
+    }
+    for (LaykariPlan& plan : plans) {
+        uint64_t scale = division / plan.division;
+        plan.division = static_cast<uint16_t>(division);
+        plan.ticksPerCycle *= scale;
+        for (LaykariStep& step : plan.steps) {
+            step.ticksPerNote = static_cast<uint32_t>(step.ticksPerNote * scale);
+        }
+    }
+}
@@ -1,111 +1,606 @@
 #include "MIDIHandler.h"
+#include "Arrangement.h"
+#include "BolTable.h"
+#include "CycleCache.h"
+#include "EventStream.h"
+#include "EventTimeline.h"
+#include "Hash.h"
+#include "MidiEncoding.h"
+#include "MidiFileWriter.h"
+#include "Profiler.h"
+#include "RenderContext.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <fstream>
 #include <iostream>
-#include <unordered_map>
+#include <iterator>
+#include <memory_resource>
+#include <numeric>
 #include <vector>
 #include <cstdint>
 #include <stdexcept>
 
 namespace {
-    void writeVarLen(std::vector<uint8_t>& trackData, uint32_t value) {
-        uint8_t buffer[4];
-        int i = 0;
+    void validate(const Taal& taal, const Tempo& tempo, const RenderOptions& options) {
+        if (taal.beats <= 0 || taal.bols.empty()) {
+            throw std::invalid_argument("Taal has no beats: " + taal.name);
+        }
+        if (tempo.getBPM() <= 0) {
+            throw std::invalid_argument("Tempo must be positive: " + tempo.getName());
+        }
+        if (options.channel > 15 || options.velocity > 127 || options.samVelocity > 127) {
+            throw std::invalid_argument("MIDI channel must be 0-15 and velocities 0-127");
+        }
+        if (options.format > 1) {
+            throw std::invalid_argument("MIDI format must be 0 or 1");
+        }
+        if ((options.tanpura || options.lehra) && (options.tonic < 24 || options.tonic > 103)) {
+            throw std::invalid_argument("Tonic must be a MIDI note from 24 to 103");
+        }
+        if (!(options.tempoErrorMs > 0.0 && options.tempoErrorMs <= RenderOptions::kMaxTempoErrorMs)) {
+            throw std::invalid_argument("Tempo error bound must be above 0 and at most 1000 ms");
+        }
+        // Written so NaN fails too
+        if (!(options.durationSeconds >= 0.0 && options.durationSeconds <= RenderOptions::kMaxDurationSeconds)) {
+            throw std::invalid_argument("Duration must be from 0 to 86400 seconds");
+        }
+        if (options.durationSeconds == 0.0 && (options.cycles == 0 || options.cycles > RenderOptions::kMaxCycles)) {
+            throw std::invalid_argument("Cycles must be from 1 to 1000000");
+        }
+    }
 
-        do {
-            buffer[i++] = value & 0x7F;
-            value >>= 7;
-        } while (value > 0);
+    // Number of cycles needed to cover the requested length; a cycle is `beats` quarter notes
+    uint64_t cycleCount(uint64_t beats, const Tempo& tempo, const RenderOptions& options) {
+        if (options.durationSeconds <= 0.0) {
+            return options.cycles;
+        }
+        // A ramp spread over n cycles takes n times as long as over one
+        double secondsPerCycle = tempo.ramps()
+            ? tempo.map(beats * 480, 480).secondsAt(beats * 480)
+            : static_cast<double>(beats) * 60.0 / tempo.getBPM();
+        double cycles = std::ceil(options.durationSeconds / secondsPerCycle);
+        if (!(cycles <= double(RenderOptions::kMaxCycles))) {
+            throw std::invalid_argument("Duration needs more than 1000000 cycles at this tempo");
+        }
+        return static_cast<uint64_t>(cycles);
+    }
+
+    uint64_t cycleCount(const Taal& taal, const Tempo& tempo, const RenderOptions& options) {
+        return cycleCount(uint64_t(taal.beats), tempo, options);
+    }
 
-        for (int j = i - 1; j > 0; --j) {
-            trackData.push_back(buffer[j] | 0x80);
+    // Encodes the note events of one avartan at one laykari; every such cycle has the same bytes.
+    // With running status the cycle continues a Note On status, so its first status byte is
+    // left out too and the cycles can be copied back to back.
+    std::vector<uint8_t> encodeCycle(const Taal& taal, const RenderOptions& options, const LaykariStep& step) {
+        TANSEN_SCOPE("encode");
+        const BolTable& bolTable = BolTable::instance();
+
+        EventTimeline timeline;
+        timeline.reserve(std::size_t(step.notesPerCycle) * 2);
+        uint8_t noteOn = 0x90 | options.channel;
+        uint8_t noteOff = 0x80 | options.channel;
+        std::size_t bol = 0;
+        for (uint32_t i = 0; i < step.notesPerCycle; ++i) {
+            uint8_t note = bolTable.note(taal.bols[bol]); // Middle C if the bol has no mapping
+            uint8_t velocity = taal.bols[bol] == bolTable.rest() ? 0 : (i == 0 ? options.samVelocity : options.velocity);
+            uint64_t tick = uint64_t(i) * step.ticksPerNote;
+            timeline.append(tick, noteOn, note, velocity);
+            timeline.append(tick + step.ticksPerNote, noteOff, note, velocity);
+            if (++bol == taal.bols.size()) {
+                bol = 0; // Faster laykaris repeat the theka within the cycle
+            }
         }
-        trackData.push_back(buffer[0]);
+
+        std::vector<uint8_t> cycle(encodedSizeBound(timeline.size()));
+        uint64_t lastTick = 0;
+        uint8_t status = noteOn;
+        cycle.resize(timeline.encode(0, timeline.size(), lastTick, options.runningStatus, status, cycle.data()));
+        return cycle;
     }
 
-    void writeHeaderChunk(std::ofstream& out) {
-        out.write("MThd", 4); // Header chunk identifier
-        uint32_t headerLength = 6;
-        out.write(reinterpret_cast<const char*>(&headerLength), sizeof(headerLength)); // Header length
-        uint16_t format = 0; // Format type (0 = single track)
-        out.write(reinterpret_cast<const char*>(&format), sizeof(format));
-        uint16_t nTracks = 1; // Number of tracks
-        out.write(reinterpret_cast<const char*>(&nTracks), sizeof(nTracks));
-        uint16_t division = 480; // Pulses per quarter note (PPQN)
-        out.write(reinterpret_cast<const char*>(&division), sizeof(division));
+    // Note events in the first `cycles` cycles of the plan's laykari sequence
+    uint64_t thekaEventCount(const LaykariPlan& plan, uint64_t cycles) {
+        uint64_t perSequence = 0;
+        uint64_t partial = 0;
+        uint64_t remainder = cycles % plan.steps.size();
+        for (std::size_t i = 0; i < plan.steps.size(); ++i) {
+            perSequence += 2 * uint64_t(plan.steps[i].notesPerCycle);
+            if (i < remainder) {
+                partial += 2 * uint64_t(plan.steps[i].notesPerCycle);
+            }
+        }
+        return cycles / plan.steps.size() * perSequence + partial;
     }
 
-    void writeTrackChunk(std::ofstream& out, const std::vector<uint8_t>& trackData) {
-        out.write("MTrk", 4); // Track chunk identifier
-        uint32_t length = trackData.size();
-        out.write(reinterpret_cast<const char*>(&length), sizeof(length)); // Track length
-        out.write(reinterpret_cast<const char*>(trackData.data()), trackData.size());
+    // Program change and the avartans of the tabla, replicated from the cycle cache
+    void writeThekaEvents(MidiFileWriter& writer, const Taal& taal, const Tempo& tempo,
+                          const RenderOptions& options, const LaykariPlan& plan, RenderContext& context) {
+        // Program change: Assign Standard Drum Kit
+        writer.writeProgramChange(0, options.channel, 0);
+
+        CycleKey key;
+        key.pattern = fnv1a64(taal.bols.data(), taal.bols.size() * sizeof(BolId),
+                              fnv1a64(&taal.beats, sizeof(taal.beats)));
+        // The notes too: BolTable::setNote can remap a bol after its cycles were cached
+        const BolTable& bolTable = BolTable::instance();
+        for (BolId bol : taal.bols) {
+            uint8_t note = bolTable.note(bol);
+            key.pattern = fnv1a64(&note, sizeof(note), key.pattern);
+        }
+        key.bpm = tempo.getBPM();
+        key.channel = options.channel;
+        key.velocity = options.velocity;
+        key.samVelocity = options.samVelocity;
+        key.runningStatus = options.runningStatus;
+
+        std::pmr::vector<CycleCache::Cycle> encoded(context.resource());
+        encoded.reserve(plan.steps.size());
+        for (const LaykariStep& step : plan.steps) {
+            key.notesPerCycle = step.notesPerCycle;
+            key.ticksPerNote = step.ticksPerNote;
+            encoded.push_back(CycleCache::shared().getOrEncode(key, [&] {
+                return encodeCycle(taal, options, step);
+            }));
+        }
+
+        // Replicate the encoded avartans, one laykari per cycle in sequence. With running status
+        // only the first Note On, after the program change, needs its status byte: it goes
+        // between that event's delta time (0, one byte) and its data bytes.
+        uint64_t cycles = cycleCount(taal, tempo, options);
+        uint8_t noteOn = 0x90 | options.channel;
+        std::size_t next = 0;
+        for (uint64_t i = 0; i < cycles; ++i) {
+            const std::vector<uint8_t>& cycle = *encoded[next];
+            if (i == 0 && options.runningStatus) {
+                writer.writeBytes(cycle.data(), 1);
+                writer.writeByte(noteOn);
+                writer.writeBytes(cycle.data() + 1, cycle.size() - 1);
+            } else {
+                writer.writeBytes(cycle.data(), cycle.size());
+            }
+            if (++next == encoded.size()) {
+                next = 0;
+            }
+        }
+        writer.resumeRunningStatus(noteOn);
+        TANSEN_COUNT(Events, 1 + thekaEventCount(plan, cycles));
     }
 
-    void writeNoteEvent(std::vector<uint8_t>& trackData, uint8_t deltaTime, uint8_t channel, uint8_t note, uint8_t velocity, bool isNoteOn) {
-        writeVarLen(trackData, deltaTime);
-        trackData.push_back((isNoteOn ? 0x90 : 0x80) | channel); // Note On/Off + Channel
-        trackData.push_back(note);
-        trackData.push_back(velocity);
+    // Refuses a render whose track could outgrow the 32-bit MTrk length, before any event is
+    // written; otherwise the limit is only found once gigabytes have been streamed out
+    void checkTrackBound(uint64_t channelEvents, uint64_t metaEvents, std::size_t titleLength) {
+        constexpr uint64_t kMaxMetaEventBytes = kMaxVarLenBytes + 3 + 3; // A tempo change or "Sam" marker
+        uint64_t bound = 8 + kMaxVarLenBytes + 3 + titleLength + 4;      // MTrk header, name, end of track
+        bound += channelEvents * kMaxChannelEventBytes + metaEvents * kMaxMetaEventBytes;
+        if (bound > 0xFFFFFFFFULL) {
+            throw std::invalid_argument("Render is too long for a MIDI track (4 GiB); use fewer cycles or a slower laykari");
+        }
     }
 
-    void writeProgramChange(std::vector<uint8_t>& trackData, uint8_t channel, uint8_t program) {
-        trackData.push_back(0xC0 | channel); // Program Change + Channel
-        trackData.push_back(program); // Program number
+    // A tempo change or marker, written between the channel events at its tick
+    struct MetaEvent {
+        uint64_t tick;
+        uint32_t microsecondsPerQuarter; // A tempo change when nonzero
+        std::string_view text;           // Otherwise a marker (FF 06)
+    };
+
+    std::vector<MetaEvent> tempoEvents(const std::vector<TempoChange>& tempoChanges) {
+        std::vector<MetaEvent> meta;
+        meta.reserve(tempoChanges.size());
+        for (const TempoChange& change : tempoChanges) {
+            meta.push_back({change.tick, change.microsecondsPerQuarter, {}});
+        }
+        return meta;
+    }
+
+    void writeMeta(MidiFileWriter& writer, const MetaEvent& event, uint64_t& lastTick) {
+        uint32_t delta = static_cast<uint32_t>(event.tick - lastTick);
+        if (event.microsecondsPerQuarter != 0) {
+            writer.writeTempo(delta, event.microsecondsPerQuarter);
+        } else {
+            writer.writeMetaText(delta, 0x06, event.text);
+        }
+        lastTick = event.tick;
+    }
+
+    // Gathers the sources' events a window of ticks at a time into a timeline, sorts it and
+    // encodes it, with the meta events written at their ticks; memory is bounded by the window
+    void writeEvents(MidiFileWriter& writer, std::vector<std::unique_ptr<EventStream>>& sources, uint64_t windowTicks,
+                     const std::vector<MetaEvent>& meta = {}) {
+        std::vector<MidiEvent> heads(sources.size());
+        std::vector<char> pending(sources.size());
+        for (std::size_t i = 0; i < sources.size(); ++i) {
+            pending[i] = sources[i]->next(heads[i]);
+        }
+
+        EventTimeline timeline;
+        uint64_t lastTick = 0;
+        std::size_t nextMeta = 0;
+        auto writeMetaUpTo = [&](uint64_t tick) {
+            for (; nextMeta < meta.size() && meta[nextMeta].tick <= tick; ++nextMeta) {
+                writeMeta(writer, meta[nextMeta], lastTick);
+            }
+        };
+        while (true) {
+            uint64_t windowStart = UINT64_MAX;
+            for (std::size_t i = 0; i < sources.size(); ++i) {
+                if (pending[i]) {
+                    windowStart = std::min(windowStart, heads[i].tick);
+                }
+            }
+            if (windowStart == UINT64_MAX) {
+                break;
+            }
+            timeline.clear();
+            for (std::size_t i = 0; i < sources.size(); ++i) {
+                while (pending[i] && heads[i].tick < windowStart + windowTicks) {
+                    timeline.append(heads[i]);
+                    pending[i] = sources[i]->next(heads[i]);
+                }
+            }
+            timeline.sort(); // Stable, so simultaneous events keep the sources' order
+            TANSEN_COUNT(Events, timeline.size());
+
+            for (std::size_t begin = 0; begin < timeline.size();) {
+                writeMetaUpTo(timeline.tick(begin));
+                std::size_t end = begin + 1;
+                while (end < timeline.size() && (nextMeta == meta.size() || timeline.tick(end) < meta[nextMeta].tick)) {
+                    ++end;
+                }
+                writer.writeTimeline(timeline, begin, end, lastTick);
+                begin = end;
+            }
+        }
+        writeMetaUpTo(UINT64_MAX);
+    }
+
+    // Tanpura and lehra, on the lowest channels the tabla does not use
+    std::vector<std::unique_ptr<EventStream>> accompaniment(const Taal& taal, const std::string& raag,
+                                                            const RenderOptions& options, const LaykariPlan& plan,
+                                                            uint64_t totalTicks) {
+        std::vector<std::unique_ptr<EventStream>> streams;
+        uint8_t channel = 0;
+        auto nextChannel = [&] {
+            if (channel == options.channel) {
+                ++channel;
+            }
+            return channel++;
+        };
+        if (options.tanpura) {
+            streams.push_back(makeTanpuraStream(taal, raag, options.tonic, nextChannel(), plan, totalTicks));
+        }
+        if (options.lehra) {
+            streams.push_back(makeLehraStream(taal, raag, options.tonic, nextChannel(), plan, totalTicks));
+        }
+        return streams;
     }
-}
 
-void MIDIHandler::generateTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath) const {
-    std::ofstream midiFile(outputPath, std::ios::binary);
-    if (!midiFile.is_open()) {
-        throw std::runtime_error("Failed to open MIDI file for writing: " + outputPath);
+    uint16_t trackCount(const RenderOptions& options) {
+        if (options.format == 0) {
+            return 1;
+        }
+        return 2 + options.tanpura + options.lehra; // Tempo track, tabla, accompaniment
     }
 
-    // Write the MIDI header chunk
-    writeHeaderChunk(midiFile);
+    std::pmr::string trackTitle(const Taal& taal, const std::string& raag, RenderContext& context) {
+        std::pmr::string title(context.resource());
+        if (raag.empty()) {
+            title = taal.name;
+        } else {
+            title.reserve(raag.size() + 3 + taal.name.size());
+            title.append(raag).append(" - ").append(taal.name);
+        }
+        return title;
+    }
 
-    // Create the track data
-    std::vector<uint8_t> trackData;
+    // Exact size of a Format 0 file without accompaniment, so in-memory renders reserve once
+    uint64_t thekaFileSize(const Taal& taal, const Tempo& tempo, const RenderOptions& options,
+                           const LaykariPlan& plan, std::size_t titleLength) {
+        uint64_t size = 14 + 8;                                         // MThd chunk, MTrk header
+        size += 3 + varLenSize(static_cast<uint32_t>(titleLength)) + titleLength; // Track name
+        size += 7 + 3 + 4;                                              // Tempo, program change, end of track
+        size += options.runningStatus ? 1 : 0;                          // Status of the first Note On
 
-    // Add a tempo event (Meta Event FF 51 03 tttttt)
-    trackData.push_back(0x00); // Delta time
-    trackData.push_back(0xFF); // Meta event
-    trackData.push_back(0x51); // Tempo
-    trackData.push_back(0x03); // Length of tempo data
-    uint32_t tempoValue = 60000000 / tempo.bpm; // Microseconds per quarter note
-    trackData.push_back((tempoValue >> 16) & 0xFF);
-    trackData.push_back((tempoValue >> 8) & 0xFF);
-    trackData.push_back(tempoValue & 0xFF);
+        uint64_t cycles = cycleCount(taal, tempo, options);
+        for (std::size_t i = 0; i < plan.steps.size(); ++i) {
+            const LaykariStep& step = plan.steps[i];
+            uint64_t repeats = cycles / plan.steps.size() + (i < cycles % plan.steps.size() ? 1 : 0);
+            uint64_t statusBytes = options.runningStatus ? 0 : 2;
+            uint64_t pairBytes = (1 + 2) + (varLenSize(step.ticksPerNote) + 2) + statusBytes; // Note On at delta 0, Note Off
+            size += repeats * step.notesPerCycle * pairBytes;
+        }
+        return size;
+    }
 
-    // Program change: Assign Standard Drum Kit to channel 10
-    writeProgramChange(trackData, 9, 0); // Channel 10 (0-based), Program 0
+    // Set Tempo value of a steady tempo
+    uint32_t steadyMicrosecondsPerQuarter(const Tempo& tempo) {
+        return static_cast<uint32_t>(60000000 / tempo.getBPM());
+    }
+
+    // Set Tempo events for the whole render: one for a steady tempo, or as few as follow a ramp
+    std::vector<TempoChange> tempoChangesFor(const Tempo& tempo, uint64_t totalTicks, uint16_t division,
+                                             const RenderOptions& options) {
+        if (!tempo.ramps()) {
+            return {{0, steadyMicrosecondsPerQuarter(tempo)}};
+        }
+        return tempo.map(totalTicks, division).tempoChanges(totalTicks, options.tempoErrorMs / 1000.0);
+    }
+
+    // Tempo events and a "Sam" marker on every common sam of the layers, in tick order
+    std::vector<MetaEvent> layerMetaEvents(const std::vector<TempoChange>& tempoChanges, uint64_t superCycleTicks,
+                                           uint64_t superCycles) {
+        std::vector<MetaEvent> markers;
+        markers.reserve(superCycles + 1);
+        for (uint64_t i = 0; i <= superCycles; ++i) {
+            markers.push_back({i * superCycleTicks, 0, "Sam"});
+        }
+        std::vector<MetaEvent> tempo = tempoEvents(tempoChanges);
+        std::vector<MetaEvent> meta(tempo.size() + markers.size());
+        // Stable: a tempo change goes before the marker at the same tick
+        std::merge(tempo.begin(), tempo.end(), markers.begin(), markers.end(), meta.begin(),
+                   [](const MetaEvent& a, const MetaEvent& b) { return a.tick < b.tick; });
+        return meta;
+    }
 
-    // Note mapping for bols (General MIDI percussion keys)
-    std::unordered_map<std::string, uint8_t> bolToNote = {
-        {"Dha", 36}, {"Dhin", 38}, {"Na", 40}, {"Ti", 42}, {"Ge", 44},
-        {"Ka", 46}, {"Ta", 48}, {"Tom", 50}, {"Nam", 52}, {"Jo", 54},
-        {"Nu", 56}, {"Di", 58}, {"Mi", 60}
+    // What a render streams besides the cached theka cycles, planned before any output is opened
+    struct TaalRender {
+        uint64_t totalTicks = 0;
+        std::vector<std::unique_ptr<EventStream>> streams; // Tanpura and lehra
+        std::vector<TempoChange> tempoChanges;             // Empty for a steady tempo
     };
 
-    uint8_t velocity = 80; // Default velocity for notes
-    uint8_t duration = 480 / taal.beats; // Note duration in ticks
+    // Plans the render, refusing it before anything is written if its track could outgrow the MTrk length field
+    TaalRender planTaalRender(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                              const RenderOptions& options, const LaykariPlan& plan) {
+        TaalRender render;
+        uint64_t cycles = cycleCount(taal, tempo, options);
+        render.totalTicks = cycles * plan.ticksPerCycle;
+        render.streams = accompaniment(taal, raag, options, plan, render.totalTicks);
 
-    // Generate note events for the Taal
-    for (int cycle = 0; cycle < 4; ++cycle) { // Play Taal 4 times
-        for (const auto& bol : taal.bols) {
-            uint8_t note = bolToNote.count(bol) ? bolToNote[bol] : 60; // Default to middle C if bol not found
-            writeNoteEvent(trackData, 0, 9, note, velocity, true);  // Note On (channel 10)
-            writeNoteEvent(trackData, duration, 9, note, velocity, false); // Note Off (channel 10)
+        // A steady tempo is written directly, without building a one-element list
+        if (tempo.ramps()) {
+            render.tempoChanges = tempoChangesFor(tempo, render.totalTicks, plan.division, options);
         }
+
+        // Format 0 holds every event in one track; bounding that also bounds each Format 1 track
+        uint64_t channelEvents = 1 + thekaEventCount(plan, cycles);
+        for (const auto& stream : render.streams) {
+            channelEvents += stream->eventBound();
+        }
+        checkTrackBound(channelEvents, 1 + render.tempoChanges.size(), raag.size() + 3 + taal.name.size());
+        return render;
+    }
+
+    void writeTaalFile(MidiFileWriter& writer, const Taal& taal, const Tempo& tempo, const std::string& raag,
+                       const RenderOptions& options, const LaykariPlan& plan, TaalRender& render, RenderContext& context) {
+        auto& streams = render.streams;
+        const std::vector<TempoChange>& tempoChanges = render.tempoChanges;
+        uint64_t totalTicks = render.totalTicks;
+
+        writer.setRunningStatus(options.runningStatus);
+        writer.beginTrack();
+
+        // Track name (Meta Event FF 03)
+        writer.writeMetaText(0, 0x03, trackTitle(taal, raag, context));
+        if (!tempo.ramps()) {
+            writer.writeTempo(0, steadyMicrosecondsPerQuarter(tempo));
+        }
+
+        if (options.format == 0) {
+            if (streams.empty() && tempoChanges.empty()) {
+                writeThekaEvents(writer, taal, tempo, options, plan, context);
+            } else {
+                // Interleave every instrument, and the tempo changes, into the single track
+                streams.insert(streams.begin(), makeThekaStream(taal, options, plan, totalTicks));
+                writeEvents(writer, streams, plan.ticksPerCycle, tempoEvents(tempoChanges));
+            }
+            writer.writeEndOfTrack();
+            writer.endTrack();
+            return;
+        }
+
+        // Format 1: the first track holds only the name and tempo map
+        uint64_t lastTick = 0;
+        for (const TempoChange& change : tempoChanges) {
+            writer.writeTempo(static_cast<uint32_t>(change.tick - lastTick), change.microsecondsPerQuarter);
+            lastTick = change.tick;
+        }
+        writer.writeEndOfTrack();
+        writer.endTrack();
+
+        writer.beginTrack();
+        writer.writeMetaText(0, 0x03, "Tabla");
+        writeThekaEvents(writer, taal, tempo, options, plan, context);
+        writer.writeEndOfTrack();
+        writer.endTrack();
+
+        for (auto& stream : streams) {
+            writer.beginTrack();
+            writer.writeMetaText(0, 0x03, stream->name());
+            std::vector<std::unique_ptr<EventStream>> track;
+            track.push_back(std::move(stream));
+            writeEvents(writer, track, plan.ticksPerCycle);
+            writer.writeEndOfTrack();
+            writer.endTrack();
+        }
+    }
+}
+
+std::vector<uint8_t> MIDIHandler::renderTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const RenderOptions& options) const {
+    std::vector<uint8_t> midiData;
+    renderTaalMIDI(taal, tempo, raag, options, RenderContext::forThisThread(), midiData);
+    return midiData;
+}
+
+void MIDIHandler::renderTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const RenderOptions& options,
+                                 RenderContext& context, std::vector<uint8_t>& midiData) const {
+    TANSEN_SCOPE("render");
+    TANSEN_COUNT_ALLOCATIONS();
+    validate(taal, tempo, options);
+    context.reset();
+
+    LaykariPlan plan = planLaykari(taal, options.laykari, context.resource());
+    midiData.clear();
+    if (options.format == 0 && !options.tanpura && !options.lehra && !tempo.ramps()) {
+        std::size_t titleLength = raag.empty() ? taal.name.size() : raag.size() + 3 + taal.name.size();
+        midiData.reserve(thekaFileSize(taal, tempo, options, plan, titleLength));
+    }
+
+    TaalRender render = planTaalRender(taal, tempo, raag, options, plan);
+    MidiFileWriter writer(midiData, options.format, trackCount(options), plan.division);
+    writeTaalFile(writer, taal, tempo, raag, options, plan, render, context);
+    TANSEN_COUNT(Renders, 1);
+    TANSEN_COUNT(Bytes, writer.size());
+}
+
+void MIDIHandler::writeTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath, const RenderOptions& options) const {
+    writeTaalMIDI(taal, tempo, raag, outputPath, options, RenderContext::forThisThread());
+}
+
+void MIDIHandler::writeTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath,
+                                const RenderOptions& options, RenderContext& context) const {
+    TANSEN_SCOPE("render");
+    TANSEN_COUNT_ALLOCATIONS();
+    validate(taal, tempo, options);
+    context.reset();
+    LaykariPlan plan = planLaykari(taal, options.laykari, context.resource());
+
+    TaalRender render = planTaalRender(taal, tempo, raag, options, plan);
+    std::ofstream& midiFile = context.openFile(outputPath);
+
+    // Events stream through the writer's fixed buffer; memory use does not grow with the track
+    MidiFileWriter writer(midiFile, options.format, trackCount(options), plan.division);
+    writeTaalFile(writer, taal, tempo, raag, options, plan, render, context);
+    TANSEN_COUNT(Renders, 1);
+    TANSEN_COUNT(Bytes, writer.size());
+
+    midiFile.close();
+    if (!midiFile) {
+        throw std::runtime_error("Failed to write MIDI file: " + outputPath);
+    }
+}
+
+LayerAlignment MIDIHandler::writeLayeredMIDI(const std::vector<Taal>& layers, const Tempo& tempo,
+                                            const std::string& outputPath, const RenderOptions& options) const {
+    TANSEN_SCOPE("render");
+    if (layers.size() < 2 || layers.size() > 16) {
+        throw std::invalid_argument("Layering takes 2 to 16 Taals");
+    }
+    LayerAlignment alignment;
+    alignment.superCycleBeats = 1;
+    std::vector<LaykariPlan> plans;
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        validate(layers[i], tempo, options);
+        plans.push_back(planLaykari(layers[i], options.laykari));
+        alignment.superCycleBeats = std::lcm(alignment.superCycleBeats, uint64_t(layers[i].beats));
+        alignment.channels.push_back(static_cast<uint8_t>((options.channel + i) % 16));
+    }
+    alignLaykariPlans(plans);
+    const uint16_t division = plans.front().division;
+
+    uint64_t superCycleTicks = alignment.superCycleBeats * division;
+    alignment.superCycles = cycleCount(alignment.superCycleBeats, tempo, options);
+    uint64_t totalTicks = alignment.superCycles * superCycleTicks;
+
+    // Each layer replays its own cycle; the window is the shortest cycle, so only one cycle
+    // of every layer is ever in memory however long the super-cycle
+    std::vector<std::vector<std::unique_ptr<EventStream>>> layerStreams(layers.size());
+    uint64_t windowTicks = UINT64_MAX;
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        alignment.cyclesPerSuperCycle.push_back(alignment.superCycleBeats / layers[i].beats);
+        RenderOptions layerOptions = options;
+        layerOptions.channel = alignment.channels[i];
+        if (layerOptions.channel != 9) {
+            // Bank Select MSB 120, LSB 0: the GM2 drum kits, on a channel that is not the GM percussion channel
+            uint8_t control = static_cast<uint8_t>(0xB0 | layerOptions.channel);
+            layerStreams[i].push_back(std::make_unique<LoopStream>(
+                "", std::vector<MidiEvent>{{0, control, 0, 120}, {0, control, 32, 0}},
+                std::vector<MidiEvent>{}, 0, totalTicks));
+        }
+        layerStreams[i].push_back(makeThekaStream(layers[i], layerOptions, plans[i], totalTicks));
+        windowTicks = std::min(windowTicks, plans[i].ticksPerCycle);
+    }
+    std::vector<MetaEvent> meta = layerMetaEvents(tempoChangesFor(tempo, totalTicks, division, options),
+                                                  superCycleTicks, alignment.superCycles);
+    uint64_t channelEvents = 0;
+    std::size_t titleLength = 0;
+    for (std::size_t i = 0; i < layers.size(); ++i) {
+        for (const auto& stream : layerStreams[i]) {
+            channelEvents += stream->eventBound();
+        }
+        titleLength += 3 + layers[i].name.size();
     }
+    checkTrackBound(channelEvents, meta.size(), titleLength);
 
-    // End of track event (Meta Event FF 2F 00)
-    trackData.push_back(0x00); // Delta time
-    trackData.push_back(0xFF); // Meta event
-    trackData.push_back(0x2F); // End of track
-    trackData.push_back(0x00); // Length
+    RenderContext& context = RenderContext::forThisThread();
+    context.reset();
+    std::ofstream& midiFile = context.openFile(outputPath);
+    uint16_t tracks = options.format == 0 ? 1 : static_cast<uint16_t>(1 + layers.size());
+    MidiFileWriter writer(midiFile, options.format, tracks, division);
+    writer.setRunningStatus(options.runningStatus);
 
-    // Write the track chunk
-    writeTrackChunk(midiFile, trackData);
+    std::string title = layers.front().name;
+    for (std::size_t i = 1; i < layers.size(); ++i) {
+        title.append(" / ").append(layers[i].name);
+    }
+    writer.beginTrack();
+    writer.writeMetaText(0, 0x03, title);
+    if (options.format == 0) {
+        std::vector<std::unique_ptr<EventStream>> streams;
+        for (auto& layer : layerStreams) {
+            std::move(layer.begin(), layer.end(), std::back_inserter(streams));
+        }
+        writeEvents(writer, streams, windowTicks, meta);
+    } else {
+        // Format 1: a conductor track with the tempo map and markers, then one track per layer
+        uint64_t lastTick = 0;
+        for (const MetaEvent& event : meta) {
+            writeMeta(writer, event, lastTick);
+        }
+    }
+    writer.writeEndOfTrack();
+    writer.endTrack();
+
+    for (std::size_t i = 0; options.format == 1 && i < layers.size(); ++i) {
+        writer.beginTrack();
+        writer.writeMetaText(0, 0x03, layers[i].name);
+        writeEvents(writer, layerStreams[i], plans[i].ticksPerCycle);
+        writer.writeEndOfTrack();
+        writer.endTrack();
+    }
+    TANSEN_COUNT(Renders, 1);
+    TANSEN_COUNT(Bytes, writer.size());
+
+    midiFile.close();
+    if (!midiFile) {
+        throw std::runtime_error("Failed to write MIDI file: " + outputPath);
+    }
+    return alignment;
+}
+
+RenderEvents MIDIHandler::renderEvents(const Taal& taal, const Tempo& tempo, const std::string& raag,
+                                       const RenderOptions& options) const {
+    validate(taal, tempo, options);
+    RenderEvents events;
+    events.plan = planLaykari(taal, options.laykari);
+    events.totalTicks = cycleCount(taal, tempo, options) * events.plan.ticksPerCycle;
+    auto streams = accompaniment(taal, raag, options, events.plan, events.totalTicks);
+    streams.insert(streams.begin(), makeThekaStream(taal, options, events.plan, events.totalTicks));
+    events.stream = std::make_unique<MergedStream>("", std::move(streams));
+    return events;
+}
+
+void MIDIHandler::exportTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath,
+                                 const RenderOptions& options, OutputSink& sink, RenderContext& context) const {
+    std::vector<uint8_t>& midiData = context.output();
+    renderTaalMIDI(taal, tempo, raag, options, context, midiData);
+    TANSEN_SCOPE("write");
+    sink.write(outputPath, midiData.data(), midiData.size());
+}
 
+void MIDIHandler::generateTaalMIDI(const Taal& taal, const Tempo& tempo, const std::string& raag, const std::string& outputPath, const RenderOptions& options) const {
+    writeTaalMIDI(taal, tempo, raag, outputPath, options);
     std::cout << "MIDI file generated: " << outputPath << std::endl;
 }
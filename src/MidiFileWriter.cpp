@@ -0,0 +1,205 @@
+#include "MidiFileWriter.h"
+#include "EventTimeline.h"
+#include "MidiEncoding.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+namespace {
+    void storeBigEndian32(uint8_t* out, uint32_t value) {
+        out[0] = (value >> 24) & 0xFF;
+        out[1] = (value >> 16) & 0xFF;
+        out[2] = (value >> 8) & 0xFF;
+        out[3] = value & 0xFF;
+    }
+
+    void storeBigEndian16(uint8_t* out, uint16_t value) {
+        out[0] = (value >> 8) & 0xFF;
+        out[1] = value & 0xFF;
+    }
+}
+
+MidiFileWriter::MidiFileWriter(std::ostream& out, uint16_t format, uint16_t trackCount, uint16_t division)
+    : stream(&out) {
+    writeHeaderChunk(format, trackCount, division);
+}
+
+MidiFileWriter::MidiFileWriter(std::vector<uint8_t>& out, uint16_t format, uint16_t trackCount, uint16_t division)
+    : memory(&out) {
+    written = out.size();
+    writeHeaderChunk(format, trackCount, division);
+}
+
+void MidiFileWriter::writeHeaderChunk(uint16_t format, uint16_t trackCount, uint16_t division) {
+    uint8_t header[14] = {'M', 'T', 'h', 'd'}; // Header chunk identifier
+    storeBigEndian32(header + 4, 6);           // Header length
+    storeBigEndian16(header + 8, format);      // 0 = single track, 1 = simultaneous tracks
+    storeBigEndian16(header + 10, trackCount); // Number of tracks
+    storeBigEndian16(header + 12, division);   // Pulses per quarter note (PPQN)
+    writeRaw(header, sizeof(header));
+}
+
+void MidiFileWriter::beginTrack() {
+    if (inTrack) {
+        throw std::logic_error("MIDI track already open");
+    }
+    flush();
+    lengthField = written + 4;
+
+    static const uint8_t placeholder[8] = {'M', 'T', 'r', 'k', 0, 0, 0, 0}; // Length patched by endTrack
+    writeRaw(placeholder, sizeof(placeholder));
+    trackBytes = 0;
+    runningStatus = 0;
+    inTrack = true;
+}
+
+void MidiFileWriter::endTrack() {
+    if (!inTrack) {
+        throw std::logic_error("No MIDI track open");
+    }
+    flush();
+    inTrack = false;
+    if (trackBytes > 0xFFFFFFFFULL) {
+        throw std::runtime_error("MIDI track exceeds the 4 GiB chunk limit");
+    }
+
+    uint8_t length[4];
+    storeBigEndian32(length, static_cast<uint32_t>(trackBytes));
+    if (memory != nullptr) {
+        std::memcpy(memory->data() + lengthField, length, sizeof(length));
+        return;
+    }
+
+    std::ostream::pos_type end = stream->tellp();
+    stream->seekp(static_cast<std::streamoff>(lengthField - (written - static_cast<uint64_t>(end))));
+    stream->write(reinterpret_cast<const char*>(length), sizeof(length));
+    stream->seekp(end);
+    if (!*stream) {
+        throw std::runtime_error("Failed to backpatch MIDI track length");
+    }
+}
+
+void MidiFileWriter::writeBytes(const uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        std::size_t chunk = std::min(size, buffer.size() - used);
+        std::memcpy(buffer.data() + used, data, chunk);
+        used += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void MidiFileWriter::writeVarLen(uint32_t value) {
+    uint8_t bytes[kMaxVarLenBytes];
+    writeBytes(bytes, encodeVarLen(value, bytes));
+}
+
+void MidiFileWriter::writeNoteEvent(uint32_t deltaTime, uint8_t channel, uint8_t note, uint8_t velocity, bool isNoteOn) {
+    if (runningStatusEnabled) {
+        writeChannelEvent(deltaTime, static_cast<uint8_t>((isNoteOn ? 0x90 : 0x80) | channel), note, velocity);
+        return;
+    }
+    uint8_t bytes[kMaxChannelEventBytes];
+    writeBytes(bytes, encodeNoteEvent(deltaTime, channel, note, velocity, isNoteOn, bytes));
+}
+
+void MidiFileWriter::writeProgramChange(uint32_t deltaTime, uint8_t channel, uint8_t program) {
+    uint8_t status = 0xC0 | channel; // Program Change + Channel
+    writeVarLen(deltaTime);
+    if (!runningStatusEnabled || status != runningStatus) {
+        writeByte(status);
+    }
+    runningStatus = status;
+    writeByte(program);              // Program number
+}
+
+void MidiFileWriter::writeChannelEvent(uint32_t deltaTime, uint8_t status, uint8_t data1, uint8_t data2) {
+    ChannelEvent event{deltaTime, status, data1, data2};
+    writeEvents(&event, 1);
+}
+
+// Encodes straight into the buffer in batches that are known to fit
+void MidiFileWriter::writeEvents(const ChannelEvent* events, std::size_t count) {
+    while (count > 0) {
+        if (buffer.size() - used < encodedSizeBound(1)) {
+            flush();
+        }
+        std::size_t batch = std::min(count, (buffer.size() - used - kEncodeSlack) / kMaxChannelEventBytes);
+        if (runningStatusEnabled) {
+            used += encodeEventsRunning(events, batch, runningStatus, buffer.data() + used);
+        } else {
+            used += encodeEvents(events, batch, buffer.data() + used);
+        }
+        events += batch;
+        count -= batch;
+    }
+}
+
+void MidiFileWriter::writeTimeline(const EventTimeline& timeline, std::size_t begin, std::size_t end, uint64_t& lastTick) {
+    while (begin < end) {
+        if (buffer.size() - used < encodedSizeBound(1)) {
+            flush();
+        }
+        std::size_t batch = std::min(end - begin, (buffer.size() - used - kEncodeSlack) / kMaxChannelEventBytes);
+        used += timeline.encode(begin, begin + batch, lastTick, runningStatusEnabled, runningStatus, buffer.data() + used);
+        begin += batch;
+    }
+}
+
+// Meta Event FF 51 03 tttttt
+void MidiFileWriter::writeTempo(uint32_t deltaTime, uint32_t microsecondsPerQuarter) {
+    runningStatus = 0;
+    writeVarLen(deltaTime);
+    const uint8_t event[] = {
+        0xFF, 0x51, 0x03,
+        static_cast<uint8_t>((microsecondsPerQuarter >> 16) & 0xFF),
+        static_cast<uint8_t>((microsecondsPerQuarter >> 8) & 0xFF),
+        static_cast<uint8_t>(microsecondsPerQuarter & 0xFF)
+    };
+    writeBytes(event, sizeof(event));
+}
+
+// Meta Event FF <type> <length> <text>, e.g. 0x03 for the track name
+void MidiFileWriter::writeMetaText(uint32_t deltaTime, uint8_t type, std::string_view text) {
+    runningStatus = 0;
+    writeVarLen(deltaTime);
+    writeByte(0xFF);
+    writeByte(type);
+    writeVarLen(static_cast<uint32_t>(text.size()));
+    writeBytes(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+// Meta Event FF 2F 00
+void MidiFileWriter::writeEndOfTrack(uint32_t deltaTime) {
+    runningStatus = 0;
+    writeVarLen(deltaTime);
+    static const uint8_t event[] = {0xFF, 0x2F, 0x00};
+    writeBytes(event, sizeof(event));
+}
+
+void MidiFileWriter::writeRaw(const uint8_t* data, std::size_t size) {
+    if (memory != nullptr) {
+        memory->insert(memory->end(), data, data + size);
+    } else {
+        stream->write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!*stream) {
+            throw std::runtime_error("Failed to write MIDI data");
+        }
+    }
+    written += size;
+}
+
+void MidiFileWriter::flush() {
+    if (used == 0) {
+        return;
+    }
+    TANSEN_SCOPE("write");
+    writeRaw(buffer.data(), used);
+    trackBytes += used;
+    used = 0;
+}
@@ -0,0 +1,108 @@
+#include "MidiSink.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef TANSEN_WITH_RTMIDI
+#include <RtMidi.h>
+#endif
+
+LogSink::LogSink(std::ostream& out) : out(out) {}
+
+void LogSink::send(const uint8_t* message, std::size_t size, Clock::time_point deadline) {
+    Clock::time_point now = Clock::now();
+    if (!started) {
+        origin = deadline;
+        started = true;
+    }
+
+    char line[64];
+    int length = std::snprintf(line, sizeof(line), "%lld %lld",
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(deadline - origin).count()),
+        static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(now - origin).count()));
+    out.write(line, length);
+    for (std::size_t i = 0; i < size; ++i) {
+        length = std::snprintf(line, sizeof(line), " %02X", message[i]);
+        out.write(line, length);
+    }
+    out.put('\n');
+}
+
+FifoSink::FifoSink(const std::string& path) {
+    if (::mkfifo(path.c_str(), 0644) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Unable to create FIFO " + path + ": " + std::strerror(errno));
+    }
+    fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Unable to open FIFO " + path + ": " + std::strerror(errno));
+    }
+}
+
+FifoSink::~FifoSink() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+void FifoSink::send(const uint8_t* message, std::size_t size, Clock::time_point) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, message, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("FIFO write failed: ") + std::strerror(errno));
+        }
+        message += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+#ifdef TANSEN_WITH_RTMIDI
+RtMidiSink::RtMidiSink(const std::string& portName) : output(std::make_unique<RtMidiOut>()) {
+    output->openVirtualPort(portName);
+}
+
+RtMidiSink::~RtMidiSink() = default;
+
+void RtMidiSink::send(const uint8_t* message, std::size_t size, Clock::time_point) {
+    output->sendMessage(message, size);
+}
+#endif
+
+std::unique_ptr<MidiSink> makeMidiSink(const std::string& spec) {
+    std::string kind = spec.substr(0, spec.find(':'));
+    std::string argument = spec.find(':') == std::string::npos ? "" : spec.substr(spec.find(':') + 1);
+
+    if (kind == "log") {
+        if (argument.empty()) {
+            return std::make_unique<LogSink>(std::cout);
+        }
+        // The stream lives as long as the sink
+        struct FileLogSink : LogSink {
+            explicit FileLogSink(std::unique_ptr<std::ofstream> file) : LogSink(*file), file(std::move(file)) {}
+            std::unique_ptr<std::ofstream> file;
+        };
+        auto file = std::make_unique<std::ofstream>(argument);
+        if (!file->is_open()) {
+            throw std::runtime_error("Unable to open log file: " + argument);
+        }
+        return std::make_unique<FileLogSink>(std::move(file));
+    }
+    if (kind == "fifo" && !argument.empty()) {
+        return std::make_unique<FifoSink>(argument);
+    }
+#ifdef TANSEN_WITH_RTMIDI
+    if (kind == "rtmidi") {
+        return std::make_unique<RtMidiSink>(argument.empty() ? "Tansen" : argument);
+    }
+#endif
+    throw std::invalid_argument("Unknown MIDI sink: " + spec);
+}
@@ -0,0 +1,396 @@
+#include "NameIndex.h"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    constexpr std::size_t kHeaderSize = 5 * sizeof(uint32_t);
+    constexpr std::size_t kSlotSize = 4 * sizeof(uint32_t);
+    constexpr std::size_t kTrigramSize = 2 * sizeof(uint32_t);
+    constexpr uint32_t kKeysPerBucket = 2;
+    constexpr uint32_t kMaxSeed = 1u << 24;
+    constexpr double kMinSimilarity = 0.3;
+    constexpr std::size_t kMaxScannedPostings = 1 << 16;
+
+    char lower(char c) {
+        return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    std::string normalize(std::string_view name) {
+        std::string key(name);
+        std::transform(key.begin(), key.end(), key.begin(), lower);
+        return key;
+    }
+
+    uint64_t mix(uint64_t value) {
+        value ^= value >> 30;
+        value *= 0xbf58476d1ce4e5b9ULL;
+        value ^= value >> 27;
+        value *= 0x94d049bb133111ebULL;
+        return value ^ (value >> 31);
+    }
+
+    // FNV-1a of the lowercased name, so lookups need no normalized copy. FNV's high bits barely
+    // differ between similar names ("taal146", "taal151"), so it is finalized before bucketing.
+    uint64_t hashName(std::string_view name) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (char c : name) {
+            hash ^= static_cast<uint8_t>(lower(c));
+            hash *= 0x100000001b3ULL;
+        }
+        return mix(hash);
+    }
+
+    uint32_t bucketOf(uint64_t hash, uint32_t bucketCount) {
+        return static_cast<uint32_t>((hash >> 32) % bucketCount);
+    }
+
+    uint32_t seededSlot(uint64_t hash, uint32_t seed, uint32_t keyCount) {
+        return static_cast<uint32_t>(mix(hash ^ (seed * 0x9e3779b97f4a7c15ULL)) % keyCount);
+    }
+
+    // Replaces trigrams with the distinct trigrams of a normalized key, padded as "  key " so
+    // short names and prefixes count
+    void trigramsOf(std::string_view key, std::vector<uint32_t>& trigrams) {
+        trigrams.clear();
+        uint32_t window = (uint32_t(' ') << 8) | ' ';
+        for (char c : key) {
+            window = ((window << 8) | uint8_t(c)) & 0xFFFFFF;
+            trigrams.push_back(window);
+        }
+        trigrams.push_back(((window << 8) | ' ') & 0xFFFFFF);
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    }
+
+    uint32_t checkedSize(std::size_t size, const char* what) {
+        if (size > 0xFFFFFFFF) {
+            throw std::runtime_error(std::string("Name index too large: ") + what);
+        }
+        return static_cast<uint32_t>(size);
+    }
+}
+
+void NameIndex::Builder::add(std::string_view key, uint32_t entry) {
+    keys.emplace_back(normalize(key), entry);
+}
+
+void NameIndex::Builder::addTaal(std::string_view system, std::string_view name,
+                                 const std::vector<std::string>& aliases, uint32_t entry) {
+    std::string prefix = std::string(system) + "/";
+    add(prefix + std::string(name), entry);
+    add(name, entry);
+    for (const auto& alias : aliases) {
+        add(prefix + alias, entry);
+        add(alias, entry);
+    }
+}
+
+std::vector<uint8_t> NameIndex::Builder::build() const {
+    // Group entries by key; an alias equal to the name must not list the entry twice
+    std::vector<std::pair<std::string, uint32_t>> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> groupStart;
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+            names.push_back(sorted[i].first);
+            groupStart.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    groupStart.push_back(static_cast<uint32_t>(sorted.size()));
+
+    uint32_t keyCount = checkedSize(names.size(), "too many names");
+    uint32_t bucketCount = std::max<uint32_t>(1, (keyCount + kKeysPerBucket - 1) / kKeysPerBucket);
+    std::vector<uint64_t> hashes(keyCount);
+    std::vector<std::vector<uint32_t>> buckets(bucketCount);
+    for (uint32_t i = 0; i < keyCount; ++i) {
+        hashes[i] = hashName(names[i]);
+        buckets[bucketOf(hashes[i], bucketCount)].push_back(i);
+    }
+
+    // Hash and displace: place the largest buckets first, searching each for a seed that
+    // sends all of its keys to free slots; single keys then fill the remaining slots directly
+    std::vector<uint32_t> order(bucketCount);
+    for (uint32_t b = 0; b < bucketCount; ++b) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    std::vector<uint32_t> seedOf(bucketCount, 0);
+    std::vector<uint32_t> keyAt(keyCount);
+    std::vector<bool> taken(keyCount, false);
+    std::vector<uint32_t> trial;
+    uint32_t nextFree = 0;
+    for (uint32_t bucket : order) {
+        const std::vector<uint32_t>& members = buckets[bucket];
+        if (members.empty()) {
+            break;
+        }
+        if (members.size() == 1) {
+            while (taken[nextFree]) {
+                ++nextFree;
+            }
+            taken[nextFree] = true;
+            keyAt[nextFree] = members[0];
+            seedOf[bucket] = kDirectSlot | nextFree;
+            continue;
+        }
+
+        uint32_t seed = 0;
+        for (;; ++seed) {
+            if (seed == kMaxSeed) {
+                throw std::runtime_error("Unable to build name index: hash collision on \"" +
+                                         std::string(names[members[0]]) + "\"");
+            }
+            trial.clear();
+            bool placed = true;
+            for (uint32_t key : members) {
+                uint32_t slot = seededSlot(hashes[key], seed, keyCount);
+                if (taken[slot] || std::find(trial.begin(), trial.end(), slot) != trial.end()) {
+                    placed = false;
+                    break;
+                }
+                trial.push_back(slot);
+            }
+            if (placed) {
+                break;
+            }
+        }
+        for (std::size_t i = 0; i < members.size(); ++i) {
+            taken[trial[i]] = true;
+            keyAt[trial[i]] = members[i];
+        }
+        seedOf[bucket] = seed;
+    }
+
+    // Trigram postings: count, then place in slot order, so each list comes out sorted.
+    // Qualified keys are left out; suggest() matches on the part after the system.
+    auto unqualified = [&](uint32_t slot) { return names[keyAt[slot]].find('/') == std::string_view::npos; };
+    std::vector<uint32_t> trigrams;
+    std::unordered_map<uint32_t, uint32_t> postingCursor; // Trigram -> count, then next posting
+    std::size_t postingCount = 0;
+    for (uint32_t slot = 0; slot < keyCount; ++slot) {
+        if (!unqualified(slot)) {
+            continue;
+        }
+        trigramsOf(names[keyAt[slot]], trigrams);
+        for (uint32_t trigram : trigrams) {
+            ++postingCursor[trigram];
+        }
+        postingCount += trigrams.size();
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> trigramTable(postingCursor.begin(), postingCursor.end());
+    std::sort(trigramTable.begin(), trigramTable.end());
+    uint32_t firstPosting = 0;
+    for (auto& [trigram, count] : trigramTable) {
+        postingCursor[trigram] = firstPosting;
+        std::swap(count, firstPosting);
+        firstPosting += count;
+    }
+    std::vector<uint32_t> postingSlots(postingCount);
+    for (uint32_t slot = 0; slot < keyCount; ++slot) {
+        if (!unqualified(slot)) {
+            continue;
+        }
+        trigramsOf(names[keyAt[slot]], trigrams);
+        for (uint32_t trigram : trigrams) {
+            postingSlots[postingCursor[trigram]++] = slot;
+        }
+    }
+
+    std::size_t stringsSize = 0;
+    for (std::string_view name : names) {
+        stringsSize += name.size();
+    }
+    uint32_t trigramCount = static_cast<uint32_t>(trigramTable.size());
+    checkedSize(postingCount, "too many trigrams");
+
+    std::vector<uint8_t> out;
+    out.reserve(kHeaderSize + (bucketCount + sorted.size() + postingCount) * sizeof(uint32_t) +
+                keyCount * kSlotSize + (trigramCount + 1) * kTrigramSize + stringsSize);
+    store32(out, keyCount);
+    store32(out, bucketCount);
+    store32(out, checkedSize(sorted.size(), "too many targets"));
+    store32(out, trigramCount);
+    store32(out, checkedSize(stringsSize, "names too long"));
+    for (uint32_t seed : seedOf) {
+        store32(out, seed);
+    }
+
+    uint32_t nextString = 0;
+    for (uint32_t slot = 0; slot < keyCount; ++slot) {
+        uint32_t key = keyAt[slot];
+        store32(out, nextString);
+        store32(out, static_cast<uint32_t>(names[key].size()));
+        store32(out, groupStart[key]);
+        store32(out, groupStart[key + 1] - groupStart[key]);
+        nextString += static_cast<uint32_t>(names[key].size());
+    }
+    for (const auto& [key, entry] : sorted) {
+        store32(out, entry);
+    }
+
+    for (const auto& [trigram, first] : trigramTable) {
+        store32(out, trigram);
+        store32(out, first);
+    }
+    store32(out, 0);
+    store32(out, static_cast<uint32_t>(postingCount));
+    for (uint32_t slot : postingSlots) {
+        store32(out, slot);
+    }
+
+    for (uint32_t slot = 0; slot < keyCount; ++slot) {
+        std::string_view name = names[keyAt[slot]];
+        out.insert(out.end(), name.begin(), name.end());
+    }
+    return out;
+}
+
+NameIndex::NameIndex(const uint8_t* data, std::size_t size) {
+    if (size < kHeaderSize) {
+        throw std::runtime_error("Corrupt name index: truncated header");
+    }
+    keyCount = load32(data);
+    bucketCount = load32(data + 4);
+    targetCount = load32(data + 8);
+    trigramCount = load32(data + 12);
+    stringsSize = load32(data + 16);
+
+    uint64_t offset = kHeaderSize;
+    seeds = data + offset;
+    offset += uint64_t(bucketCount) * sizeof(uint32_t);
+    slots = data + offset;
+    offset += uint64_t(keyCount) * kSlotSize;
+    targets = data + offset;
+    offset += uint64_t(targetCount) * sizeof(uint32_t);
+    trigrams = data + offset;
+    offset += (uint64_t(trigramCount) + 1) * kTrigramSize;
+    if (bucketCount == 0 || offset > size) {
+        throw std::runtime_error("Corrupt name index: sections out of range");
+    }
+    postings = data + offset;
+    offset += uint64_t(load32(trigrams + uint64_t(trigramCount) * kTrigramSize + 4)) * sizeof(uint32_t);
+    strings = data + offset;
+    if (offset + stringsSize > size) {
+        throw std::runtime_error("Corrupt name index: sections out of range");
+    }
+}
+
+uint32_t NameIndex::slotOf(uint64_t hash) const {
+    uint32_t seed = load32(seeds + bucketOf(hash, bucketCount) * sizeof(uint32_t));
+    return (seed & kDirectSlot) ? (seed & ~kDirectSlot) : seededSlot(hash, seed, keyCount);
+}
+
+std::string_view NameIndex::key(uint32_t slot) const {
+    const uint8_t* record = slots + uint64_t(slot) * kSlotSize;
+    uint32_t offset = load32(record);
+    uint32_t length = load32(record + 4);
+    if (uint64_t(offset) + length > stringsSize) {
+        throw std::runtime_error("Corrupt name index: key out of range");
+    }
+    return std::string_view(reinterpret_cast<const char*>(strings + offset), length);
+}
+
+NameIndex::Match NameIndex::find(std::string_view name) const {
+    if (keyCount == 0) {
+        return {};
+    }
+    uint32_t slot = slotOf(hashName(name));
+    if (slot >= keyCount) {
+        throw std::runtime_error("Corrupt name index: slot out of range");
+    }
+
+    // The perfect hash only places known keys; anything else still needs the comparison
+    std::string_view candidate = key(slot);
+    if (candidate.size() != name.size() ||
+        !std::equal(name.begin(), name.end(), candidate.begin(), [](char a, char b) { return lower(a) == b; })) {
+        return {};
+    }
+
+    const uint8_t* record = slots + uint64_t(slot) * kSlotSize;
+    uint32_t first = load32(record + 8);
+    uint32_t count = load32(record + 12);
+    if (uint64_t(first) + count > targetCount) {
+        throw std::runtime_error("Corrupt name index: targets out of range");
+    }
+    return {targets + uint64_t(first) * sizeof(uint32_t), count};
+}
+
+// Ranks keys by trigram similarity |shared| / |union|, as pg_trgm does. Candidates come from
+// the query's rarest trigrams first, and at most kMaxScannedPostings are read, so a typo costs
+// the same on a catalog of millions as on a small one.
+std::vector<uint32_t> NameIndex::suggest(std::string_view name, std::size_t limit) const {
+    std::vector<uint32_t> query;
+    trigramsOf(normalize(name.substr(name.rfind('/') + 1)), query);
+
+    std::vector<std::pair<uint32_t, uint32_t>> lists; // Postings of each known query trigram
+    for (uint32_t trigram : query) {
+        uint32_t low = 0;
+        uint32_t high = trigramCount;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            if (load32(trigrams + uint64_t(middle) * kTrigramSize) < trigram) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        const uint8_t* record = trigrams + uint64_t(low) * kTrigramSize;
+        if (low < trigramCount && load32(record) == trigram) {
+            lists.emplace_back(load32(record + 4), load32(record + kTrigramSize + 4));
+        }
+    }
+    std::sort(lists.begin(), lists.end(),
+              [](const auto& a, const auto& b) { return a.second - a.first < b.second - b.first; });
+
+    std::vector<uint32_t> candidates;
+    std::size_t budget = kMaxScannedPostings;
+    for (const auto& [first, end] : lists) {
+        for (uint32_t posting = first; posting < end && budget > 0; ++posting, --budget) {
+            candidates.push_back(load32(postings + uint64_t(posting) * sizeof(uint32_t)));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::pair<double, uint32_t>> ranked;
+    std::vector<uint32_t> keyTrigrams;
+    std::vector<uint32_t> common;
+    for (uint32_t slot : candidates) {
+        if (slot >= keyCount) {
+            continue; // Corrupt posting
+        }
+        trigramsOf(key(slot), keyTrigrams);
+        common.clear();
+        std::set_intersection(query.begin(), query.end(), keyTrigrams.begin(), keyTrigrams.end(),
+                              std::back_inserter(common));
+        double similarity = double(common.size()) / double(query.size() + keyTrigrams.size() - common.size());
+        if (similarity >= kMinSimilarity) {
+            ranked.emplace_back(-similarity, slot);
+        }
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<uint32_t> entries;
+    for (const auto& [score, slot] : ranked) {
+        const uint8_t* record = slots + uint64_t(slot) * kSlotSize;
+        uint32_t first = load32(record + 8);
+        uint32_t count = load32(record + 12);
+        for (uint32_t i = 0; i < count && uint64_t(first) + i < targetCount; ++i) {
+            uint32_t entry = load32(targets + (uint64_t(first) + i) * sizeof(uint32_t));
+            if (entries.size() < limit && std::find(entries.begin(), entries.end(), entry) == entries.end()) {
+                entries.push_back(entry);
+            }
+        }
+        if (entries.size() >= limit) {
+            break;
+        }
+    }
+    return entries;
+}
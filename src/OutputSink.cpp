@@ -0,0 +1,282 @@
+#include "OutputSink.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#ifdef TANSEN_WITH_URING
+#include <liburing.h>
+#endif
+
+namespace {
+    std::runtime_error systemError(const std::string& what, const std::string& path, int error = errno) {
+        return std::runtime_error(what + " " + path + ": " + std::strerror(error));
+    }
+
+    int openForWriting(const std::string& path) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw systemError("Failed to open", path);
+        }
+        return fd;
+    }
+
+    // Writes every iovec at offset, resuming after short writes
+    void pwriteAll(int fd, iovec* parts, int count, uint64_t offset, const std::string& path) {
+        while (count > 0) {
+            ssize_t written = ::pwritev(fd, parts, count, static_cast<off_t>(offset));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw systemError("Failed to write", path);
+            }
+            offset += static_cast<uint64_t>(written);
+            std::size_t remaining = static_cast<std::size_t>(written);
+            while (count > 0 && remaining >= parts->iov_len) {
+                remaining -= parts->iov_len;
+                ++parts;
+                --count;
+            }
+            if (count > 0) {
+                parts->iov_base = static_cast<char*>(parts->iov_base) + remaining;
+                parts->iov_len -= remaining;
+            }
+        }
+    }
+
+    void writeOctal(char* field, std::size_t width, uint64_t value) {
+        // width - 1 digits and a terminating NUL, as ustar expects
+        std::snprintf(field, width, "%0*llo", static_cast<int>(width - 1), static_cast<unsigned long long>(value));
+    }
+
+    // Fills a ustar header block for a regular file
+    void tarHeader(char* block, const std::string& path, uint64_t size, std::time_t modified) {
+        std::memset(block, 0, TarSink::kBlockSize);
+
+        std::string name = path.substr(std::min(path.find_first_not_of('/'), path.size()));
+        std::string prefix;
+        if (name.size() > 100) {
+            // Split at a '/' so that the prefix fits 155 bytes and the rest 100
+            std::size_t split = name.rfind('/', 155);
+            if (split == std::string::npos || split == 0 || name.size() - split - 1 > 100) {
+                throw std::runtime_error("Path too long for a tar archive: " + path);
+            }
+            prefix = name.substr(0, split);
+            name = name.substr(split + 1);
+        }
+        if (size > 077777777777ULL) {
+            throw std::runtime_error("File too large for a tar archive: " + path);
+        }
+
+        std::memcpy(block, name.data(), name.size());
+        writeOctal(block + 100, 8, 0644);                           // mode
+        writeOctal(block + 108, 8, 0);                              // uid
+        writeOctal(block + 116, 8, 0);                              // gid
+        writeOctal(block + 124, 12, size);                          // size
+        writeOctal(block + 136, 12, static_cast<uint64_t>(modified)); // mtime
+        block[156] = '0';                                           // Regular file
+        std::memcpy(block + 257, "ustar", 6);                       // magic, NUL-terminated
+        std::memcpy(block + 263, "00", 2);                          // version
+        std::memcpy(block + 345, prefix.data(), prefix.size());
+
+        // The checksum is computed with its own field read as spaces
+        std::memset(block + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (std::size_t i = 0; i < TarSink::kBlockSize; ++i) {
+            checksum += static_cast<unsigned char>(block[i]);
+        }
+        std::snprintf(block + 148, 8, "%06o", checksum);
+        block[155] = ' ';
+    }
+
+    uint64_t paddedSize(uint64_t size) {
+        return (size + TarSink::kBlockSize - 1) / TarSink::kBlockSize * TarSink::kBlockSize;
+    }
+}
+
+void PwriteSink::write(const std::string& path, const uint8_t* data, std::size_t size) {
+    int fd = openForWriting(path);
+    try {
+        iovec part{const_cast<uint8_t*>(data), size};
+        pwriteAll(fd, &part, 1, 0, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    if (::close(fd) != 0) {
+        throw systemError("Failed to close", path);
+    }
+}
+
+TarSink::TarSink(const std::string& archivePath)
+    : archivePath(archivePath), fd(openForWriting(archivePath)), modified(std::time(nullptr)) {}
+
+TarSink::~TarSink() {
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // Destructors must not throw; call finish() explicitly to see the error
+    }
+    ::close(fd);
+}
+
+uint64_t TarSink::append(const std::string& path, const uint8_t* data, std::size_t size) {
+    char header[kBlockSize];
+    tarHeader(header, path, size, modified);
+
+    uint64_t offset;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished) {
+            throw std::runtime_error("Archive already finished: " + archivePath);
+        }
+        offset = end;
+        end += kBlockSize + paddedSize(size);
+        index.push_back({offset + kBlockSize, size, path});
+    }
+
+    // Padding is never written: it is either a hole or overwritten by the next member, and reads as zeros
+    iovec parts[] = {{header, kBlockSize}, {const_cast<uint8_t*>(data), size}};
+    pwriteAll(fd, parts, 2, offset, archivePath);
+    return offset;
+}
+
+void TarSink::write(const std::string& path, const uint8_t* data, std::size_t size) {
+    append(path, data, size);
+}
+
+void TarSink::finish() {
+    std::string listing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished) {
+            return;
+        }
+        for (const IndexEntry& entry : index) {
+            listing += std::to_string(entry.offset) + ' ' + std::to_string(entry.size) + ' ' + entry.path + '\n';
+        }
+    }
+    uint64_t indexOffset = append(kIndexName, reinterpret_cast<const uint8_t*>(listing.data()), listing.size());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    index.pop_back(); // The index does not list itself
+
+    // Two zero blocks end the archive; they also zero the index member's padding
+    uint64_t paddingStart = indexOffset + kBlockSize + listing.size();
+    std::vector<char> trailer(end - paddingStart + 2 * kBlockSize, 0);
+    iovec part{trailer.data(), trailer.size()};
+    pwriteAll(fd, &part, 1, paddingStart, archivePath);
+    end += 2 * kBlockSize;
+}
+
+#ifdef TANSEN_WITH_URING
+UringSink::UringSink(unsigned batchSize) : batchSize(std::max(1u, batchSize)), ring(std::make_unique<io_uring>()) {
+    int result = io_uring_queue_init(2 * this->batchSize, ring.get(), 0); // A write and a close per file
+    if (result < 0) {
+        throw systemError("Failed to set up", "io_uring", -result);
+    }
+    pending.reserve(this->batchSize);
+}
+
+UringSink::~UringSink() {
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // Destructors must not throw; call finish() explicitly to see the error
+    }
+    io_uring_queue_exit(ring.get());
+}
+
+void UringSink::write(const std::string& path, const uint8_t* data, std::size_t size) {
+    int fd = openForWriting(path);
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back({fd, path, std::vector<uint8_t>(data, data + size)});
+    if (pending.size() >= batchSize) {
+        submitLocked();
+    }
+}
+
+void UringSink::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pending.empty()) {
+        submitLocked();
+    }
+}
+
+// One submission for the whole batch: each file's write is linked to its close
+void UringSink::submitLocked() {
+    for (std::size_t i = 0; i < pending.size(); ++i) {
+        Pending& file = pending[i];
+        io_uring_sqe* write = io_uring_get_sqe(ring.get());
+        io_uring_prep_write(write, file.fd, file.data.data(), static_cast<unsigned>(file.data.size()), 0);
+        write->flags |= IOSQE_IO_LINK;
+        io_uring_sqe_set_data64(write, i * 2);
+
+        io_uring_sqe* close = io_uring_get_sqe(ring.get());
+        io_uring_prep_close(close, file.fd);
+        io_uring_sqe_set_data64(close, i * 2 + 1);
+    }
+
+    std::string errors;
+    int submitted = io_uring_submit(ring.get());
+    if (submitted < 0) {
+        for (const Pending& file : pending) {
+            ::close(file.fd);
+        }
+        pending.clear();
+        throw systemError("Failed to submit", "io_uring batch", -submitted);
+    }
+
+    // Drain every completion before reporting, so no descriptor leaks
+    for (std::size_t done = 0; done < pending.size() * 2; ++done) {
+        io_uring_cqe* completion = nullptr;
+        int result = io_uring_wait_cqe(ring.get(), &completion);
+        if (result < 0) {
+            errors += std::string("io_uring wait: ") + std::strerror(-result) + "\n";
+            break;
+        }
+        uint64_t tag = io_uring_cqe_get_data64(completion);
+        int status = completion->res;
+        io_uring_cqe_seen(ring.get(), completion);
+
+        const Pending& file = pending[tag / 2];
+        bool isClose = tag % 2 == 1;
+        if (isClose && status == -ECANCELED) {
+            ::close(file.fd); // The write failed or was short, which breaks the link
+        } else if (!isClose && status != static_cast<int>(file.data.size())) {
+            errors += file.path + ": " + (status < 0 ? std::strerror(-status) : "short write") + "\n";
+        } else if (isClose && status < 0) {
+            errors += file.path + ": close: " + std::strerror(-status) + "\n";
+        }
+    }
+    pending.clear();
+    if (!errors.empty()) {
+        throw std::runtime_error("Failed to write:\n" + errors);
+    }
+}
+#endif
+
+std::unique_ptr<OutputSink> makeOutputSink(const std::string& spec) {
+    std::string kind = spec.substr(0, spec.find(':'));
+    std::string argument = spec.find(':') == std::string::npos ? "" : spec.substr(spec.find(':') + 1);
+
+    if (kind == "pwrite" && argument.empty()) {
+        return std::make_unique<PwriteSink>();
+    }
+    if (kind == "tar" && !argument.empty()) {
+        return std::make_unique<TarSink>(argument);
+    }
+    if (kind == "uring" && argument.empty()) {
+#ifdef TANSEN_WITH_URING
+        return std::make_unique<UringSink>();
+#else
+        throw std::invalid_argument("Built without io_uring; configure with -DTANSEN_WITH_URING=ON");
+#endif
+    }
+    throw std::invalid_argument("Unknown output sink: " + spec);
+}
@@ -0,0 +1,131 @@
+#include "PlaybackScheduler.h"
+#include "BolTable.h"
+#include "Laykari.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+void JitterHistogram::record(std::chrono::nanoseconds lateness) {
+    int64_t nanoseconds = std::max<int64_t>(lateness.count(), 0);
+    std::size_t bucket = std::min<std::size_t>(static_cast<std::size_t>(nanoseconds / 1000), kBuckets);
+    ++buckets[bucket];
+    ++samples;
+    totalNanoseconds += nanoseconds;
+    maxNanoseconds = std::max(maxNanoseconds, nanoseconds);
+}
+
+double JitterHistogram::percentileMicroseconds(double p) const {
+    if (samples == 0) {
+        return 0.0;
+    }
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * samples);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i <= kBuckets; ++i) {
+        seen += buckets[i];
+        if (seen > target || seen == samples) {
+            return i < kBuckets ? double(i + 1) : maxMicroseconds();
+        }
+    }
+    return maxMicroseconds();
+}
+
+void JitterHistogram::print(std::ostream& out) const {
+    out << "Jitter over " << samples << " events: mean " << meanMicroseconds() << " us, p50 < "
+        << percentileMicroseconds(50) << " us, p99 < " << percentileMicroseconds(99) << " us, max "
+        << maxMicroseconds() << " us" << std::endl;
+    for (std::size_t i = 0; i <= kBuckets; ++i) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        if (i < kBuckets) {
+            out << "  [" << i << ", " << i + 1 << ") us: " << buckets[i] << std::endl;
+        } else {
+            out << "  >= " << kBuckets << " us: " << buckets[i] << std::endl;
+        }
+    }
+}
+
+PlaybackScheduler::PlaybackScheduler(MidiSink& sink, const PlaybackOptions& options)
+    : sink(sink), options(options) {}
+
+// Coarse sleep to just before the deadline, then spin on the monotonic clock
+void PlaybackScheduler::waitUntil(MidiSink::Clock::time_point deadline) const {
+    MidiSink::Clock::time_point wake = deadline - options.spinMargin;
+    if (MidiSink::Clock::now() < wake) {
+        std::this_thread::sleep_until(wake);
+    }
+    while (MidiSink::Clock::now() < deadline) {
+    }
+}
+
+void PlaybackScheduler::play(const Taal& taal, const Tempo& tempo) {
+    if (taal.beats <= 0 || taal.bols.empty() || tempo.getBPM() <= 0) {
+        throw std::invalid_argument("Cannot play Taal " + taal.name + " at tempo " + tempo.getName());
+    }
+    stopping.store(false, std::memory_order_relaxed);
+
+    if (options.realtimePriority) {
+        sched_param param{};
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+        pthread_setschedparam(pthread_self(), SCHED_FIFO, &param); // Best effort
+    }
+
+    struct Event {
+        uint64_t tick; // Offset within the laykari sequence
+        uint8_t message[3];
+    };
+
+    // Same grid and voicing as MIDIHandler renders to a file; one pass covers every laykari of the sequence
+    const RenderOptions& voicing = options.voicing;
+    const BolTable& bolTable = BolTable::instance();
+    LaykariPlan plan = planLaykari(taal, voicing.laykari);
+
+    std::vector<Event> pass;
+    for (std::size_t step = 0; step < plan.steps.size(); ++step) {
+        const LaykariStep& laykari = plan.steps[step];
+        uint64_t tick = step * plan.ticksPerCycle;
+        for (uint32_t i = 0; i < laykari.notesPerCycle; ++i, tick += laykari.ticksPerNote) {
+            BolId bol = taal.bols[i % taal.bols.size()];
+            uint8_t note = bolTable.note(bol);
+            uint8_t velocity = bol == bolTable.rest() ? 0 : (i == 0 ? voicing.samVelocity : voicing.velocity);
+            pass.push_back({tick, {static_cast<uint8_t>(0x90 | voicing.channel), note, velocity}});
+            pass.push_back({tick + laykari.ticksPerNote, {static_cast<uint8_t>(0x80 | voicing.channel), note, velocity}});
+        }
+    }
+    const uint64_t passTicks = plan.ticksPerCycle * plan.steps.size();
+
+    // Deadlines from absolute tick counts; a ramp spans the cycles to play, or one pass when unbounded
+    const TempoMap tempoMap = tempo.map(options.cycles != 0 ? options.cycles * plan.ticksPerCycle : passTicks,
+                                        plan.division);
+    auto deadlineOf = [&](MidiSink::Clock::time_point start, uint64_t tick) {
+        return start + std::chrono::nanoseconds(std::llround(tempoMap.secondsAt(tick) * 1e9));
+    };
+
+    MidiSink::Clock::time_point start = MidiSink::Clock::now() + std::chrono::milliseconds(10);
+    const uint8_t programChange[] = {static_cast<uint8_t>(0xC0 | voicing.channel), 0};
+    waitUntil(start);
+    sink.send(programChange, sizeof(programChange), start);
+
+    uint64_t played = 0;
+    for (uint64_t n = 0;; ++n) {
+        for (const Event& event : pass) {
+            if (event.tick % plan.ticksPerCycle == 0 && (event.message[0] & 0xF0) == 0x90) {
+                if (options.cycles != 0 && played == options.cycles) {
+                    return;
+                }
+                ++played; // Sam of the next cycle
+            }
+            if (stopping.load(std::memory_order_relaxed)) {
+                return;
+            }
+            MidiSink::Clock::time_point deadline = deadlineOf(start, n * passTicks + event.tick);
+            waitUntil(deadline);
+            histogram.record(MidiSink::Clock::now() - deadline);
+            sink.send(event.message, sizeof(event.message), deadline);
+        }
+    }
+}
@@ -0,0 +1,177 @@
+#include "Profiler.h"
+
+#ifdef TANSEN_ENABLE_PROFILING
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <map>
+#include <new>
+#include <string>
+#include <unistd.h>
+
+namespace {
+    thread_local uint64_t allocationCount = 0;
+    std::atomic<uint32_t> nextThreadId{1};
+    const Profiler::Clock::time_point processStart = Profiler::Clock::now(); // Trace timestamps start here
+
+    const char* const kCounterNames[] = {"renders", "events", "bytes", "allocations", "lookups"};
+    static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == Profiler::CounterCount,
+                  "Every counter needs a name");
+
+    void writeJsonString(std::ostream& out, const char* text) {
+        out << '"';
+        for (const char* c = text; *c; ++c) {
+            if (*c == '"' || *c == '\\') {
+                out << '\\';
+            }
+            out << *c;
+        }
+        out << '"';
+    }
+
+    void* allocate(std::size_t size) {
+        ++allocationCount;
+        return std::malloc(size == 0 ? 1 : size);
+    }
+}
+
+// Count every allocation made through the global operator new
+void* operator new(std::size_t size) {
+    if (void* pointer = allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+
+Profiler::Profiler() : origin(processStart) {}
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadState& Profiler::threadState() {
+    thread_local ThreadState* state = nullptr;
+    if (state == nullptr) {
+        auto created = std::make_unique<ThreadState>();
+        created->id = nextThreadId++;
+        state = created.get();
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threads.push_back(std::move(created));
+    }
+    return *state;
+}
+
+void Profiler::addSpan(const char* name, Clock::time_point start, Clock::time_point end) {
+    ThreadState& state = threadState();
+    std::lock_guard<std::mutex> lock(state.mutex); // Uncontended except while reporting
+    if (state.spans.size() == kMaxSpansPerThread) {
+        ++state.dropped;
+        return;
+    }
+    state.spans.push_back({name, std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count(),
+                           std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()});
+}
+
+void Profiler::add(Counter counter, uint64_t amount) {
+    threadState().counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::counter(Counter counter) const {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    uint64_t total = 0;
+    for (const auto& state : threads) {
+        total += state->counters[counter].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Profiler::threadAllocations() {
+    return allocationCount;
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(threadsMutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    out << std::fixed << std::setprecision(3);
+    for (const auto& state : threads) {
+        std::lock_guard<std::mutex> stateLock(state->mutex);
+        for (const Span& span : state->spans) {
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            writeJsonString(out, span.name);
+            out << ",\"cat\":\"tansen\",\"ph\":\"X\",\"ts\":" << span.startNanoseconds / 1000.0
+                << ",\"dur\":" << span.durationNanoseconds / 1000.0 << ",\"pid\":" << getpid()
+                << ",\"tid\":" << state->id << '}';
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+}
+
+void Profiler::printStats(std::ostream& out) const {
+    struct Phase {
+        uint64_t count = 0;
+        int64_t totalNanoseconds = 0;
+        int64_t maxNanoseconds = 0;
+    };
+    std::map<std::string, Phase> phases;
+    std::array<uint64_t, CounterCount> counters{};
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        for (const auto& state : threads) {
+            std::lock_guard<std::mutex> stateLock(state->mutex);
+            for (const Span& span : state->spans) {
+                Phase& phase = phases[span.name];
+                ++phase.count;
+                phase.totalNanoseconds += span.durationNanoseconds;
+                phase.maxNanoseconds = std::max(phase.maxNanoseconds, span.durationNanoseconds);
+            }
+            for (std::size_t i = 0; i < CounterCount; ++i) {
+                counters[i] += state->counters[i].load(std::memory_order_relaxed);
+            }
+            dropped += state->dropped;
+        }
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << std::left << std::setw(16) << "phase" << std::right << std::setw(10) << "count" << std::setw(14)
+        << "total ms" << std::setw(14) << "mean us" << std::setw(14) << "max us" << '\n';
+    for (const auto& [name, phase] : phases) {
+        out << std::left << std::setw(16) << name << std::right << std::setw(10) << phase.count << std::setw(14)
+            << phase.totalNanoseconds / 1e6 << std::setw(14) << phase.totalNanoseconds / 1e3 / phase.count
+            << std::setw(14) << phase.maxNanoseconds / 1e3 << '\n';
+    }
+
+    uint64_t renders = counters[Renders];
+    for (std::size_t i = 0; i < CounterCount; ++i) {
+        out << std::left << std::setw(16) << kCounterNames[i] << std::right << std::setw(10) << counters[i];
+        if (i != Renders && renders > 0) {
+            out << std::setw(14) << static_cast<double>(counters[i]) / renders << " per render";
+        }
+        out << '\n';
+    }
+    if (dropped > 0) {
+        out << "(" << dropped << " spans dropped after " << kMaxSpansPerThread << " per thread)\n";
+    }
+}
+
+#endif // TANSEN_ENABLE_PROFILING
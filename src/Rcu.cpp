@@ -0,0 +1,118 @@
+#include "Rcu.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // This thread's reader slot and section depth; the slot is returned when the thread exits
+    struct ThreadReader {
+        void* reader = nullptr;
+        unsigned depth = 0;
+        void (*release)(void*) = nullptr;
+
+        ~ThreadReader() {
+            if (reader) {
+                release(reader);
+            }
+        }
+    };
+
+    thread_local ThreadReader threadReader;
+}
+
+Rcu& Rcu::instance() {
+    static Rcu rcu;
+    return rcu;
+}
+
+Rcu::~Rcu() {
+    // Process exit: no reader can run any more
+    for (Retired& object : retired) {
+        object.deleter();
+    }
+    for (Reader* reader = readers.load(); reader;) {
+        Reader* next = reader->next;
+        delete reader;
+        reader = next;
+    }
+}
+
+Rcu::Reader* Rcu::acquireReader() {
+    for (Reader* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next) {
+        bool free = false;
+        if (!reader->inUse.load(std::memory_order_relaxed) && reader->inUse.compare_exchange_strong(free, true)) {
+            return reader;
+        }
+    }
+
+    Reader* reader = new Reader;
+    reader->inUse.store(true, std::memory_order_relaxed);
+    Reader* head = readers.load(std::memory_order_relaxed);
+    do {
+        reader->next = head;
+    } while (!readers.compare_exchange_weak(head, reader, std::memory_order_release, std::memory_order_relaxed));
+    return reader;
+}
+
+void Rcu::releaseReader(Reader* reader) {
+    reader->epoch.store(0);
+    reader->inUse.store(false, std::memory_order_release);
+}
+
+Rcu::ReadGuard::ReadGuard() {
+    if (threadReader.depth++ > 0) {
+        return;
+    }
+    Rcu& rcu = instance();
+    if (!threadReader.reader) {
+        threadReader.reader = rcu.acquireReader();
+        threadReader.release = [](void* reader) { releaseReader(static_cast<Reader*>(reader)); };
+    }
+    // Sequentially consistent: the announcement is ordered before the reader's pointer load,
+    // so a writer that misses it has already swapped the pointer this reader will see
+    static_cast<Reader*>(threadReader.reader)->epoch.store(rcu.epoch.load());
+}
+
+Rcu::ReadGuard::~ReadGuard() {
+    if (--threadReader.depth == 0) {
+        static_cast<Reader*>(threadReader.reader)->epoch.store(0);
+    }
+}
+
+void Rcu::retire(std::function<void()> deleter) {
+    // Readers announcing the new epoch started after the swap and cannot hold the object
+    uint64_t retiredAt = ++epoch;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.push_back({retiredAt, std::move(deleter)});
+    }
+    reclaim();
+}
+
+uint64_t Rcu::oldestActiveEpoch() const {
+    uint64_t oldest = std::numeric_limits<uint64_t>::max();
+    for (Reader* reader = readers.load(std::memory_order_acquire); reader; reader = reader->next) {
+        uint64_t announced = reader->epoch.load();
+        if (announced != 0) {
+            oldest = std::min(oldest, announced);
+        }
+    }
+    return oldest;
+}
+
+std::size_t Rcu::reclaim() {
+    std::vector<Retired> ready;
+    std::size_t waiting;
+    {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        uint64_t oldest = oldestActiveEpoch();
+        auto split = std::stable_partition(retired.begin(), retired.end(),
+                                           [oldest](const Retired& object) { return object.epoch > oldest; });
+        ready.assign(std::make_move_iterator(split), std::make_move_iterator(retired.end()));
+        retired.erase(split, retired.end());
+        waiting = retired.size();
+    }
+    for (Retired& object : ready) {
+        object.deleter(); // Outside the lock: destructors may be slow or retire more
+    }
+    return waiting;
+}
@@ -0,0 +1,52 @@
+#include "RenderContext.h"
+#include <stdexcept>
+
+void* RenderContext::OverflowResource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    overflowBytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void RenderContext::OverflowResource::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+RenderContext::RenderContext(std::size_t arenaBytes)
+    : capacity(arenaBytes > 0 ? arenaBytes : kDefaultArenaBytes), buffer(new std::byte[capacity]),
+      fileBuffer(new char[kFileBufferBytes]) {
+    arena.emplace(buffer.get(), capacity, &overflow);
+    // Must precede the first open; the stream then never allocates a buffer of its own
+    file.rdbuf()->pubsetbuf(fileBuffer.get(), kFileBufferBytes);
+}
+
+void RenderContext::reset() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+
+    arena.reset();
+    if (overflow.overflowBytes > 0) {
+        // Grow so the job that overflowed would have fit, with room to spare
+        capacity = 2 * (capacity + overflow.overflowBytes);
+        buffer.reset(new std::byte[capacity]);
+        overflow.overflowBytes = 0;
+    }
+    arena.emplace(buffer.get(), capacity, &overflow);
+}
+
+std::ofstream& RenderContext::openFile(const std::string& path) {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open MIDI file for writing: " + path);
+    }
+    return file;
+}
+
+RenderContext& RenderContext::forThisThread() {
+    thread_local RenderContext context;
+    return context;
+}
@@ -0,0 +1,218 @@
+#include "RenderServer.h"
+#include "CommandExecutor.h"
+#include "CommandParser.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+    bool sendAll(int fd, const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            bytes += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    bool sendResponse(int fd, const char* kind, const void* payload, std::size_t size) {
+        std::string header = std::string(kind) + " " + std::to_string(size) + "\n";
+        return sendAll(fd, header.data(), header.size()) && sendAll(fd, payload, size);
+    }
+
+    // Reads newline-terminated requests from a socket
+    class LineReader {
+    public:
+        explicit LineReader(int fd) : fd(fd) {}
+
+        bool next(std::string& line) {
+            for (;;) {
+                std::size_t newline = buffer.find('\n', start);
+                if (newline != std::string::npos) {
+                    line.assign(buffer, start, newline - start);
+                    start = newline + 1;
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    return true;
+                }
+                buffer.erase(0, start);
+                start = 0;
+                if (buffer.size() > kMaxLine) {
+                    return false;
+                }
+
+                char chunk[4096];
+                ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (received <= 0) {
+                    return false;
+                }
+                buffer.append(chunk, static_cast<std::size_t>(received));
+            }
+        }
+
+    private:
+        static constexpr std::size_t kMaxLine = 1 << 20;
+        int fd;
+        std::string buffer;
+        std::size_t start = 0;
+    };
+}
+
+RenderServer::RenderServer(TaalManager& taalManager, const MIDIHandler& midiHandler, const std::string& socketPath)
+    : taalManager(taalManager), midiHandler(midiHandler), socketPath(socketPath) {}
+
+RenderServer::~RenderServer() {
+    stop();
+    std::unique_lock<std::mutex> lock(clientsMutex);
+    clientsDone.wait(lock, [this] { return clients.empty(); });
+}
+
+void RenderServer::run() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long: " + socketPath);
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int listenSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenSocket < 0) {
+        throw std::runtime_error(std::string("Unable to create socket: ") + std::strerror(errno));
+    }
+    ::unlink(socketPath.c_str()); // Stale socket from a previous run
+    if (::bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listenSocket, 64) != 0) {
+        int error = errno;
+        ::close(listenSocket);
+        throw std::runtime_error("Unable to listen on " + socketPath + ": " + std::strerror(error));
+    }
+
+    listener.store(listenSocket);
+
+    while (!stopping.load()) {
+        int client = ::accept4(listenSocket, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break; // Listener shut down by stop()
+        }
+
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        if (stopping.load()) {
+            // stop() already shut the known clients down and would never reach this one
+            ::shutdown(client, SHUT_RDWR);
+            ::close(client);
+            break;
+        }
+        clients.push_back(client);
+        std::thread(&RenderServer::serveClient, this, client).detach();
+    }
+
+    {
+        // Under the lock stop() shuts the listener down with, so it never sees the number once
+        // closed, when the process may already have reused it for another file
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        listener.exchange(-1);
+    }
+    ::close(listenSocket);
+    ::unlink(socketPath.c_str());
+}
+
+void RenderServer::stop() {
+    if (stopping.exchange(true)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    int listenSocket = listener.load();
+    if (listenSocket >= 0) {
+        ::shutdown(listenSocket, SHUT_RDWR);
+    }
+    for (int client : clients) {
+        ::shutdown(client, SHUT_RDWR);
+    }
+}
+
+void RenderServer::serveClient(int client) {
+    using Clock = std::chrono::steady_clock;
+
+    CommandExecutor executor(taalManager, midiHandler, true);
+    LineReader reader(client);
+    std::string line;
+    Command command;      // Reused across requests, so a warm session renders without allocating
+    CommandResult result;
+
+    while (reader.next(line)) {
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        bool sent;
+        if (line == "stats") {
+            std::string report = statsReport();
+            sent = sendResponse(client, "TEXT", report.data(), report.size());
+        } else {
+            try {
+                parseCommand(line, command);
+                executor.execute(command, result);
+                switch (result.kind) {
+                    case CommandResult::Kind::Midi:
+                        sent = sendResponse(client, "MIDI", result.midi.data(), result.midi.size());
+                        break;
+                    case CommandResult::Kind::File:
+                        sent = sendResponse(client, "FILE", result.text.data(), result.text.size());
+                        break;
+                    default:
+                        sent = sendResponse(client, "TEXT", result.text.data(), result.text.size());
+                        break;
+                }
+            } catch (const std::exception& e) {
+                ++errors;
+                std::string message = e.what();
+                sent = sendResponse(client, "ERR", message.data(), message.size());
+            }
+            ++requests;
+            requestLatency.record(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        }
+        if (!sent) {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+    ::close(client);
+    clientsDone.notify_all();
+}
+
+std::string RenderServer::statsReport() const {
+    std::ostringstream report;
+    report << "requests " << requests.load() << "\n"
+           << "errors " << errors.load() << "\n"
+           << "latency_mean_us " << requestLatency.mean() * 1000.0 << "\n"
+           << "latency_p50_us " << requestLatency.percentile(50.0) * 1000.0 << "\n"
+           << "latency_p99_us " << requestLatency.percentile(99.0) * 1000.0 << "\n"
+           << "catalog_reloads " << taalManager.reloadCount() << "\n"
+           << "catalog_reload_failures " << taalManager.reloadFailureCount() << "\n"
+           << "catalog_reload_p50_ms " << taalManager.reloadStats().percentile(50.0) << "\n"
+           << "catalog_reload_max_ms " << taalManager.reloadStats().percentile(100.0) << "\n";
+    return report.str();
+}
@@ -0,0 +1,147 @@
+#include "SmfReader.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    // SMF integers are big-endian
+    uint16_t loadBig16(const uint8_t* p) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    uint32_t loadBig32(const uint8_t* p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    [[noreturn]] void malformed(const char* what, std::size_t offset) {
+        throw std::runtime_error("Malformed MIDI file: " + std::string(what) + " at byte " + std::to_string(offset));
+    }
+
+    // Data bytes per status nibble: program change (Cx) and channel pressure (Dx) take one
+    constexpr uint8_t kDataBytes[16] = {0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 1, 1, 2, 0};
+
+    constexpr std::size_t kChunkHeaderBytes = 8;
+    constexpr uint32_t kMaxVarLenBytes = 4; // The SMF limit, 0x0FFFFFFF
+}
+
+SmfReader::SmfReader(const uint8_t* data, std::size_t size) : data(data) {
+    if (size < kChunkHeaderBytes + 6 || std::memcmp(data, "MThd", 4) != 0) {
+        throw std::runtime_error("Not a Standard MIDI File: missing MThd header");
+    }
+    uint32_t headerLength = loadBig32(data + 4);
+    if (headerLength < 6 || headerLength > size - kChunkHeaderBytes) {
+        malformed("bad MThd length", 4);
+    }
+    fileFormat = loadBig16(data + 8);
+    division = loadBig16(data + 12);
+    if (fileFormat > 2) {
+        malformed("unknown format", 8);
+    }
+    if (division == 0) {
+        malformed("zero division", 12);
+    }
+    tracks.reserve(loadBig16(data + 10));
+
+    std::size_t offset = kChunkHeaderBytes + headerLength;
+    while (offset < size) {
+        if (size - offset < kChunkHeaderBytes) {
+            malformed("truncated chunk header", offset);
+        }
+        uint32_t length = loadBig32(data + offset + 4);
+        if (length > size - offset - kChunkHeaderBytes) {
+            malformed("chunk runs past the end of the file", offset);
+        }
+        const uint8_t* begin = data + offset + kChunkHeaderBytes;
+        if (std::memcmp(data + offset, "MTrk", 4) == 0) {
+            tracks.emplace_back(begin, begin + length);
+        }
+        offset += kChunkHeaderBytes + length;
+    }
+}
+
+SmfReader::TrackReader SmfReader::track(std::size_t index) const {
+    if (index >= tracks.size()) {
+        throw std::out_of_range("MIDI track index out of range: " + std::to_string(index));
+    }
+    return TrackReader(data, tracks[index].first, tracks[index].second);
+}
+
+void SmfReader::TrackReader::fail(const char* what) const {
+    malformed(what, static_cast<std::size_t>(position - file));
+}
+
+uint32_t SmfReader::TrackReader::readVarLen() {
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < kMaxVarLenBytes; ++i) {
+        if (position == end) {
+            fail("truncated variable-length quantity");
+        }
+        uint8_t byte = *position++;
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    fail("variable-length quantity longer than 4 bytes");
+}
+
+bool SmfReader::TrackReader::next(SmfEvent& event) {
+    if (position == end) {
+        return false;
+    }
+    tick += readVarLen();
+    if (position == end) {
+        fail("truncated event");
+    }
+
+    event = SmfEvent();
+    event.tick = tick;
+    uint8_t status = *position;
+    if (status & 0x80) {
+        ++position;
+    } else if (runningStatus != 0) {
+        status = runningStatus; // The byte read is already the first data byte
+    } else {
+        fail("data byte without a running status");
+    }
+    event.status = status;
+
+    if (status < 0xF0) {
+        runningStatus = status;
+        uint8_t dataBytes = kDataBytes[status >> 4];
+        if (end - position < dataBytes) {
+            fail("truncated channel event");
+        }
+        event.data1 = position[0];
+        event.data2 = dataBytes == 2 ? position[1] : 0;
+        if ((event.data1 | event.data2) & 0x80) {
+            fail("status byte inside a channel event");
+        }
+        position += dataBytes;
+        return true;
+    }
+
+    // Meta and sysex events carry a length-prefixed payload and cancel running status
+    runningStatus = 0;
+    if (status == 0xFF) {
+        if (position == end) {
+            fail("truncated meta event");
+        }
+        event.metaType = *position++;
+    } else if (status != 0xF0 && status != 0xF7) {
+        fail("system message in a track");
+    }
+    event.length = readVarLen();
+    if (static_cast<std::size_t>(end - position) < event.length) {
+        fail("event payload runs past the end of the track");
+    }
+    event.payload = position;
+    position += event.length;
+
+    if (event.isMeta(0x2F)) {
+        position = end; // End of Track: anything after it is not part of the track
+        return false;
+    }
+    return true;
+}
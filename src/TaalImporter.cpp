@@ -0,0 +1,233 @@
+#include "TaalImporter.h"
+#include "BolTable.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+    struct Stroke {
+        uint64_t tick;
+        uint8_t note;
+        uint8_t velocity;
+    };
+
+    // A longer period must raise the loudest position's mean velocity by this much to win
+    constexpr double kAccentMargin = 4.0;
+
+    // Shortest p such that the notes repeat every p strokes, up to tolerance; 0 if none does
+    std::size_t shortestPeriod(const std::vector<uint8_t>& notes, std::size_t maxPeriod, double tolerance) {
+        std::size_t n = notes.size();
+        for (std::size_t period = 1; period <= std::min(maxPeriod, n / 2); ++period) {
+            std::size_t budget = static_cast<std::size_t>(tolerance * static_cast<double>(n - period));
+            std::size_t mismatches = 0;
+            std::size_t i = period;
+            for (; i < n; ++i) {
+                if (notes[i] != notes[i - period] && ++mismatches > budget) {
+                    break;
+                }
+            }
+            if (i == n) {
+                return period;
+            }
+        }
+        return 0;
+    }
+
+    // Position of the loudest stroke in a cycle of `period` strokes, and its mean velocity
+    std::pair<std::size_t, double> loudestPosition(const std::vector<Stroke>& strokes, std::size_t period) {
+        std::size_t best = 0;
+        double bestMean = -1.0;
+        for (std::size_t position = 0; position < period; ++position) {
+            uint64_t sum = 0, count = 0;
+            for (std::size_t i = position; i < strokes.size(); i += period) {
+                sum += strokes[i].velocity;
+                ++count;
+            }
+            double mean = static_cast<double>(sum) / static_cast<double>(count);
+            if (mean > bestMean) {
+                best = position;
+                bestMean = mean;
+            }
+        }
+        return {best, bestMean};
+    }
+}
+
+TaalImporter::TaalImporter(const ImportOptions& options) : options(options) {
+    if (options.channel > 15 || options.channel < -1) {
+        throw std::invalid_argument("MIDI channel must be 0-15, or -1 for every channel");
+    }
+    const BolTable& bolTable = BolTable::instance();
+    for (std::size_t note = 0; note < bolNames.size(); ++note) {
+        BolId bol;
+        bolNames[note] = bolTable.bolForNote(static_cast<uint8_t>(note), bol) ? bolTable.name(bol)
+                                                                             : "Note" + std::to_string(note);
+    }
+}
+
+ImportedTaal TaalImporter::importFile(const std::string& path) const {
+    TANSEN_SCOPE("import.file");
+    MappedFile file(path);
+    ImportedTaal taal = import(SmfReader(file.data(), file.size()), std::filesystem::path(path).stem().string());
+    taal.path = path;
+    return taal;
+}
+
+ImportedTaal TaalImporter::import(const SmfReader& smf, const std::string& name) const {
+    if (smf.ticksPerQuarter() == 0) {
+        throw std::runtime_error("SMPTE-timed MIDI files are not supported: " + name);
+    }
+
+    // Strokes of every track in time order; tracks are each sorted, so they are merged in turn
+    std::vector<Stroke> strokes;
+    uint64_t endTick = 0;
+    for (std::size_t track = 0; track < smf.trackCount(); ++track) {
+        std::size_t merged = strokes.size();
+        SmfReader::TrackReader reader = smf.track(track);
+        SmfEvent event;
+        while (reader.next(event)) {
+            endTick = std::max(endTick, event.tick);
+            if (event.isNoteOn() && (options.channel < 0 || event.channel() == options.channel)) {
+                strokes.push_back({event.tick, event.data1, event.data2});
+            }
+        }
+        std::inplace_merge(strokes.begin(), strokes.begin() + merged, strokes.end(),
+                           [](const Stroke& a, const Stroke& b) { return a.tick < b.tick; });
+    }
+    // Notes struck together are one stroke; the merge is stable, so the earliest track's note stays
+    strokes.erase(std::unique(strokes.begin(), strokes.end(),
+                              [](const Stroke& a, const Stroke& b) { return a.tick == b.tick; }),
+                  strokes.end());
+    if (strokes.size() < 2) {
+        throw std::runtime_error("Too few strokes to find a cycle in " + name);
+    }
+
+    std::vector<uint8_t> notes(strokes.size());
+    std::transform(strokes.begin(), strokes.end(), notes.begin(), [](const Stroke& s) { return s.note; });
+    std::size_t n = strokes.size();
+    std::size_t period = shortestPeriod(notes, options.maxBeats, options.tolerance);
+    if (period == 0) {
+        if (n > options.maxBeats) {
+            throw std::runtime_error("No cycle of at most " + std::to_string(options.maxBeats) +
+                                     " strokes repeats in " + name);
+        }
+        period = n; // A single cycle
+    }
+
+    // Prefer a multiple of the period when it puts a clearly stronger accent on one position
+    auto [sam, accent] = loudestPosition(strokes, period);
+    for (std::size_t longer = 2 * period; longer <= options.maxBeats && 2 * longer <= n; longer += period) {
+        auto [position, mean] = loudestPosition(strokes, longer);
+        if (mean > accent + kAccentMargin) {
+            period = longer;
+            sam = position;
+            accent = mean;
+        }
+    }
+
+    ImportedTaal taal;
+    taal.name = name;
+    taal.bols.reserve(period);
+    std::size_t agreeing = 0;
+    for (std::size_t offset = 0; offset < period; ++offset) {
+        std::array<uint32_t, 128> counts{};
+        for (std::size_t i = (sam + offset) % period; i < n; i += period) {
+            ++counts[notes[i]];
+        }
+        std::size_t note = std::max_element(counts.begin(), counts.end()) - counts.begin();
+        agreeing += counts[note];
+        taal.bols.push_back(bolNames[note]);
+    }
+    taal.match = static_cast<double>(agreeing) / static_cast<double>(n);
+
+    // Average the cycle length over every cycle followed by another sam; a lone cycle runs to the end
+    std::size_t repeats = (n - sam - 1) / period;
+    double cycleTicks = repeats > 0
+        ? static_cast<double>(strokes[sam + repeats * period].tick - strokes[sam].tick) / static_cast<double>(repeats)
+        : static_cast<double>(endTick - strokes[sam].tick);
+    taal.cycles = std::max<std::size_t>((n - sam) / period, 1);
+    taal.beats = std::max(1, static_cast<int>(std::lround(cycleTicks / smf.ticksPerQuarter())));
+    return taal;
+}
+
+ImportReport TaalImporter::importFiles(const std::vector<std::string>& paths, unsigned threads) const {
+    using Clock = std::chrono::steady_clock;
+
+    ImportReport report;
+    report.files = paths.size();
+    std::vector<ImportedTaal> results(paths.size());
+    std::vector<char> imported(paths.size(), 0);
+    std::mutex errorMutex;
+    Clock::time_point start = Clock::now();
+
+    auto importOne = [&](std::size_t index) {
+        try {
+            results[index] = importFile(paths[index]);
+            imported[index] = 1;
+        } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            report.errors.push_back(paths[index] + ": " + e.what());
+        }
+    };
+
+    {
+        ThreadPool pool(threads);
+        for (std::size_t index = 0; index < paths.size(); ++index) {
+            pool.submit([importOne = &importOne, index] { (*importOne)(index); });
+        }
+        pool.wait();
+    }
+    report.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (std::size_t index = 0; index < paths.size(); ++index) {
+        if (imported[index]) {
+            report.taals.push_back(std::move(results[index]));
+        }
+    }
+    report.failed = report.errors.size();
+    report.filesPerSecond = report.wallSeconds > 0.0 ? report.files / report.wallSeconds : 0.0;
+    return report;
+}
+
+Json::Value TaalImporter::toCatalog(const std::vector<ImportedTaal>& taals, const std::string& system) {
+    Json::Value entries(Json::objectValue);
+    std::map<std::pair<int, std::vector<std::string>>, std::string> cycles; // Cycle -> entry name
+
+    for (const auto& taal : taals) {
+        auto [existing, fresh] = cycles.try_emplace({taal.beats, taal.bols});
+        if (!fresh) {
+            Json::Value& aliases = entries[existing->second]["aliases"];
+            bool known = taal.name == existing->second;
+            for (const auto& alias : aliases) {
+                known = known || alias.asString() == taal.name;
+            }
+            if (!known) {
+                aliases.append(taal.name);
+            }
+            continue;
+        }
+
+        std::string name = taal.name;
+        for (int suffix = 2; entries.isMember(name); ++suffix) {
+            name = taal.name + "-" + std::to_string(suffix);
+        }
+        existing->second = name;
+        Json::Value& entry = entries[name];
+        entry["beats"] = taal.beats;
+        entry["bols"] = Json::Value(Json::arrayValue);
+        for (const auto& bol : taal.bols) {
+            entry["bols"].append(bol);
+        }
+    }
+
+    Json::Value catalog(Json::objectValue);
+    catalog[system] = entries;
+    return catalog;
+}
@@ -1,13 +1,205 @@
 #include "TaalManager.h"
+#include "BinaryCatalog.h"
+#include "Hash.h"
+#include "Profiler.h"
+#include "Rcu.h"
+#include <array>
+#include <chrono>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
 
+std::vector<std::string> parseAliases(const Json::Value& taalData) {
+    std::vector<std::string> aliases;
+    if (!taalData.isMember("aliases")) {
+        return aliases;
+    }
+    const Json::Value& values = taalData["aliases"];
+    if (!values.isArray()) {
+        throw std::runtime_error("Malformed Taal data: 'aliases' must be an array of names");
+    }
+    for (const auto& alias : values) {
+        if (!alias.isString() || alias.asString().empty()) {
+            throw std::runtime_error("Malformed Taal data: 'aliases' must be an array of names");
+        }
+        aliases.push_back(alias.asString());
+    }
+    return aliases;
+}
+
+// One loaded catalog. Never modified once published, except for the lock-free decode cache.
+struct TaalManager::Source {
+    std::vector<Taal> loaded;       // JSON catalog entries, numbered as in index
+    std::vector<uint8_t> indexData;
+    NameIndex index;
+    std::unique_ptr<BinaryCatalog> catalog;
+    std::unique_ptr<std::atomic<const Taal*>[]> decoded; // Catalog entries decoded so far
+
+    ~Source() {
+        for (std::size_t entry = 0; decoded && entry < catalog->size(); ++entry) {
+            delete decoded[entry].load(std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t size() const { return catalog ? catalog->size() : loaded.size(); }
+
+    const NameIndex& names() const { return catalog ? catalog->names() : index; }
+
+    std::string qualifiedName(uint32_t entry) const {
+        if (catalog) {
+            return std::string(catalog->system(entry)) + "/" + std::string(catalog->name(entry));
+        }
+        return loaded[entry].system + "/" + loaded[entry].name;
+    }
+
+    const Taal& taal(uint32_t entry) const {
+        if (entry >= size()) {
+            throw std::runtime_error("Corrupt catalog: entry out of range");
+        }
+        if (!catalog) {
+            return loaded[entry];
+        }
+        if (const Taal* taal = decoded[entry].load(std::memory_order_acquire)) {
+            return *taal;
+        }
+
+        // First lookup of this entry; if another thread publishes its copy first, use that one
+        auto fresh = std::make_unique<const Taal>(catalog->decode(entry));
+        const Taal* expected = nullptr;
+        if (decoded[entry].compare_exchange_strong(expected, fresh.get(), std::memory_order_acq_rel,
+                                                   std::memory_order_acquire)) {
+            return *fresh.release();
+        }
+        return *expected;
+    }
+};
+
+// Custom Taals, shared by every snapshot until the next load or reload. Writers (holding
+// writerMutex) only append: an entry is written into a chunk that never moves, then counted,
+// then entered into the name index. Readers take no lock: entries below count are immutable,
+// and an index that outgrows its load factor is replaced whole and retired through Rcu.
+struct TaalManager::CustomTaals {
+    static constexpr std::size_t kFirstChunk = 64; // Chunk c holds kFirstChunk << c entries
+    static constexpr std::size_t kChunks = 40;
+
+    // Open addressing with linear probing, at most half full, so every probe ends at a null slot
+    struct Index {
+        std::size_t mask;
+        std::unique_ptr<std::atomic<const Taal*>[]> slots;
+    };
+
+    std::array<std::unique_ptr<std::shared_ptr<const Taal>[]>, kChunks> chunks;
+    std::atomic<std::size_t> count{0};
+    std::atomic<Index*> index{nullptr};
+
+    CustomTaals() = default;
+    CustomTaals(const CustomTaals&) = delete;
+    CustomTaals& operator=(const CustomTaals&) = delete;
+
+    ~CustomTaals() {
+        delete index.load();
+    }
+
+    std::size_t size() const { return count.load(std::memory_order_acquire); }
+
+    // Chunk c starts at entry kFirstChunk * (2^c - 1)
+    static std::size_t chunkOf(std::size_t entry, std::size_t& offset) {
+        std::size_t chunk = 0;
+        while (((entry / kFirstChunk + 1) >> (chunk + 1)) != 0) {
+            ++chunk;
+        }
+        offset = entry - kFirstChunk * ((std::size_t(1) << chunk) - 1);
+        return chunk;
+    }
+
+    const std::shared_ptr<const Taal>& at(std::size_t entry) const {
+        std::size_t offset = 0;
+        std::size_t chunk = chunkOf(entry, offset);
+        return chunks[chunk][offset];
+    }
+
+    const Taal* find(const std::string& name) const {
+        const Index* current = index.load(std::memory_order_acquire);
+        if (current == nullptr) {
+            return nullptr;
+        }
+        for (std::size_t slot = fnv1a64(name) & current->mask;; slot = (slot + 1) & current->mask) {
+            const Taal* taal = current->slots[slot].load(std::memory_order_acquire);
+            if (taal == nullptr || taal->name == name) {
+                return taal;
+            }
+        }
+    }
+
+    // The name must not be in the store yet
+    void add(std::shared_ptr<const Taal> taal) {
+        std::size_t entry = count.load(std::memory_order_relaxed);
+        std::size_t offset = 0;
+        std::size_t chunk = chunkOf(entry, offset);
+        if (chunk >= kChunks) {
+            throw std::runtime_error("Too many custom Taals");
+        }
+        if (offset == 0) {
+            chunks[chunk] = std::make_unique<std::shared_ptr<const Taal>[]>(kFirstChunk << chunk);
+        }
+        chunks[chunk][offset] = std::move(taal);
+        const Taal* added = chunks[chunk][offset].get();
+
+        Index* current = index.load(std::memory_order_relaxed);
+        if (current == nullptr || (entry + 1) * 2 > current->mask + 1) {
+            std::size_t capacity = current == nullptr ? kFirstChunk * 2 : (current->mask + 1) * 2;
+            auto grown = new Index{capacity - 1, std::make_unique<std::atomic<const Taal*>[]>(capacity)};
+            for (std::size_t i = 0; i < entry; ++i) {
+                insert(*grown, at(i).get());
+            }
+            index.store(grown, std::memory_order_release);
+            if (current != nullptr) {
+                Rcu::instance().retire(current);
+            }
+            current = grown;
+        }
+        count.store(entry + 1, std::memory_order_release);
+        insert(*current, added);
+    }
+
+private:
+    static void insert(Index& target, const Taal* taal) {
+        std::size_t slot = fnv1a64(taal->name) & target.mask;
+        while (target.slots[slot].load(std::memory_order_relaxed) != nullptr) {
+            slot = (slot + 1) & target.mask;
+        }
+        target.slots[slot].store(taal, std::memory_order_release);
+    }
+};
+
+struct TaalManager::Snapshot {
+    std::shared_ptr<const Source> source;
+    std::shared_ptr<CustomTaals> custom; // Taals added with addTaal; appended to in place
+};
+
 // Constructor
-TaalManager::TaalManager() {}
+TaalManager::TaalManager() : current(new Snapshot{std::make_shared<Source>(), std::make_shared<CustomTaals>()}) {}
+
+// No reader may still be using the manager, so the snapshot is freed directly
+TaalManager::~TaalManager() {
+    delete current.load();
+}
+
+std::shared_ptr<const TaalManager::Source> TaalManager::catalogSource(const std::string& filePath) {
+    TANSEN_SCOPE("load.catalog");
+    auto source = std::make_shared<Source>();
+    source->catalog = std::make_unique<BinaryCatalog>(filePath);
+    source->decoded.reset(new std::atomic<const Taal*>[source->catalog->size()]());
+    return source;
+}
+
+// Parses a JSON catalog, or maps a compiled one
+std::shared_ptr<const TaalManager::Source> TaalManager::loadSource(const std::string& filePath) {
+    if (BinaryCatalog::isCatalogFile(filePath)) {
+        return catalogSource(filePath);
+    }
 
-// Load Taals from JSON file
-void TaalManager::loadTaals(const std::string& filePath) {
     std::ifstream file(filePath);
     if (!file.is_open()) {
         throw std::runtime_error("Unable to open Taal data file: " + filePath);
@@ -15,11 +207,15 @@ void TaalManager::loadTaals(const std::string& filePath) {
 
     Json::Value root;
     try {
+        TANSEN_SCOPE("load.parse");
         file >> root;
     } catch (const std::exception& e) {
         throw std::runtime_error("Error parsing JSON: " + std::string(e.what()));
     }
 
+    BolTable& bolTable = BolTable::instance();
+    auto source = std::make_shared<Source>();
+    NameIndex::Builder builder;
     for (const auto& system : root.getMemberNames()) {
         const Json::Value& systemData = root[system];
         for (const auto& taalName : systemData.getMemberNames()) {
@@ -32,31 +228,168 @@ void TaalManager::loadTaals(const std::string& filePath) {
 
             Taal taal;
             taal.name = taalName;
+            taal.system = system;
             taal.beats = taalData["beats"].asInt();
+            taal.bols.reserve(taalData["bols"].size());
             for (const auto& bol : taalData["bols"]) {
-                taal.bols.push_back(bol.asString());
+                taal.bols.push_back(bolTable.intern(bol.asString()));
             }
-            taals[taal.name] = taal;
+            builder.addTaal(system, taalName, parseAliases(taalData), static_cast<uint32_t>(source->loaded.size()));
+            source->loaded.push_back(std::move(taal));
         }
     }
+    source->indexData = builder.build();
+    source->index = NameIndex(source->indexData.data(), source->indexData.size());
+    return source;
+}
+
+void TaalManager::publish(std::unique_ptr<const Snapshot> next) {
+    const Snapshot* previous = current.exchange(next.release());
+    Rcu::instance().retire(previous);
+}
+
+// Load Taals from JSON file
+void TaalManager::loadTaals(const std::string& filePath) {
+    TANSEN_SCOPE("load");
+    std::shared_ptr<const Source> source = loadSource(filePath);
+    std::lock_guard<std::mutex> lock(writerMutex);
+    sourcePath = filePath;
+    publish(std::make_unique<const Snapshot>(Snapshot{std::move(source), std::make_shared<CustomTaals>()}));
+}
+
+// Map a compiled binary catalog
+void TaalManager::openCatalog(const std::string& filePath) {
+    std::shared_ptr<const Source> source = catalogSource(filePath);
+    std::lock_guard<std::mutex> lock(writerMutex);
+    sourcePath = filePath;
+    publish(std::make_unique<const Snapshot>(Snapshot{std::move(source), std::make_shared<CustomTaals>()}));
+}
+
+double TaalManager::reload() {
+    TANSEN_SCOPE("reload");
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    // The new catalog is built while readers keep using the old one
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (sourcePath.empty()) {
+        throw std::runtime_error("No catalog to reload");
+    }
+    auto next = std::make_unique<Snapshot>();
+    try {
+        next->source = loadSource(sourcePath);
+    } catch (const std::exception&) {
+        ++reloadFailures;
+        throw;
+    }
+    // The kept Taals are shared, not copied, so references to them survive the reload
+    next->custom = std::make_shared<CustomTaals>();
+    const CustomTaals& custom = *current.load()->custom;
+    for (std::size_t entry = 0, count = custom.size(); entry < count; ++entry) {
+        if (next->source->names().find(custom.at(entry)->name).count == 0) {
+            next->custom->add(custom.at(entry));
+        }
+    }
+    publish(std::move(next));
+
+    double milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    reloadLatency.record(milliseconds);
+    ++reloads;
+    return milliseconds;
+}
+
+// Add a custom Taal
+void TaalManager::addTaal(const std::string& name, int beats, const std::vector<std::string>& bols) {
+    if (beats <= 0 || bols.empty()) {
+        throw std::invalid_argument("Taal needs a positive beat count and at least one bol: " + name);
+    }
+
+    auto taal = std::make_shared<Taal>();
+    taal->name = name;
+    taal->beats = beats;
+    BolTable& bolTable = BolTable::instance();
+    for (const auto& bol : bols) {
+        taal->bols.push_back(bolTable.intern(bol));
+    }
+
+    // Appended to the current snapshot's store; readers see it once it is complete
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const Snapshot& snapshot = *current.load();
+    if (snapshot.source->names().find(name).count != 0 || snapshot.custom->find(name) != nullptr) {
+        throw std::runtime_error("Taal already exists: " + name);
+    }
+    snapshot.custom->add(std::move(taal));
 }
 
 // Get a specific Taal by name
-Taal TaalManager::getTaal(const std::string& name) const {
-    auto it = taals.find(name);
-    if (it == taals.end()) {
-        throw std::invalid_argument("Taal not found: " + name);
+const Taal& TaalManager::getTaal(const std::string& name) const {
+    TANSEN_SCOPE("lookup");
+    TANSEN_COUNT(Lookups, 1);
+    Rcu::ReadGuard guard;
+    const Snapshot& snapshot = *current.load();
+    if (const Taal* custom = snapshot.custom->find(name)) {
+        return *custom;
     }
-    return it->second;
+
+    const Source& source = *snapshot.source;
+    NameIndex::Match match = source.names().find(name);
+    if (match.count == 0) {
+        std::string message = "Taal not found: " + name;
+        std::vector<uint32_t> suggestions = source.names().suggest(name);
+        for (std::size_t i = 0; i < suggestions.size(); ++i) {
+            message += (i == 0 ? " (did you mean " : ", ") + source.qualifiedName(suggestions[i]);
+        }
+        throw std::invalid_argument(suggestions.empty() ? message : message + "?)");
+    }
+    if (match.count > 1) {
+        std::string message = "Ambiguous Taal name: " + name + " (one of ";
+        for (uint32_t i = 0; i < match.count; ++i) {
+            message += (i == 0 ? "" : ", ") + source.qualifiedName(match.entry(i));
+        }
+        throw std::invalid_argument(message + ")");
+    }
+    return source.taal(match.entry(0));
 }
 
 // List all Taals
-void TaalManager::listAllTaals() const {
-    for (const auto& [name, taal] : taals) {
-        std::cout << name << " (" << taal.beats << " beats): ";
-        for (const auto& bol : taal.bols) {
-            std::cout << bol << " ";
+void TaalManager::listAllTaals(std::ostream& out) const {
+    const BolTable& bolTable = BolTable::instance();
+    auto print = [&](const std::string& name, const Taal& taal) {
+        out << name << " (" << taal.beats << " beats): ";
+        for (BolId bol : taal.bols) {
+            out << bolTable.name(bol) << " ";
+        }
+        out << '\n';
+    };
+
+    Rcu::ReadGuard guard;
+    const Snapshot& snapshot = *current.load();
+    const Source& source = *snapshot.source;
+    for (std::size_t entry = 0; entry < source.size(); ++entry) {
+        uint32_t index = static_cast<uint32_t>(entry);
+        if (source.catalog) {
+            print(source.qualifiedName(index), source.catalog->decode(entry)); // Listing does not fill the cache
+        } else {
+            print(source.qualifiedName(index), source.loaded[entry]);
         }
-        std::cout << std::endl;
     }
+    for (std::size_t entry = 0, count = snapshot.custom->size(); entry < count; ++entry) {
+        const Taal& taal = *snapshot.custom->at(entry);
+        print(taal.name, taal);
+    }
+}
+
+std::vector<std::string> TaalManager::listTaalNames() const {
+    Rcu::ReadGuard guard;
+    const Snapshot& snapshot = *current.load();
+    std::vector<std::string> result;
+    std::size_t customCount = snapshot.custom->size();
+    result.reserve(snapshot.source->size() + customCount);
+    for (std::size_t entry = 0; entry < snapshot.source->size(); ++entry) {
+        result.push_back(snapshot.source->qualifiedName(static_cast<uint32_t>(entry)));
+    }
+    for (std::size_t entry = 0; entry < customCount; ++entry) {
+        result.push_back(snapshot.custom->at(entry)->name);
+    }
+    return result;
 }
@@ -0,0 +1,161 @@
+#include "tansen.h"
+#include "Laykari.h"
+#include "MIDIHandler.h"
+#include "RenderContext.h"
+#include "TaalManager.h"
+#include "Tempo.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct tansen_catalog {
+    TaalManager manager;
+};
+
+namespace {
+    thread_local std::string lastError;
+
+    // The opaque handle is the Taal itself; it lives in the catalog's snapshot, which is never reloaded
+    const Taal& unwrap(const tansen_taal* taal) {
+        return *reinterpret_cast<const Taal*>(taal);
+    }
+
+    tansen_status fail(tansen_status status, const char* message) {
+        lastError = message;
+        return status;
+    }
+
+    // Runs body, turning exceptions into status codes so none unwinds into C
+    template <typename Body>
+    tansen_status guarded(tansen_status thrownStatus, Body body) {
+        lastError.clear();
+        try {
+            return body();
+        } catch (const std::invalid_argument& e) {
+            return fail(TANSEN_ERROR_INVALID_ARGUMENT, e.what());
+        } catch (const std::bad_alloc&) {
+            return fail(TANSEN_ERROR_INTERNAL, "Out of memory");
+        } catch (const std::exception& e) {
+            return fail(thrownStatus, e.what());
+        } catch (...) {
+            return fail(TANSEN_ERROR_INTERNAL, "Unknown error");
+        }
+    }
+
+    RenderOptions toRenderOptions(const tansen_render_options& options, std::string& raag) {
+        // Fields past the caller's struct_size are from a newer header: keep their defaults
+        tansen_render_options known;
+        tansen_render_options_init(&known);
+        std::memcpy(&known, &options, std::min<std::size_t>(options.struct_size, sizeof(known)));
+
+        RenderOptions render;
+        render.cycles = known.cycles;
+        render.durationSeconds = known.duration_seconds;
+        render.channel = known.channel;
+        render.velocity = known.velocity;
+        render.samVelocity = known.sam_velocity;
+        render.tonic = known.tonic;
+        render.format = known.format;
+        render.tanpura = known.tanpura != 0;
+        render.lehra = known.lehra != 0;
+        if (known.laykari != nullptr) {
+            render.laykari = parseLaykariSequence(known.laykari);
+        }
+        raag = known.raag != nullptr ? known.raag : "";
+        return render;
+    }
+}
+
+extern "C" {
+
+void tansen_render_options_init(tansen_render_options* options) {
+    if (options == nullptr) {
+        return;
+    }
+    RenderOptions defaults;
+    *options = {};
+    options->struct_size = sizeof(tansen_render_options);
+    options->cycles = defaults.cycles;
+    options->duration_seconds = defaults.durationSeconds;
+    options->channel = defaults.channel;
+    options->velocity = defaults.velocity;
+    options->sam_velocity = defaults.samVelocity;
+    options->tonic = defaults.tonic;
+    options->format = defaults.format;
+}
+
+const char* tansen_last_error(void) {
+    return lastError.c_str();
+}
+
+tansen_status tansen_catalog_open(const char* path, tansen_catalog** catalog) {
+    if (path == nullptr || catalog == nullptr) {
+        return fail(TANSEN_ERROR_INVALID_ARGUMENT, "Catalog path and handle must not be null");
+    }
+    *catalog = nullptr;
+    return guarded(TANSEN_ERROR_IO, [&] {
+        auto opened = std::make_unique<tansen_catalog>();
+        opened->manager.loadTaals(path);
+        *catalog = opened.release();
+        return TANSEN_OK;
+    });
+}
+
+void tansen_catalog_close(tansen_catalog* catalog) {
+    delete catalog;
+}
+
+tansen_status tansen_catalog_find_taal(const tansen_catalog* catalog, const char* name, const tansen_taal** taal) {
+    if (catalog == nullptr || name == nullptr || taal == nullptr) {
+        return fail(TANSEN_ERROR_INVALID_ARGUMENT, "Catalog, name and handle must not be null");
+    }
+    *taal = nullptr;
+    return guarded(TANSEN_ERROR_INTERNAL, [&] {
+        try {
+            *taal = reinterpret_cast<const tansen_taal*>(&catalog->manager.getTaal(name));
+        } catch (const std::invalid_argument& e) { // Unknown or ambiguous, with suggestions
+            return fail(TANSEN_ERROR_NOT_FOUND, e.what());
+        }
+        return TANSEN_OK;
+    });
+}
+
+const char* tansen_taal_name(const tansen_taal* taal) {
+    return taal == nullptr ? "" : unwrap(taal).name.c_str();
+}
+
+int tansen_taal_beats(const tansen_taal* taal) {
+    return taal == nullptr ? 0 : unwrap(taal).beats;
+}
+
+tansen_status tansen_render_midi(const tansen_taal* taal, const char* tempo, const tansen_render_options* options,
+                                 uint8_t* buffer, size_t capacity, size_t* size) {
+    if (taal == nullptr || tempo == nullptr || size == nullptr) {
+        return fail(TANSEN_ERROR_INVALID_ARGUMENT, "Taal, tempo and size must not be null");
+    }
+    *size = 0;
+    return guarded(TANSEN_ERROR_INTERNAL, [&] {
+        tansen_render_options defaults;
+        tansen_render_options_init(&defaults);
+        std::string raag;
+        RenderOptions renderOptions = toRenderOptions(options != nullptr ? *options : defaults, raag);
+
+        // Render into the thread's reusable buffer, then hand over the bytes
+        RenderContext& context = RenderContext::forThisThread();
+        std::vector<uint8_t>& midiData = context.output();
+        MIDIHandler().renderTaalMIDI(unwrap(taal), Tempo::fromName(tempo), raag, renderOptions, context, midiData);
+        *size = midiData.size();
+        if (buffer == nullptr || capacity < midiData.size()) {
+            return fail(TANSEN_ERROR_BUFFER_TOO_SMALL, "Buffer too small for the rendered file");
+        }
+        std::memcpy(buffer, midiData.data(), midiData.size());
+        return TANSEN_OK;
+    });
+}
+
+}
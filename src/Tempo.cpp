@@ -1,8 +1,86 @@
 #include "Tempo.h"
+#include <stdexcept>
 
 // Constructor: Initializes the Tempo object with a name and BPM value
 Tempo::Tempo(const std::string& name, int bpm) : name(name), bpm(bpm) {}
 
+// A ramp: bpm is the first stop, and a single stop is a constant tempo
+Tempo::Tempo(const std::string& name, const std::vector<int>& stops, TempoRamp ramp)
+    : name(name), bpm(stops.empty() ? 0 : stops.front()), ramp(ramp) {
+    for (int stop : stops) {
+        if (stop <= 0) {
+            throw std::invalid_argument("Tempo must be positive: " + name);
+        }
+    }
+    if (stops.empty()) {
+        throw std::invalid_argument("Tempo ramp has no stops: " + name);
+    }
+    if (stops.size() > 1) {
+        this->stops = stops;
+    }
+}
+
+// Resolve a laya name (or a numeric BPM) to a Tempo
+Tempo Tempo::fromName(const std::string& name) {
+    if (name == "Bilambit") return Tempo(name, 60);
+    if (name == "Madhya") return Tempo(name, 90);
+    if (name == "Drut") return Tempo(name, 120);
+
+    if (name.find('>') != std::string::npos) {
+        // "<stop>><stop>...[:linear|:exp]"
+        std::string spec = name;
+        TempoRamp ramp = TempoRamp::Linear;
+        std::size_t colon = spec.rfind(':');
+        if (colon != std::string::npos) {
+            std::string kind = spec.substr(colon + 1);
+            if (kind == "exp") {
+                ramp = TempoRamp::Exponential;
+            } else if (kind != "linear") {
+                throw std::invalid_argument("Unknown tempo ramp: " + kind);
+            }
+            spec.resize(colon);
+        }
+        std::vector<int> stops;
+        std::size_t begin = 0;
+        while (true) {
+            std::size_t end = spec.find('>', begin);
+            std::string stop = spec.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+            if (stop.empty() || stop.find('>') != std::string::npos || stop.find(':') != std::string::npos) {
+                throw std::invalid_argument("Unknown tempo: " + name);
+            }
+            stops.push_back(fromName(stop).getBPM());
+            if (end == std::string::npos) {
+                break;
+            }
+            begin = end + 1;
+        }
+        return Tempo(name, stops, ramp);
+    }
+
+    std::size_t consumed = 0;
+    int bpm = 0;
+    try {
+        bpm = std::stoi(name, &consumed);
+    } catch (const std::exception&) {
+        consumed = 0;
+    }
+    if (consumed != name.size() || bpm <= 0) {
+        throw std::invalid_argument("Unknown tempo: " + name);
+    }
+    return Tempo(name, bpm);
+}
+
+TempoMap Tempo::map(uint64_t spanTicks, uint16_t division) const {
+    if (stops.empty() || spanTicks < stops.size() - 1) {
+        return TempoMap(bpm, division);
+    }
+    std::vector<TempoPoint> points;
+    for (std::size_t i = 0; i < stops.size(); ++i) {
+        points.push_back({spanTicks * i / (stops.size() - 1), static_cast<double>(stops[i])});
+    }
+    return TempoMap(points, ramp, division);
+}
+
 // Get the name of the tempo
 std::string Tempo::getName() const {
     return name;
@@ -0,0 +1,184 @@
+#include "TempoMap.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+    constexpr double kMaxMicrosecondsPerQuarter = 0xFFFFFF; // Set Tempo holds 24 bits
+}
+
+TempoMap::TempoMap(double bpm, uint16_t division) : TempoMap({{0, bpm}}, TempoRamp::Linear, division) {}
+
+TempoMap::TempoMap(const std::vector<TempoPoint>& points, TempoRamp ramp, uint16_t division)
+    : ramp(ramp), ticksPerQuarter(division) {
+    if (points.empty() || points.front().tick != 0) {
+        throw std::invalid_argument("A tempo map must start at tick 0");
+    }
+    if (division == 0) {
+        throw std::invalid_argument("Tempo map division must be positive");
+    }
+    double seconds = 0.0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (!(points[i].bpm > 0.0)) {
+            throw std::invalid_argument("Tempo must be positive");
+        }
+        if (i > 0 && points[i].tick <= points[i - 1].tick) {
+            throw std::invalid_argument("Tempo map points must be in increasing tick order");
+        }
+        if (!segments.empty()) {
+            seconds = segments.back().startSeconds + secondsInto(segments.back(), segments.back().quarters);
+        }
+        bool last = i + 1 == points.size();
+        double quarters = last ? 0.0 : static_cast<double>(points[i + 1].tick - points[i].tick) / division;
+        segments.push_back({points[i].tick, seconds, points[i].bpm, last ? points[i].bpm : points[i + 1].bpm, quarters});
+        starts.push_back(points[i].tick);
+    }
+}
+
+double TempoMap::secondsInto(const Segment& segment, double quarters) const {
+    double b0 = segment.startBPM, b1 = segment.endBPM;
+    if (b0 == b1) {
+        return 60.0 * quarters / b0;
+    }
+    if (ramp == TempoRamp::Linear) {
+        double slope = (b1 - b0) / segment.quarters; // BPM per quarter note
+        return 60.0 / slope * std::log1p(slope * quarters / b0);
+    }
+    double growth = std::log(b1 / b0);
+    return -60.0 * segment.quarters / (b0 * growth) * std::expm1(-growth * quarters / segment.quarters);
+}
+
+double TempoMap::quartersInto(const Segment& segment, double seconds) const {
+    double b0 = segment.startBPM, b1 = segment.endBPM;
+    if (b0 == b1) {
+        return seconds * b0 / 60.0;
+    }
+    if (ramp == TempoRamp::Linear) {
+        double slope = (b1 - b0) / segment.quarters;
+        return b0 * std::expm1(seconds * slope / 60.0) / slope;
+    }
+    double growth = std::log(b1 / b0);
+    return -segment.quarters / growth * std::log1p(-seconds * b0 * growth / (60.0 * segment.quarters));
+}
+
+double TempoMap::bpmInto(const Segment& segment, double quarters) const {
+    double b0 = segment.startBPM, b1 = segment.endBPM;
+    if (b0 == b1) {
+        return b0;
+    }
+    if (ramp == TempoRamp::Linear) {
+        return b0 + (b1 - b0) * quarters / segment.quarters;
+    }
+    return b0 * std::exp(std::log(b1 / b0) * quarters / segment.quarters);
+}
+
+// Where a ramping segment passes through bpm (which must lie between its ends)
+double TempoMap::quartersAtBPM(const Segment& segment, double bpm) const {
+    double b0 = segment.startBPM, b1 = segment.endBPM;
+    if (ramp == TempoRamp::Linear) {
+        return (bpm - b0) * segment.quarters / (b1 - b0);
+    }
+    return segment.quarters * std::log(bpm / b0) / std::log(b1 / b0);
+}
+
+std::size_t TempoMap::segmentAt(uint64_t tick) const {
+    return static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), tick) - starts.begin()) - 1;
+}
+
+double TempoMap::secondsAt(uint64_t tick) const {
+    const Segment& segment = segments[segmentAt(tick)];
+    return segment.startSeconds + secondsInto(segment, static_cast<double>(tick - segment.startTick) / ticksPerQuarter);
+}
+
+uint64_t TempoMap::tickAt(double seconds) const {
+    if (seconds <= 0.0) {
+        return 0;
+    }
+    auto after = std::upper_bound(segments.begin(), segments.end(), seconds,
+                                  [](double value, const Segment& segment) { return value < segment.startSeconds; });
+    const Segment& segment = *(after - 1);
+    double quarters = quartersInto(segment, seconds - segment.startSeconds);
+    uint64_t tick = segment.startTick + static_cast<uint64_t>(std::ceil(quarters * ticksPerQuarter));
+    // The closed forms are inexact; step back if the previous tick already reaches the time
+    return tick > 0 && secondsAt(tick - 1) >= seconds ? tick - 1 : tick;
+}
+
+double TempoMap::bpmAt(uint64_t tick) const {
+    const Segment& segment = segments[segmentAt(tick)];
+    return bpmInto(segment, static_cast<double>(tick - segment.startTick) / ticksPerQuarter);
+}
+
+std::vector<TempoChange> TempoMap::tempoChanges(uint64_t endTick, double maxErrorSeconds) const {
+    if (!(maxErrorSeconds > 0.0)) {
+        throw std::invalid_argument("Tempo error bound must be positive");
+    }
+    std::vector<TempoChange> changes;
+    uint64_t tick = 0;
+    double emitted = 0.0; // Time of `tick` as the events written so far play it
+
+    // Tempo of one event from `from` to `to` that lands exactly (to the microsecond) on the map at `to`
+    auto stepTempo = [&](uint64_t from, uint64_t to) {
+        double quarters = static_cast<double>(to - from) / ticksPerQuarter;
+        double micros = std::round((secondsAt(to) - emitted) * 1e6 / quarters);
+        return std::clamp(micros, 1.0, kMaxMicrosecondsPerQuarter);
+    };
+
+    // Largest timing error of one event held over [from, to] within segment
+    auto stepError = [&](const Segment& segment, uint64_t from, uint64_t to, double micros) {
+        double secondsPerQuarter = micros * 1e-6;
+        auto playedAt = [&](double quarters) { // Quarters from the segment start
+            return emitted + secondsPerQuarter * (quarters - static_cast<double>(from - segment.startTick) / ticksPerQuarter);
+        };
+        auto mapAt = [&](double quarters) { return segment.startSeconds + secondsInto(segment, quarters); };
+        double a = static_cast<double>(from - segment.startTick) / ticksPerQuarter;
+        double b = static_cast<double>(to - segment.startTick) / ticksPerQuarter;
+        double error = std::max(std::abs(playedAt(a) - mapAt(a)), std::abs(playedAt(b) - mapAt(b)));
+
+        // Between the ends the gap peaks where the map's tempo equals the event's
+        double bpm = 60.0 / secondsPerQuarter;
+        double lo = std::min(bpmInto(segment, a), bpmInto(segment, b));
+        double hi = std::max(bpmInto(segment, a), bpmInto(segment, b));
+        if (segment.startBPM != segment.endBPM && bpm > lo && bpm < hi) {
+            double peak = quartersAtBPM(segment, bpm);
+            error = std::max(error, std::abs(playedAt(peak) - mapAt(peak)));
+        }
+        return error;
+    };
+
+    for (std::size_t index = 0; index < segments.size() && (tick < endTick || changes.empty()); ++index) {
+        const Segment& segment = segments[index];
+        uint64_t limit = index + 1 < segments.size() ? std::min(starts[index + 1], endTick) : endTick;
+        while (tick < limit || changes.empty()) {
+            if (limit <= tick) { // Nothing to render: one event for the starting tempo
+                changes.push_back({0, static_cast<uint32_t>(std::round(60e6 / segment.startBPM))});
+                break;
+            }
+            auto fits = [&](uint64_t to) { return stepError(segment, tick, to, stepTempo(tick, to)) <= maxErrorSeconds; };
+
+            // Gallop, then bisect, to the furthest tick one event can reach
+            uint64_t reach = 1;
+            while (tick + 2 * reach <= limit && fits(tick + 2 * reach)) {
+                reach *= 2;
+            }
+            uint64_t to = tick + reach;
+            if (fits(limit)) {
+                to = limit;
+            } else if (tick + 2 * reach <= limit) {
+                uint64_t good = tick + reach, bad = tick + 2 * reach;
+                while (bad - good > 1) {
+                    uint64_t middle = good + (bad - good) / 2;
+                    (fits(middle) ? good : bad) = middle;
+                }
+                to = good;
+            }
+
+            double micros = stepTempo(tick, to);
+            if (changes.empty() || changes.back().microsecondsPerQuarter != static_cast<uint32_t>(micros)) {
+                changes.push_back({tick, static_cast<uint32_t>(micros)});
+            }
+            emitted += micros * 1e-6 * static_cast<double>(to - tick) / ticksPerQuarter;
+            tick = to;
+        }
+    }
+    return changes;
+}
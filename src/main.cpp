@@ -1,41 +1,900 @@
 #include "TaalManager.h"
+#include "AudioRenderer.h"
 #include "MIDIHandler.h"
+#include "OutputSink.h"
 #include "Tempo.h"
+#include "BatchRenderer.h"
+#include "BinaryCatalog.h"
+#include "CatalogExporter.h"
+#include "CatalogWatcher.h"
+#include "CommandExecutor.h"
+#include "CommandParser.h"
+#include "CompositionGenerator.h"
+#include "MappedFile.h"
+#include "PlaybackScheduler.h"
+#include "Profiler.h"
+#include "RenderServer.h"
+#include "TaalImporter.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <pthread.h>
 
-int main() {
-    TaalManager taalManager;
-    MIDIHandler midiHandler;
+namespace {
+    PlaybackScheduler* activePlayback = nullptr;
 
-    try {
-        taalManager.loadTaals("data/taals.json");
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
-        return 1;
+    void stopPlayback(int) {
+        if (activePlayback != nullptr) {
+            activePlayback->stop();
+        }
+    }
+
+    // Shared flags of every rendering subcommand, for their usage lines
+    constexpr const char* kRenderOptionsUsage =
+        "[--cycles N | --duration SECONDS] [--velocity V] [--sam-velocity V] [--laykari SEQ] [--format 0|1]"
+        " [--tanpura] [--lehra] [--tonic NOTE] [--tempo-error MS] [--no-running-status]";
+
+    // Upper bound of every --threads flag; 0 threads, the default, uses every hardware thread
+    constexpr int kMaxThreads = 1024;
+
+    // A whole number from min to max; anything else is rejected, never narrowed
+    int parseIntOption(const std::string& flag, const std::string& text, int min, int max) {
+        std::size_t end = 0;
+        long value = 0;
+        try {
+            value = std::stol(text, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size() || value < min || value > max) {
+            throw std::invalid_argument(flag + " must be a whole number from " + std::to_string(min) + " to " +
+                                        std::to_string(max) + ": " + text);
+        }
+        return static_cast<int>(value);
+    }
+
+    // A finite number above 0 and at most max
+    double parsePositiveOption(const std::string& flag, const std::string& text, double max) {
+        std::size_t end = 0;
+        double value = 0.0;
+        try {
+            value = std::stod(text, &end);
+        } catch (const std::exception&) {
+            end = 0;
+        }
+        if (end == 0 || end != text.size() || !(value > 0.0 && value <= max)) {
+            std::ostringstream message;
+            message << flag << " must be a number above 0 and at most " << max << ": " << text;
+            throw std::invalid_argument(message.str());
+        }
+        return value;
+    }
+
+    // Parses the render flag at argv[i] into options, moving i past its value; false if argv[i] is not one
+    bool parseRenderOption(int argc, char* argv[], int& i, RenderOptions& options) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--cycles" && hasValue) {
+            options.cycles = static_cast<uint64_t>(parseIntOption(arg, argv[++i], 1, static_cast<int>(RenderOptions::kMaxCycles)));
+        } else if (arg == "--duration" && hasValue) {
+            options.durationSeconds = parsePositiveOption(arg, argv[++i], RenderOptions::kMaxDurationSeconds);
+        } else if (arg == "--velocity" && hasValue) {
+            options.velocity = static_cast<uint8_t>(parseIntOption(arg, argv[++i], 0, 127));
+        } else if (arg == "--sam-velocity" && hasValue) {
+            options.samVelocity = static_cast<uint8_t>(parseIntOption(arg, argv[++i], 0, 127));
+        } else if (arg == "--laykari" && hasValue) {
+            options.laykari = parseLaykariSequence(argv[++i]);
+        } else if (arg == "--format" && hasValue) {
+            options.format = static_cast<uint16_t>(parseIntOption(arg, argv[++i], 0, 1));
+        } else if (arg == "--tanpura") {
+            options.tanpura = true;
+        } else if (arg == "--lehra") {
+            options.lehra = true;
+        } else if (arg == "--tonic" && hasValue) {
+            options.tonic = static_cast<uint8_t>(parseIntOption(arg, argv[++i], 0, 127));
+        } else if (arg == "--tempo-error" && hasValue) {
+            options.tempoErrorMs = parsePositiveOption(arg, argv[++i], RenderOptions::kMaxTempoErrorMs);
+        } else if (arg == "--no-running-status") {
+            options.runningStatus = false;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Tansen batch <manifest|-> [--threads N] [--catalog path] [--cycles N | --duration SECONDS]
+    //              [--velocity V] [--sam-velocity V] [--laykari SEQ]
+    //              [--format 0|1] [--tanpura] [--lehra] [--tonic NOTE] [--tempo-error MS]
+    //              [--no-running-status]
+    int runBatch(int argc, char* argv[]) {
+        std::string manifestPath;
+        std::string catalogPath = "data/taals.json";
+        std::string outputSpec;
+        unsigned threads = 0;
+        RenderOptions options;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = static_cast<unsigned>(parseIntOption(arg, argv[++i], 1, kMaxThreads));
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputSpec = argv[++i];
+            } else if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (parseRenderOption(argc, argv, i, options)) {
+                continue;
+            } else if (manifestPath.empty()) {
+                manifestPath = arg;
+            } else {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return 1;
+            }
+        }
+        if (manifestPath.empty()) {
+            std::cerr << "Usage: Tansen batch <manifest|-> [--threads N] [--catalog path] " << kRenderOptionsUsage
+                      << " [--output pwrite|tar:ARCHIVE|uring]" << std::endl;
+            return 1;
+        }
+
+        TaalManager taalManager;
+        MIDIHandler midiHandler;
+        std::vector<BatchJob> jobs;
+        std::unique_ptr<OutputSink> sink;
+        try {
+            if (!outputSpec.empty()) {
+                sink = makeOutputSink(outputSpec);
+            }
+            taalManager.loadTaals(catalogPath);
+            if (manifestPath == "-") {
+                jobs = BatchRenderer::parseManifest(std::cin);
+            } else {
+                std::ifstream manifest(manifestPath);
+                if (!manifest.is_open()) {
+                    throw std::runtime_error("Unable to open manifest: " + manifestPath);
+                }
+                jobs = BatchRenderer::parseManifest(manifest);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        BatchRenderer renderer(taalManager, midiHandler, threads, options, sink.get());
+        BatchReport report = renderer.run(jobs);
+
+        for (const auto& error : report.errors) {
+            std::cerr << error << std::endl;
+        }
+        std::cout << "Rendered " << (report.jobs - report.failed) << "/" << report.jobs << " jobs in "
+                  << report.wallSeconds << " s (" << report.jobsPerSecond << " jobs/sec, p50 "
+                  << report.p50Milliseconds << " ms, p99 " << report.p99Milliseconds << " ms)" << std::endl;
+        return report.failed == 0 ? 0 : 1;
+    }
+
+    // Tansen export <dir> [--catalog path] [--tempos T1,T2...] [--raag NAME] [--threads N] [--verify]
+    //               [--cycles N | --duration SECONDS] [--velocity V] [--sam-velocity V] [--laykari SEQ]
+    //               [--format 0|1] [--tanpura] [--lehra] [--tonic NOTE] [--tempo-error MS] [--no-running-status]
+    int runExport(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::string outputDir;
+        RenderOptions options;
+        ExportOptions exportOptions;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (arg == "--tempos" && i + 1 < argc) {
+                exportOptions.tempos.clear();
+                std::istringstream list(argv[++i]);
+                for (std::string tempo; std::getline(list, tempo, ',');) {
+                    exportOptions.tempos.push_back(tempo);
+                }
+            } else if (arg == "--raag" && i + 1 < argc) {
+                exportOptions.raag = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                exportOptions.threads = static_cast<unsigned>(parseIntOption(arg, argv[++i], 1, kMaxThreads));
+            } else if (arg == "--verify") {
+                exportOptions.verify = true;
+            } else if (parseRenderOption(argc, argv, i, options)) {
+                continue;
+            } else if (outputDir.empty()) {
+                outputDir = arg;
+            } else {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return 1;
+            }
+        }
+        if (outputDir.empty()) {
+            std::cerr << "Usage: Tansen export <dir> [--catalog path] [--tempos T1,T2...] [--raag NAME] [--threads N] [--verify] "
+                      << kRenderOptionsUsage << std::endl;
+            return 1;
+        }
+
+        try {
+            TaalManager taalManager;
+            MIDIHandler midiHandler;
+            taalManager.loadTaals(catalogPath);
+            CatalogExporter exporter(taalManager, midiHandler, options, exportOptions);
+            ExportReport report = exporter.run(outputDir);
+            for (const auto& error : report.errors) {
+                std::cerr << error << std::endl;
+            }
+            std::cout << "Exported " << report.entries << " tracks to " << outputDir << ": " << report.rendered
+                      << " rendered, " << report.unchanged << " unchanged, " << report.removed << " removed, "
+                      << report.failed << " failed in " << report.wallSeconds * 1000.0 << " ms" << std::endl;
+            return report.failed == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
     }
 
-    std::cout << "Available Taals:" << std::endl;
-    taalManager.listAllTaals();
+    // Tansen compile-catalog <taals.json> <catalog.bin>
+    int runCompileCatalog(int argc, char* argv[]) {
+        if (argc != 4) {
+            std::cerr << "Usage: Tansen compile-catalog <taals.json> <catalog.bin>" << std::endl;
+            return 1;
+        }
+        try {
+            BinaryCatalog::compile(argv[2], argv[3]);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Catalog compiled: " << argv[3] << std::endl;
+        return 0;
+    }
+
+    // Tansen import <file.mid|directory>... [--threads N] [--channel N|all] [--tolerance F]
+    //               [--system NAME] [--output catalog.json]
+    int runImport(int argc, char* argv[]) {
+        std::vector<std::string> inputs;
+        std::string system = "imported";
+        std::string outputPath;
+        unsigned threads = 0;
+        ImportOptions options;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = static_cast<unsigned>(parseIntOption(arg, argv[++i], 1, kMaxThreads));
+            } else if (arg == "--channel" && i + 1 < argc) {
+                std::string channel = argv[++i];
+                options.channel = channel == "all" ? -1 : parseIntOption(arg, channel, 0, 15);
+            } else if (arg == "--tolerance" && i + 1 < argc) {
+                options.tolerance = std::stod(argv[++i]);
+            } else if (arg == "--system" && i + 1 < argc) {
+                system = argv[++i];
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            } else {
+                inputs.push_back(arg);
+            }
+        }
+        if (inputs.empty()) {
+            std::cerr << "Usage: Tansen import <file.mid|directory>... [--threads N] [--channel N|all] [--tolerance F]"
+                         " [--system NAME] [--output catalog.json]" << std::endl;
+            return 1;
+        }
+
+        // Directories contribute their .mid/.midi files, in a stable order
+        std::vector<std::string> paths;
+        for (const auto& input : inputs) {
+            if (!std::filesystem::is_directory(input)) {
+                paths.push_back(input);
+                continue;
+            }
+            std::vector<std::string> found;
+            for (const auto& file : std::filesystem::recursive_directory_iterator(input)) {
+                std::string extension = file.path().extension().string();
+                if (file.is_regular_file() && (extension == ".mid" || extension == ".midi")) {
+                    found.push_back(file.path().string());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            paths.insert(paths.end(), found.begin(), found.end());
+        }
+
+        TaalImporter importer(options);
+        ImportReport report = importer.importFiles(paths, threads);
+        for (const auto& error : report.errors) {
+            std::cerr << error << std::endl;
+        }
+
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "  ";
+        std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+        Json::Value catalog = TaalImporter::toCatalog(report.taals, system);
+        if (outputPath.empty()) {
+            writer->write(catalog, &std::cout);
+            std::cout << std::endl;
+        } else {
+            std::ofstream output(outputPath);
+            writer->write(catalog, &output);
+            output << '\n';
+            if (!output) {
+                std::cerr << "Failed to write catalog: " << outputPath << std::endl;
+                return 1;
+            }
+        }
+        std::cerr << "Imported " << (report.files - report.failed) << "/" << report.files << " files as "
+                  << catalog[system].size() << " Taals in " << report.wallSeconds << " s ("
+                  << report.filesPerSecond << " files/sec)" << std::endl;
+        return report.failed == 0 ? 0 : 1;
+    }
+
+    // Tansen audio <taal> <tempo> <output.wav> [--raag NAME] [--catalog path] [--cycles N | --duration SECONDS]
+    //              [--laykari SEQ] [--velocity V] [--sam-velocity V] [--tanpura] [--lehra] [--tonic NOTE]
+    //              [--threads N] [--sample-rate HZ]
+    // The MIDI-only render options (--format, --tempo-error, --no-running-status) are accepted and have no effect
+    int runAudio(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::string raag;
+        std::vector<std::string> positional;
+        RenderOptions options;
+        AudioOptions audioOptions;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--raag" && i + 1 < argc) {
+                raag = argv[++i];
+            } else if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (parseRenderOption(argc, argv, i, options)) {
+                continue;
+            } else if (arg == "--threads" && i + 1 < argc) {
+                audioOptions.threads = static_cast<unsigned>(parseIntOption(arg, argv[++i], 1, kMaxThreads));
+            } else if (arg == "--sample-rate" && i + 1 < argc) {
+                audioOptions.sampleRate = static_cast<uint32_t>(parseIntOption(arg, argv[++i], 8000, 192000));
+            } else {
+                positional.push_back(arg);
+            }
+        }
+        if (positional.size() != 3) {
+            std::cerr << "Usage: Tansen audio <taal> <tempo> <output.wav> [--raag NAME] [--catalog path] [--cycles N | --duration SECONDS]"
+                         " [--laykari SEQ] [--velocity V] [--sam-velocity V] [--tanpura] [--lehra] [--tonic NOTE]"
+                         " [--threads N] [--sample-rate HZ]" << std::endl;
+            return 1;
+        }
+
+        try {
+            TaalManager taalManager;
+            MIDIHandler midiHandler;
+            taalManager.loadTaals(catalogPath);
+            const Taal& taal = taalManager.getTaal(positional[0]);
+            Tempo tempo = Tempo::fromName(positional[1]);
+            AudioRenderer renderer(midiHandler, audioOptions);
+            AudioReport report = renderer.writeTaalWAV(taal, tempo, raag, positional[2], options);
+            std::cout << "Rendered " << report.audioSeconds << " s of audio (" << report.voices << " notes) to "
+                      << positional[2] << " in " << report.wallSeconds << " s (" << report.realtimeFactor
+                      << "x real time)" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Tansen layer <taal> <taal>... <tempo> <output.mid> [--catalog path] [render options but --tanpura and --lehra]
+    int runLayer(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::vector<std::string> positional;
+        RenderOptions options;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (parseRenderOption(argc, argv, i, options)) {
+                continue;
+            } else {
+                positional.push_back(arg);
+            }
+        }
+        if (positional.size() < 4) {
+            std::cerr << "Usage: Tansen layer <taal> <taal>... <tempo> <output.mid> [--catalog path] " << kRenderOptionsUsage
+                      << std::endl;
+            return 1;
+        }
+        if (options.tanpura || options.lehra) {
+            std::cerr << "Layered Taals are rendered without a tanpura or lehra" << std::endl;
+            return 1;
+        }
+
+        try {
+            TaalManager taalManager;
+            MIDIHandler midiHandler;
+            taalManager.loadTaals(catalogPath);
+            std::vector<Taal> layers;
+            for (std::size_t i = 0; i + 2 < positional.size(); ++i) {
+                layers.push_back(taalManager.getTaal(positional[i]));
+            }
+            Tempo tempo = Tempo::fromName(positional[positional.size() - 2]);
+            const std::string& outputPath = positional.back();
+            LayerAlignment alignment = midiHandler.writeLayeredMIDI(layers, tempo, outputPath, options);
+
+            for (std::size_t i = 0; i < layers.size(); ++i) {
+                std::cout << (i == 0 ? "" : " + ") << layers[i].name << " x" << alignment.cyclesPerSuperCycle[i];
+            }
+            std::cout << " realign every " << alignment.superCycleBeats << " matras; " << alignment.superCycles
+                      << " super-cycle(s) written to " << outputPath << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Tansen compose <taal|--all> [--kind tihai|chakradar] [--laykari L] [--cycles N] [--count N] [--seed S]
+    //               [--catalog path] [--threads N] [--output out.mid [--tempo T] [--rank R]]
+    int runCompose(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::string taalName;
+        std::string outputPath;
+        std::string tempoName = "Madhya";
+        std::size_t rank = 1;
+        bool all = false;
+        unsigned threads = 0;
+        CompositionOptions options;
+        options.limit = 10;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--kind" && i + 1 < argc) {
+                std::string kind = argv[++i];
+                if (kind != "tihai" && kind != "chakradar") {
+                    std::cerr << "Unknown composition kind: " << kind << std::endl;
+                    return 1;
+                }
+                options.kind = kind == "tihai" ? CompositionKind::Tihai : CompositionKind::Chakradar;
+            } else if (arg == "--laykari" && i + 1 < argc) {
+                options.laykari = parseLaykari(argv[++i]);
+            } else if (arg == "--cycles" && i + 1 < argc) {
+                options.cycles = static_cast<unsigned>(
+                    parseIntOption(arg, argv[++i], 1, static_cast<int>(CompositionOptions::kMaxCycles)));
+            } else if (arg == "--count" && i + 1 < argc) {
+                options.limit = static_cast<std::size_t>(
+                    parseIntOption(arg, argv[++i], 1, static_cast<int>(CompositionOptions::kMaxLimit)));
+            } else if (arg == "--seed" && i + 1 < argc) {
+                options.seed = std::stoull(argv[++i]);
+            } else if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (arg == "--threads" && i + 1 < argc) {
+                threads = static_cast<unsigned>(parseIntOption(arg, argv[++i], 1, kMaxThreads));
+            } else if (arg == "--output" && i + 1 < argc) {
+                outputPath = argv[++i];
+            } else if (arg == "--tempo" && i + 1 < argc) {
+                tempoName = argv[++i];
+            } else if (arg == "--rank" && i + 1 < argc) {
+                rank = static_cast<std::size_t>(
+                    parseIntOption(arg, argv[++i], 1, static_cast<int>(CompositionOptions::kMaxLimit)));
+            } else if (arg == "--all") {
+                all = true;
+            } else if (taalName.empty()) {
+                taalName = arg;
+            } else {
+                std::cerr << "Unexpected argument: " << arg << std::endl;
+                return 1;
+            }
+        }
+        if (all == !taalName.empty() || (all && !outputPath.empty()) || rank == 0) {
+            std::cerr << "Usage: Tansen compose <taal|--all> [--kind tihai|chakradar] [--laykari L] [--cycles N] [--count N]"
+                         " [--seed S] [--catalog path] [--threads N] [--output out.mid [--tempo T] [--rank R]]" << std::endl;
+            return 1;
+        }
+
+        try {
+            TaalManager taalManager;
+            taalManager.loadTaals(catalogPath);
 
-    std::cout << "Enter your command (e.g., 'Raag Bhairavi Taal Keherwa Bilambit'): ";
-    std::string command;
-    std::getline(std::cin, command);
+            if (all) {
+                // Every Taal is composed independently, so the catalog spreads across the pool
+                using Clock = std::chrono::steady_clock;
+                std::vector<std::string> names = taalManager.listTaalNames();
+                std::vector<Taal> taals;
+                for (const auto& name : names) {
+                    taals.push_back(taalManager.getTaal(name));
+                }
+                std::vector<std::size_t> counts(taals.size(), 0);
+                std::vector<std::string> errors(taals.size());
+                Clock::time_point start = Clock::now();
+                {
+                    ThreadPool pool(threads);
+                    for (std::size_t index = 0; index < taals.size(); ++index) {
+                        pool.submit([&, index] {
+                            try {
+                                counts[index] = CompositionGenerator(taals[index], options).generate().size();
+                            } catch (const std::exception& e) {
+                                errors[index] = e.what();
+                            }
+                        });
+                    }
+                    pool.wait();
+                }
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count();
 
-    // Parse command (not shown for brevity) and generate MIDI
-    std::string raag = "Bhairavi";  // Extracted from command
-    std::string taalName = "Keherwa";  // Extracted from command
-    std::string tempoName = "Bilambit";  // Extracted from command
+                std::size_t total = 0;
+                for (std::size_t index = 0; index < taals.size(); ++index) {
+                    if (errors[index].empty()) {
+                        std::cout << names[index] << ": " << counts[index] << std::endl;
+                    } else {
+                        std::cerr << names[index] << ": " << errors[index] << std::endl;
+                    }
+                    total += counts[index];
+                }
+                std::cout << "Composed " << total << " compositions for " << taals.size() << " taals in " << seconds
+                          << " s" << std::endl;
+                return 0;
+            }
 
-    Tempo tempo(tempoName, (tempoName == "Bilambit" ? 60 : tempoName == "Madhya" ? 90 : 120));
-    try {
-        Taal taal = taalManager.getTaal(taalName);
-        midiHandler.generateTaalMIDI(taal, tempo, raag);
-    } catch (const std::exception& e) {
-        std::cerr << e.what() << std::endl;
+            const Taal& taal = taalManager.getTaal(taalName);
+            CompositionGenerator generator(taal, options);
+            std::vector<Composition> compositions = generator.generate();
+            for (std::size_t index = 0; index < compositions.size(); ++index) {
+                const Composition& composition = compositions[index];
+                std::cout << (index + 1) << ". [" << composition.score << "] from pulse " << composition.start
+                          << ", phrase " << composition.phrase << ", gap " << composition.gap << ": "
+                          << composition.text << std::endl;
+            }
+            if (!outputPath.empty()) {
+                if (rank > compositions.size()) {
+                    throw std::invalid_argument("No composition of rank " + std::to_string(rank));
+                }
+                RenderOptions renderOptions;
+                renderOptions.cycles = 1;
+                MIDIHandler midiHandler;
+                midiHandler.writeTaalMIDI(generator.arrange(compositions[rank - 1]), Tempo::fromName(tempoName), "",
+                                          outputPath, renderOptions);
+                std::cout << "MIDI file created: " << outputPath << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Tansen play <taal> <tempo> [--catalog path] [--sink spec] [--cycles N] [--laykari SEQ] [--realtime]
+    int runPlay(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::string sinkSpec = "log";
+        std::vector<std::string> positional;
+        PlaybackOptions options;
+
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (arg == "--sink" && i + 1 < argc) {
+                sinkSpec = argv[++i];
+            } else if (arg == "--cycles" && i + 1 < argc) {
+                options.cycles = static_cast<uint64_t>(
+                    parseIntOption(arg, argv[++i], 0, static_cast<int>(RenderOptions::kMaxCycles)));
+            } else if (arg == "--laykari" && i + 1 < argc) {
+                options.voicing.laykari = parseLaykariSequence(argv[++i]);
+            } else if (arg == "--realtime") {
+                options.realtimePriority = true;
+            } else {
+                positional.push_back(arg);
+            }
+        }
+        if (positional.size() != 2) {
+            std::cerr << "Usage: Tansen play <taal> <tempo> [--catalog path] [--sink log|log:file|fifo:path|rtmidi[:port]]"
+                         " [--cycles N] [--laykari SEQ] [--realtime]" << std::endl;
+            return 1;
+        }
+
+        try {
+            TaalManager taalManager;
+            taalManager.loadTaals(catalogPath);
+            const Taal& taal = taalManager.getTaal(positional[0]);
+            Tempo tempo = Tempo::fromName(positional[1]);
+
+            std::unique_ptr<MidiSink> sink = makeMidiSink(sinkSpec);
+            PlaybackScheduler scheduler(*sink, options);
+            activePlayback = &scheduler;
+            std::signal(SIGINT, stopPlayback);
+            scheduler.play(taal, tempo);
+            std::signal(SIGINT, SIG_DFL);
+            activePlayback = nullptr;
+
+            scheduler.jitter().print(std::cerr);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Tansen script <file|-> [--catalog path] [--check]
+    int runScript(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::string scriptPath;
+        bool checkOnly = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (arg == "--check") {
+                checkOnly = true;
+            } else if (scriptPath.empty()) {
+                scriptPath = arg;
+            }
+        }
+        if (scriptPath.empty()) {
+            std::cerr << "Usage: Tansen script <file|-> [--catalog path] [--check]" << std::endl;
+            return 1;
+        }
+
+        // A file is mapped and parsed in place; stdin is read whole first
+        std::unique_ptr<MappedFile> mapped;
+        std::string input;
+        std::string_view script;
+        if (scriptPath == "-") {
+            input.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+            script = input;
+        } else {
+            mapped = std::make_unique<MappedFile>(scriptPath);
+            script = std::string_view(reinterpret_cast<const char*>(mapped->data()), mapped->size());
+        }
+
+        TaalManager taalManager;
+        MIDIHandler midiHandler;
+        if (!checkOnly) {
+            taalManager.loadTaals(catalogPath);
+        }
+        CommandExecutor executor(taalManager, midiHandler, false);
+        CommandSyntax syntax;
+        Command command;
+        CommandResult result;
+        uint64_t commands = 0;
+        uint64_t failures = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t lineNumber = 0;
+        for (std::size_t begin = 0; begin < script.size();) {
+            std::size_t end = std::min(script.find('\n', begin), script.size());
+            std::string_view line = script.substr(begin, end - begin);
+            begin = end + 1;
+            ++lineNumber;
+            std::size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string_view::npos || line[first] == '#') {
+                continue; // Blank lines and comments
+            }
+
+            ++commands;
+            try {
+                parseCommandSyntax(line, syntax);
+                if (checkOnly) {
+                    continue;
+                }
+                // Each command sees the session state the previous ones left, e.g. set tempo
+                assignCommand(syntax, command);
+                executor.execute(command, result);
+                if (result.kind == CommandResult::Kind::File) {
+                    std::cout << "MIDI file generated: " << result.text << '\n';
+                } else {
+                    std::cout << result.text;
+                }
+            } catch (const std::exception& e) {
+                ++failures;
+                std::cerr << scriptPath << ":" << lineNumber << ": " << e.what() << '\n';
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout.flush();
+        std::cerr << (checkOnly ? "Checked " : "Ran ") << commands << " commands (" << failures << " failed) in "
+                  << seconds * 1000.0 << " ms, " << static_cast<uint64_t>(commands / std::max(seconds, 1e-9))
+                  << " commands/s" << std::endl;
+        return failures == 0 ? 0 : 1;
+    }
+
+    // Tansen serve <socket> [--catalog path] [--watch]
+    int runServe(int argc, char* argv[]) {
+        std::string catalogPath = "data/taals.json";
+        std::string socketPath;
+        bool watch = false;
+        for (int i = 2; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--catalog" && i + 1 < argc) {
+                catalogPath = argv[++i];
+            } else if (arg == "--watch") {
+                watch = true;
+            } else if (socketPath.empty()) {
+                socketPath = arg;
+            }
+        }
+        if (socketPath.empty()) {
+            std::cerr << "Usage: Tansen serve <socket> [--catalog path] [--watch]" << std::endl;
+            return 1;
+        }
+
+        // SIGINT/SIGTERM are taken by a dedicated thread, so stop() never runs in a signal handler
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        try {
+            TaalManager taalManager;
+            MIDIHandler midiHandler;
+            taalManager.loadTaals(catalogPath);
+            std::unique_ptr<CatalogWatcher> watcher;
+            if (watch) {
+                watcher = std::make_unique<CatalogWatcher>(taalManager, catalogPath, std::cerr);
+            }
+
+            RenderServer server(taalManager, midiHandler, socketPath);
+            std::thread signalWaiter([&] {
+                int signal = 0;
+                sigwait(&signals, &signal);
+                server.stop();
+            });
+
+            std::cout << "Serving on " << socketPath << std::endl;
+            try {
+                server.run();
+            } catch (...) {
+                pthread_kill(signalWaiter.native_handle(), SIGTERM);
+                signalWaiter.join();
+                throw;
+            }
+            signalWaiter.join();
+
+            std::cout << "Served " << server.latency().count() << " requests (p50 "
+                      << server.latency().percentile(50.0) * 1000.0 << " us, p99 "
+                      << server.latency().percentile(99.0) * 1000.0 << " us)" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // --stats and --trace=file.json may appear anywhere; they are removed before dispatch
+    struct ProfilingFlags {
+        bool stats = false;
+        std::string tracePath;
+    };
+
+    ProfilingFlags extractProfilingFlags(int& argc, char* argv[]) {
+        ProfilingFlags flags;
+        int kept = 1;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--stats") {
+                flags.stats = true;
+            } else if (arg.rfind("--trace=", 0) == 0) {
+                flags.tracePath = arg.substr(8);
+            } else {
+                argv[kept++] = argv[i];
+            }
+        }
+        argc = kept;
+        argv[argc] = nullptr;
+        return flags;
+    }
+
+    bool reportProfile(const ProfilingFlags& flags) {
+#ifdef TANSEN_ENABLE_PROFILING
+        if (flags.stats) {
+            Profiler::instance().printStats(std::cerr);
+        }
+        if (!flags.tracePath.empty()) {
+            std::ofstream trace(flags.tracePath);
+            Profiler::instance().writeChromeTrace(trace);
+            if (!trace) {
+                std::cerr << "Failed to write trace: " << flags.tracePath << std::endl;
+                return false;
+            }
+        }
+        return true;
+#else
+        (void)flags;
+        return true;
+#endif
+    }
+
+    int dispatch(int argc, char* argv[]) {
+        if (argc > 1) {
+            // Subcommands; bad option values (e.g. a non-numeric --threads) land in the catch
+            std::string subcommand = argv[1];
+            try {
+                if (subcommand == "batch") {
+                    return runBatch(argc, argv);
+                }
+                if (subcommand == "export") {
+                    return runExport(argc, argv);
+                }
+                if (subcommand == "compile-catalog") {
+                    return runCompileCatalog(argc, argv);
+                }
+                if (subcommand == "audio") {
+                    return runAudio(argc, argv);
+                }
+                if (subcommand == "layer") {
+                    return runLayer(argc, argv);
+                }
+                if (subcommand == "compose") {
+                    return runCompose(argc, argv);
+                }
+                if (subcommand == "import") {
+                    return runImport(argc, argv);
+                }
+                if (subcommand == "play") {
+                    return runPlay(argc, argv);
+                }
+                if (subcommand == "script") {
+                    return runScript(argc, argv);
+                }
+                if (subcommand == "serve") {
+                    return runServe(argc, argv);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        }
+
+        TaalManager taalManager;
+        MIDIHandler midiHandler;
+
+        try {
+            taalManager.loadTaals("data/taals.json");
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        std::cout << "Available Taals:" << std::endl;
+        taalManager.listAllTaals();
+
+        std::cout << "Enter your command (e.g., 'Raag Bhairavi Taal Keherwa Bilambit'): ";
+        std::string line;
+        std::getline(std::cin, line);
+
+        try {
+            CommandExecutor executor(taalManager, midiHandler, false);
+            CommandResult result = executor.execute(parseCommand(line));
+            if (result.kind == CommandResult::Kind::File) {
+                std::cout << "MIDI file generated: " << result.text << std::endl;
+            } else {
+                std::cout << result.text;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    ProfilingFlags flags = extractProfilingFlags(argc, argv);
+#ifndef TANSEN_ENABLE_PROFILING
+    if (flags.stats || !flags.tracePath.empty()) {
+        std::cerr << "--stats and --trace need a build configured with -DTANSEN_ENABLE_PROFILING=ON" << std::endl;
         return 1;
     }
+#endif
 
-    std::cout << "MIDI file generated successfully!" << std::endl;
-    return 0;
+    int status = dispatch(argc, argv);
+    if (!reportProfile(flags)) {
+        return 1;
+    }
+    return status;
 }
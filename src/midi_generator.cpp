@@ -13,8 +13,9 @@ void MIDIGenerator::generateMIDI(const Taal &taal, const std::string &filename)
     midiFile << "MTrk";
 
     // Generate notes from Taal
-    for (const auto &bol : taal.bols) {
-        int pitch = getMIDIPitch(bol);
+    const BolTable &bolTable = BolTable::instance();
+    for (BolId bol : taal.getBols()) {
+        int pitch = getMIDIPitch(bolTable.name(bol));
         midiFile.put(pitch);
         midiFile.put(0x90);  // Note On
         midiFile.put(pitch);
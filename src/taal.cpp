@@ -5,7 +5,13 @@
 
 // Taal Class Implementation
 Taal::Taal(const std::string& name, int beats, const std::vector<std::string>& bols)
-    : name(name), beats(beats), bols(bols) {}
+    : name(name), beats(beats) {
+    BolTable& bolTable = BolTable::instance();
+    this->bols.reserve(bols.size());
+    for (const auto& bol : bols) {
+        this->bols.push_back(bolTable.intern(bol));
+    }
+}
 
 std::string Taal::getName() const {
     return name;
@@ -15,7 +21,7 @@ int Taal::getBeats() const {
     return beats;
 }
 
-std::vector<std::string> Taal::getBols() const {
+const std::vector<BolId>& Taal::getBols() const {
     return bols;
 }
 
@@ -38,7 +44,7 @@ Taal* TaalManager::getTaal(const std::string& name) {
     return (it != tals.end()) ? &(it->second) : nullptr;
 }
 
-std::unordered_map<std::string, Taal> TaalManager::getAllTals() const {
+const std::unordered_map<std::string, Taal>& TaalManager::getAllTals() const {
     return tals;
 }
 
@@ -60,11 +66,16 @@ void TaalManager::loadTalsFromJson(const std::string& filepath) {
 
 void TaalManager::saveTalsToJson(const std::string& filepath) const {
     nlohmann::json jsonData;
+    const BolTable& bolTable = BolTable::instance();
 
     for (const auto& [name, taal] : tals) {
+        std::vector<std::string> bols;
+        for (BolId bol : taal.getBols()) {
+            bols.push_back(bolTable.name(bol));
+        }
         jsonData["Custom"].push_back({
             {"name", taal.getName()},
-            {"beats", taal.getBols()}
+            {"beats", bols}
         });
     }
 